@@ -18,12 +18,17 @@
 
 #include <ostream>
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <limits>
+#include <initializer_list>
 
 #include <cassert>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <cstdio>
+#include <cerrno>
 
 /*************************************************************************************************/
 
@@ -40,6 +45,7 @@
 #   define __FJ__FALLTHROUGH [[fallthrough]]
 #   define __FJ__CONSTEXPR_IF(...) if constexpr (__VA_ARGS__)
 #   include <string_view>
+#   include <optional>
     namespace flatjson {
         using string_view = std::string_view;
     } // ns flatjson
@@ -65,6 +71,18 @@
 #ifndef FJ_CHILDS_TYPE
 #   define FJ_CHILDS_TYPE std::uint16_t
 #endif // FJ_CHILDS_TYPE
+#ifndef FJ_INDEX_THRESHOLD
+#   define FJ_INDEX_THRESHOLD 32
+#endif // FJ_INDEX_THRESHOLD
+#ifndef FJ_DIFF_LCS_LIMIT
+#   define FJ_DIFF_LCS_LIMIT 512
+#endif // FJ_DIFF_LCS_LIMIT
+#ifdef __FJ__EXTRACT_ARRAY_THREADS
+#   ifndef FJ_EXTRACT_ARRAY_MT_CHUNK
+#       define FJ_EXTRACT_ARRAY_MT_CHUNK 65536
+#   endif // FJ_EXTRACT_ARRAY_MT_CHUNK
+#   include <thread>
+#endif // __FJ__EXTRACT_ARRAY_THREADS
 
 /*************************************************************************************************/
 
@@ -199,6 +217,10 @@ enum error_code: int {
     ,FJ_EC_KLEN_OVERFLOW = -4
     ,FJ_EC_VLEN_OVERFLOW = -5
     ,FJ_EC_CHILDS_OVERFLOW = -6
+    ,FJ_EC_NOT_CONVERTIBLE = -7
+    ,FJ_EC_VALUE_OVERFLOW = -8
+    ,FJ_EC_NOT_FOUND = -9
+    ,FJ_EC_TEST_FAILED = -10
 };
 
 inline const char* error_string(error_code e) {
@@ -210,6 +232,10 @@ inline const char* error_string(error_code e) {
         ,"KLEN_OVERFLOW"
         ,"VLEN_OVERFLOW"
         ,"CHILDS_OVERFLOW"
+        ,"NOT_CONVERTIBLE"
+        ,"VALUE_OVERFLOW"
+        ,"NOT_FOUND"
+        ,"TEST_FAILED"
     };
     auto idx = static_cast<std::int8_t>(e);
     idx = -idx;
@@ -325,1717 +351,7221 @@ conv_to(const char *ptr, std::size_t len, To) {
     return *ptr == 't' && len == 4;
 }
 
-template<typename To>
-typename std::enable_if<std::is_same<To, double>::value, To>::type
-conv_to(const char *ptr, std::size_t len, To) {
-    char buf[std::numeric_limits<To>::max_exponent10 + 20];
-    std::memcpy(buf, ptr, len);
-    buf[len] = 0;
-
-    return std::strtod(buf, nullptr);
-}
-
-template<typename To>
-typename std::enable_if<std::is_same<To, float>::value, To>::type
-conv_to(const char *ptr, std::size_t len, To) {
-    char buf[std::numeric_limits<To>::max_exponent10 + 20];
-    std::memcpy(buf, ptr, len);
-    buf[len] = 0;
+/*************************************************************************************************/
+// the decimal to binary floating point conversion using the Eisel-Lemire algorithm,
+// see "Number Parsing at a Gigabyte per Second" by Daniel Lemire.
+
+// the 128-bit truncated approximations of 5^q for q in [-342..308]
+inline const std::uint64_t* pow5_128(std::int64_t q) {
+    static constexpr std::uint64_t table[] = {
+         0xeef453d6923bd65aull,0x113faa2906a13b3full
+        ,0x9558b4661b6565f8ull,0x4ac7ca59a424c507ull
+        ,0xbaaee17fa23ebf76ull,0x5d79bcf00d2df649ull
+        ,0xe95a99df8ace6f53ull,0xf4d82c2c107973dcull
+        ,0x91d8a02bb6c10594ull,0x79071b9b8a4be869ull
+        ,0xb64ec836a47146f9ull,0x9748e2826cdee284ull
+        ,0xe3e27a444d8d98b7ull,0xfd1b1b2308169b25ull
+        ,0x8e6d8c6ab0787f72ull,0xfe30f0f5e50e20f7ull
+        ,0xb208ef855c969f4full,0xbdbd2d335e51a935ull
+        ,0xde8b2b66b3bc4723ull,0xad2c788035e61382ull
+        ,0x8b16fb203055ac76ull,0x4c3bcb5021afcc31ull
+        ,0xaddcb9e83c6b1793ull,0xdf4abe242a1bbf3dull
+        ,0xd953e8624b85dd78ull,0xd71d6dad34a2af0dull
+        ,0x87d4713d6f33aa6bull,0x8672648c40e5ad68ull
+        ,0xa9c98d8ccb009506ull,0x680efdaf511f18c2ull
+        ,0xd43bf0effdc0ba48ull,0x0212bd1b2566def2ull
+        ,0x84a57695fe98746dull,0x014bb630f7604b57ull
+        ,0xa5ced43b7e3e9188ull,0x419ea3bd35385e2dull
+        ,0xcf42894a5dce35eaull,0x52064cac828675b9ull
+        ,0x818995ce7aa0e1b2ull,0x7343efebd1940993ull
+        ,0xa1ebfb4219491a1full,0x1014ebe6c5f90bf8ull
+        ,0xca66fa129f9b60a6ull,0xd41a26e077774ef6ull
+        ,0xfd00b897478238d0ull,0x8920b098955522b4ull
+        ,0x9e20735e8cb16382ull,0x55b46e5f5d5535b0ull
+        ,0xc5a890362fddbc62ull,0xeb2189f734aa831dull
+        ,0xf712b443bbd52b7bull,0xa5e9ec7501d523e4ull
+        ,0x9a6bb0aa55653b2dull,0x47b233c92125366eull
+        ,0xc1069cd4eabe89f8ull,0x999ec0bb696e840aull
+        ,0xf148440a256e2c76ull,0xc00670ea43ca250dull
+        ,0x96cd2a865764dbcaull,0x380406926a5e5728ull
+        ,0xbc807527ed3e12bcull,0xc605083704f5ecf2ull
+        ,0xeba09271e88d976bull,0xf7864a44c633682eull
+        ,0x93445b8731587ea3ull,0x7ab3ee6afbe0211dull
+        ,0xb8157268fdae9e4cull,0x5960ea05bad82964ull
+        ,0xe61acf033d1a45dfull,0x6fb92487298e33bdull
+        ,0x8fd0c16206306babull,0xa5d3b6d479f8e056ull
+        ,0xb3c4f1ba87bc8696ull,0x8f48a4899877186cull
+        ,0xe0b62e2929aba83cull,0x331acdabfe94de87ull
+        ,0x8c71dcd9ba0b4925ull,0x9ff0c08b7f1d0b14ull
+        ,0xaf8e5410288e1b6full,0x07ecf0ae5ee44dd9ull
+        ,0xdb71e91432b1a24aull,0xc9e82cd9f69d6150ull
+        ,0x892731ac9faf056eull,0xbe311c083a225cd2ull
+        ,0xab70fe17c79ac6caull,0x6dbd630a48aaf406ull
+        ,0xd64d3d9db981787dull,0x092cbbccdad5b108ull
+        ,0x85f0468293f0eb4eull,0x25bbf56008c58ea5ull
+        ,0xa76c582338ed2621ull,0xaf2af2b80af6f24eull
+        ,0xd1476e2c07286faaull,0x1af5af660db4aee1ull
+        ,0x82cca4db847945caull,0x50d98d9fc890ed4dull
+        ,0xa37fce126597973cull,0xe50ff107bab528a0ull
+        ,0xcc5fc196fefd7d0cull,0x1e53ed49a96272c8ull
+        ,0xff77b1fcbebcdc4full,0x25e8e89c13bb0f7aull
+        ,0x9faacf3df73609b1ull,0x77b191618c54e9acull
+        ,0xc795830d75038c1dull,0xd59df5b9ef6a2417ull
+        ,0xf97ae3d0d2446f25ull,0x4b0573286b44ad1dull
+        ,0x9becce62836ac577ull,0x4ee367f9430aec32ull
+        ,0xc2e801fb244576d5ull,0x229c41f793cda73full
+        ,0xf3a20279ed56d48aull,0x6b43527578c1110full
+        ,0x9845418c345644d6ull,0x830a13896b78aaa9ull
+        ,0xbe5691ef416bd60cull,0x23cc986bc656d553ull
+        ,0xedec366b11c6cb8full,0x2cbfbe86b7ec8aa8ull
+        ,0x94b3a202eb1c3f39ull,0x7bf7d71432f3d6a9ull
+        ,0xb9e08a83a5e34f07ull,0xdaf5ccd93fb0cc53ull
+        ,0xe858ad248f5c22c9ull,0xd1b3400f8f9cff68ull
+        ,0x91376c36d99995beull,0x23100809b9c21fa1ull
+        ,0xb58547448ffffb2dull,0xabd40a0c2832a78aull
+        ,0xe2e69915b3fff9f9ull,0x16c90c8f323f516cull
+        ,0x8dd01fad907ffc3bull,0xae3da7d97f6792e3ull
+        ,0xb1442798f49ffb4aull,0x99cd11cfdf41779cull
+        ,0xdd95317f31c7fa1dull,0x40405643d711d583ull
+        ,0x8a7d3eef7f1cfc52ull,0x482835ea666b2572ull
+        ,0xad1c8eab5ee43b66ull,0xda3243650005eecfull
+        ,0xd863b256369d4a40ull,0x90bed43e40076a82ull
+        ,0x873e4f75e2224e68ull,0x5a7744a6e804a291ull
+        ,0xa90de3535aaae202ull,0x711515d0a205cb36ull
+        ,0xd3515c2831559a83ull,0x0d5a5b44ca873e03ull
+        ,0x8412d9991ed58091ull,0xe858790afe9486c2ull
+        ,0xa5178fff668ae0b6ull,0x626e974dbe39a872ull
+        ,0xce5d73ff402d98e3ull,0xfb0a3d212dc8128full
+        ,0x80fa687f881c7f8eull,0x7ce66634bc9d0b99ull
+        ,0xa139029f6a239f72ull,0x1c1fffc1ebc44e80ull
+        ,0xc987434744ac874eull,0xa327ffb266b56220ull
+        ,0xfbe9141915d7a922ull,0x4bf1ff9f0062baa8ull
+        ,0x9d71ac8fada6c9b5ull,0x6f773fc3603db4a9ull
+        ,0xc4ce17b399107c22ull,0xcb550fb4384d21d3ull
+        ,0xf6019da07f549b2bull,0x7e2a53a146606a48ull
+        ,0x99c102844f94e0fbull,0x2eda7444cbfc426dull
+        ,0xc0314325637a1939ull,0xfa911155fefb5308ull
+        ,0xf03d93eebc589f88ull,0x793555ab7eba27caull
+        ,0x96267c7535b763b5ull,0x4bc1558b2f3458deull
+        ,0xbbb01b9283253ca2ull,0x9eb1aaedfb016f16ull
+        ,0xea9c227723ee8bcbull,0x465e15a979c1cadcull
+        ,0x92a1958a7675175full,0x0bfacd89ec191ec9ull
+        ,0xb749faed14125d36ull,0xcef980ec671f667bull
+        ,0xe51c79a85916f484ull,0x82b7e12780e7401aull
+        ,0x8f31cc0937ae58d2ull,0xd1b2ecb8b0908810ull
+        ,0xb2fe3f0b8599ef07ull,0x861fa7e6dcb4aa15ull
+        ,0xdfbdcece67006ac9ull,0x67a791e093e1d49aull
+        ,0x8bd6a141006042bdull,0xe0c8bb2c5c6d24e0ull
+        ,0xaecc49914078536dull,0x58fae9f773886e18ull
+        ,0xda7f5bf590966848ull,0xaf39a475506a899eull
+        ,0x888f99797a5e012dull,0x6d8406c952429603ull
+        ,0xaab37fd7d8f58178ull,0xc8e5087ba6d33b83ull
+        ,0xd5605fcdcf32e1d6ull,0xfb1e4a9a90880a64ull
+        ,0x855c3be0a17fcd26ull,0x5cf2eea09a55067full
+        ,0xa6b34ad8c9dfc06full,0xf42faa48c0ea481eull
+        ,0xd0601d8efc57b08bull,0xf13b94daf124da26ull
+        ,0x823c12795db6ce57ull,0x76c53d08d6b70858ull
+        ,0xa2cb1717b52481edull,0x54768c4b0c64ca6eull
+        ,0xcb7ddcdda26da268ull,0xa9942f5dcf7dfd09ull
+        ,0xfe5d54150b090b02ull,0xd3f93b35435d7c4cull
+        ,0x9efa548d26e5a6e1ull,0xc47bc5014a1a6dafull
+        ,0xc6b8e9b0709f109aull,0x359ab6419ca1091bull
+        ,0xf867241c8cc6d4c0ull,0xc30163d203c94b62ull
+        ,0x9b407691d7fc44f8ull,0x79e0de63425dcf1dull
+        ,0xc21094364dfb5636ull,0x985915fc12f542e4ull
+        ,0xf294b943e17a2bc4ull,0x3e6f5b7b17b2939dull
+        ,0x979cf3ca6cec5b5aull,0xa705992ceecf9c42ull
+        ,0xbd8430bd08277231ull,0x50c6ff782a838353ull
+        ,0xece53cec4a314ebdull,0xa4f8bf5635246428ull
+        ,0x940f4613ae5ed136ull,0x871b7795e136be99ull
+        ,0xb913179899f68584ull,0x28e2557b59846e3full
+        ,0xe757dd7ec07426e5ull,0x331aeada2fe589cfull
+        ,0x9096ea6f3848984full,0x3ff0d2c85def7621ull
+        ,0xb4bca50b065abe63ull,0x0fed077a756b53a9ull
+        ,0xe1ebce4dc7f16dfbull,0xd3e8495912c62894ull
+        ,0x8d3360f09cf6e4bdull,0x64712dd7abbbd95cull
+        ,0xb080392cc4349decull,0xbd8d794d96aacfb3ull
+        ,0xdca04777f541c567ull,0xecf0d7a0fc5583a0ull
+        ,0x89e42caaf9491b60ull,0xf41686c49db57244ull
+        ,0xac5d37d5b79b6239ull,0x311c2875c522ced5ull
+        ,0xd77485cb25823ac7ull,0x7d633293366b828bull
+        ,0x86a8d39ef77164bcull,0xae5dff9c02033197ull
+        ,0xa8530886b54dbdebull,0xd9f57f830283fdfcull
+        ,0xd267caa862a12d66ull,0xd072df63c324fd7bull
+        ,0x8380dea93da4bc60ull,0x4247cb9e59f71e6dull
+        ,0xa46116538d0deb78ull,0x52d9be85f074e608ull
+        ,0xcd795be870516656ull,0x67902e276c921f8bull
+        ,0x806bd9714632dff6ull,0x00ba1cd8a3db53b6ull
+        ,0xa086cfcd97bf97f3ull,0x80e8a40eccd228a4ull
+        ,0xc8a883c0fdaf7df0ull,0x6122cd128006b2cdull
+        ,0xfad2a4b13d1b5d6cull,0x796b805720085f81ull
+        ,0x9cc3a6eec6311a63ull,0xcbe3303674053bb0ull
+        ,0xc3f490aa77bd60fcull,0xbedbfc4411068a9cull
+        ,0xf4f1b4d515acb93bull,0xee92fb5515482d44ull
+        ,0x991711052d8bf3c5ull,0x751bdd152d4d1c4aull
+        ,0xbf5cd54678eef0b6ull,0xd262d45a78a0635dull
+        ,0xef340a98172aace4ull,0x86fb897116c87c34ull
+        ,0x9580869f0e7aac0eull,0xd45d35e6ae3d4da0ull
+        ,0xbae0a846d2195712ull,0x8974836059cca109ull
+        ,0xe998d258869facd7ull,0x2bd1a438703fc94bull
+        ,0x91ff83775423cc06ull,0x7b6306a34627ddcfull
+        ,0xb67f6455292cbf08ull,0x1a3bc84c17b1d542ull
+        ,0xe41f3d6a7377eecaull,0x20caba5f1d9e4a93ull
+        ,0x8e938662882af53eull,0x547eb47b7282ee9cull
+        ,0xb23867fb2a35b28dull,0xe99e619a4f23aa43ull
+        ,0xdec681f9f4c31f31ull,0x6405fa00e2ec94d4ull
+        ,0x8b3c113c38f9f37eull,0xde83bc408dd3dd04ull
+        ,0xae0b158b4738705eull,0x9624ab50b148d445ull
+        ,0xd98ddaee19068c76ull,0x3badd624dd9b0957ull
+        ,0x87f8a8d4cfa417c9ull,0xe54ca5d70a80e5d6ull
+        ,0xa9f6d30a038d1dbcull,0x5e9fcf4ccd211f4cull
+        ,0xd47487cc8470652bull,0x7647c3200069671full
+        ,0x84c8d4dfd2c63f3bull,0x29ecd9f40041e073ull
+        ,0xa5fb0a17c777cf09ull,0xf468107100525890ull
+        ,0xcf79cc9db955c2ccull,0x7182148d4066eeb4ull
+        ,0x81ac1fe293d599bfull,0xc6f14cd848405530ull
+        ,0xa21727db38cb002full,0xb8ada00e5a506a7cull
+        ,0xca9cf1d206fdc03bull,0xa6d90811f0e4851cull
+        ,0xfd442e4688bd304aull,0x908f4a166d1da663ull
+        ,0x9e4a9cec15763e2eull,0x9a598e4e043287feull
+        ,0xc5dd44271ad3cdbaull,0x40eff1e1853f29fdull
+        ,0xf7549530e188c128ull,0xd12bee59e68ef47cull
+        ,0x9a94dd3e8cf578b9ull,0x82bb74f8301958ceull
+        ,0xc13a148e3032d6e7ull,0xe36a52363c1faf01ull
+        ,0xf18899b1bc3f8ca1ull,0xdc44e6c3cb279ac1ull
+        ,0x96f5600f15a7b7e5ull,0x29ab103a5ef8c0b9ull
+        ,0xbcb2b812db11a5deull,0x7415d448f6b6f0e7ull
+        ,0xebdf661791d60f56ull,0x111b495b3464ad21ull
+        ,0x936b9fcebb25c995ull,0xcab10dd900beec34ull
+        ,0xb84687c269ef3bfbull,0x3d5d514f40eea742ull
+        ,0xe65829b3046b0afaull,0x0cb4a5a3112a5112ull
+        ,0x8ff71a0fe2c2e6dcull,0x47f0e785eaba72abull
+        ,0xb3f4e093db73a093ull,0x59ed216765690f56ull
+        ,0xe0f218b8d25088b8ull,0x306869c13ec3532cull
+        ,0x8c974f7383725573ull,0x1e414218c73a13fbull
+        ,0xafbd2350644eeacfull,0xe5d1929ef90898faull
+        ,0xdbac6c247d62a583ull,0xdf45f746b74abf39ull
+        ,0x894bc396ce5da772ull,0x6b8bba8c328eb783ull
+        ,0xab9eb47c81f5114full,0x066ea92f3f326564ull
+        ,0xd686619ba27255a2ull,0xc80a537b0efefebdull
+        ,0x8613fd0145877585ull,0xbd06742ce95f5f36ull
+        ,0xa798fc4196e952e7ull,0x2c48113823b73704ull
+        ,0xd17f3b51fca3a7a0ull,0xf75a15862ca504c5ull
+        ,0x82ef85133de648c4ull,0x9a984d73dbe722fbull
+        ,0xa3ab66580d5fdaf5ull,0xc13e60d0d2e0ebbaull
+        ,0xcc963fee10b7d1b3ull,0x318df905079926a8ull
+        ,0xffbbcfe994e5c61full,0xfdf17746497f7052ull
+        ,0x9fd561f1fd0f9bd3ull,0xfeb6ea8bedefa633ull
+        ,0xc7caba6e7c5382c8ull,0xfe64a52ee96b8fc0ull
+        ,0xf9bd690a1b68637bull,0x3dfdce7aa3c673b0ull
+        ,0x9c1661a651213e2dull,0x06bea10ca65c084eull
+        ,0xc31bfa0fe5698db8ull,0x486e494fcff30a62ull
+        ,0xf3e2f893dec3f126ull,0x5a89dba3c3efccfaull
+        ,0x986ddb5c6b3a76b7ull,0xf89629465a75e01cull
+        ,0xbe89523386091465ull,0xf6bbb397f1135823ull
+        ,0xee2ba6c0678b597full,0x746aa07ded582e2cull
+        ,0x94db483840b717efull,0xa8c2a44eb4571cdcull
+        ,0xba121a4650e4ddebull,0x92f34d62616ce413ull
+        ,0xe896a0d7e51e1566ull,0x77b020baf9c81d17ull
+        ,0x915e2486ef32cd60ull,0x0ace1474dc1d122eull
+        ,0xb5b5ada8aaff80b8ull,0x0d819992132456baull
+        ,0xe3231912d5bf60e6ull,0x10e1fff697ed6c69ull
+        ,0x8df5efabc5979c8full,0xca8d3ffa1ef463c1ull
+        ,0xb1736b96b6fd83b3ull,0xbd308ff8a6b17cb2ull
+        ,0xddd0467c64bce4a0ull,0xac7cb3f6d05ddbdeull
+        ,0x8aa22c0dbef60ee4ull,0x6bcdf07a423aa96bull
+        ,0xad4ab7112eb3929dull,0x86c16c98d2c953c6ull
+        ,0xd89d64d57a607744ull,0xe871c7bf077ba8b7ull
+        ,0x87625f056c7c4a8bull,0x11471cd764ad4972ull
+        ,0xa93af6c6c79b5d2dull,0xd598e40d3dd89bcfull
+        ,0xd389b47879823479ull,0x4aff1d108d4ec2c3ull
+        ,0x843610cb4bf160cbull,0xcedf722a585139baull
+        ,0xa54394fe1eedb8feull,0xc2974eb4ee658828ull
+        ,0xce947a3da6a9273eull,0x733d226229feea32ull
+        ,0x811ccc668829b887ull,0x0806357d5a3f525full
+        ,0xa163ff802a3426a8ull,0xca07c2dcb0cf26f7ull
+        ,0xc9bcff6034c13052ull,0xfc89b393dd02f0b5ull
+        ,0xfc2c3f3841f17c67ull,0xbbac2078d443ace2ull
+        ,0x9d9ba7832936edc0ull,0xd54b944b84aa4c0dull
+        ,0xc5029163f384a931ull,0x0a9e795e65d4df11ull
+        ,0xf64335bcf065d37dull,0x4d4617b5ff4a16d5ull
+        ,0x99ea0196163fa42eull,0x504bced1bf8e4e45ull
+        ,0xc06481fb9bcf8d39ull,0xe45ec2862f71e1d6ull
+        ,0xf07da27a82c37088ull,0x5d767327bb4e5a4cull
+        ,0x964e858c91ba2655ull,0x3a6a07f8d510f86full
+        ,0xbbe226efb628afeaull,0x890489f70a55368bull
+        ,0xeadab0aba3b2dbe5ull,0x2b45ac74ccea842eull
+        ,0x92c8ae6b464fc96full,0x3b0b8bc90012929dull
+        ,0xb77ada0617e3bbcbull,0x09ce6ebb40173744ull
+        ,0xe55990879ddcaabdull,0xcc420a6a101d0515ull
+        ,0x8f57fa54c2a9eab6ull,0x9fa946824a12232dull
+        ,0xb32df8e9f3546564ull,0x47939822dc96abf9ull
+        ,0xdff9772470297ebdull,0x59787e2b93bc56f7ull
+        ,0x8bfbea76c619ef36ull,0x57eb4edb3c55b65aull
+        ,0xaefae51477a06b03ull,0xede622920b6b23f1ull
+        ,0xdab99e59958885c4ull,0xe95fab368e45ecedull
+        ,0x88b402f7fd75539bull,0x11dbcb0218ebb414ull
+        ,0xaae103b5fcd2a881ull,0xd652bdc29f26a119ull
+        ,0xd59944a37c0752a2ull,0x4be76d3346f0495full
+        ,0x857fcae62d8493a5ull,0x6f70a4400c562ddbull
+        ,0xa6dfbd9fb8e5b88eull,0xcb4ccd500f6bb952ull
+        ,0xd097ad07a71f26b2ull,0x7e2000a41346a7a7ull
+        ,0x825ecc24c873782full,0x8ed400668c0c28c8ull
+        ,0xa2f67f2dfa90563bull,0x728900802f0f32faull
+        ,0xcbb41ef979346bcaull,0x4f2b40a03ad2ffb9ull
+        ,0xfea126b7d78186bcull,0xe2f610c84987bfa8ull
+        ,0x9f24b832e6b0f436ull,0x0dd9ca7d2df4d7c9ull
+        ,0xc6ede63fa05d3143ull,0x91503d1c79720dbbull
+        ,0xf8a95fcf88747d94ull,0x75a44c6397ce912aull
+        ,0x9b69dbe1b548ce7cull,0xc986afbe3ee11abaull
+        ,0xc24452da229b021bull,0xfbe85badce996168ull
+        ,0xf2d56790ab41c2a2ull,0xfae27299423fb9c3ull
+        ,0x97c560ba6b0919a5ull,0xdccd879fc967d41aull
+        ,0xbdb6b8e905cb600full,0x5400e987bbc1c920ull
+        ,0xed246723473e3813ull,0x290123e9aab23b68ull
+        ,0x9436c0760c86e30bull,0xf9a0b6720aaf6521ull
+        ,0xb94470938fa89bceull,0xf808e40e8d5b3e69ull
+        ,0xe7958cb87392c2c2ull,0xb60b1d1230b20e04ull
+        ,0x90bd77f3483bb9b9ull,0xb1c6f22b5e6f48c2ull
+        ,0xb4ecd5f01a4aa828ull,0x1e38aeb6360b1af3ull
+        ,0xe2280b6c20dd5232ull,0x25c6da63c38de1b0ull
+        ,0x8d590723948a535full,0x579c487e5a38ad0eull
+        ,0xb0af48ec79ace837ull,0x2d835a9df0c6d851ull
+        ,0xdcdb1b2798182244ull,0xf8e431456cf88e65ull
+        ,0x8a08f0f8bf0f156bull,0x1b8e9ecb641b58ffull
+        ,0xac8b2d36eed2dac5ull,0xe272467e3d222f3full
+        ,0xd7adf884aa879177ull,0x5b0ed81dcc6abb0full
+        ,0x86ccbb52ea94baeaull,0x98e947129fc2b4e9ull
+        ,0xa87fea27a539e9a5ull,0x3f2398d747b36224ull
+        ,0xd29fe4b18e88640eull,0x8eec7f0d19a03aadull
+        ,0x83a3eeeef9153e89ull,0x1953cf68300424acull
+        ,0xa48ceaaab75a8e2bull,0x5fa8c3423c052dd7ull
+        ,0xcdb02555653131b6ull,0x3792f412cb06794dull
+        ,0x808e17555f3ebf11ull,0xe2bbd88bbee40bd0ull
+        ,0xa0b19d2ab70e6ed6ull,0x5b6aceaeae9d0ec4ull
+        ,0xc8de047564d20a8bull,0xf245825a5a445275ull
+        ,0xfb158592be068d2eull,0xeed6e2f0f0d56712ull
+        ,0x9ced737bb6c4183dull,0x55464dd69685606bull
+        ,0xc428d05aa4751e4cull,0xaa97e14c3c26b886ull
+        ,0xf53304714d9265dfull,0xd53dd99f4b3066a8ull
+        ,0x993fe2c6d07b7fabull,0xe546a8038efe4029ull
+        ,0xbf8fdb78849a5f96ull,0xde98520472bdd033ull
+        ,0xef73d256a5c0f77cull,0x963e66858f6d4440ull
+        ,0x95a8637627989aadull,0xdde7001379a44aa8ull
+        ,0xbb127c53b17ec159ull,0x5560c018580d5d52ull
+        ,0xe9d71b689dde71afull,0xaab8f01e6e10b4a6ull
+        ,0x9226712162ab070dull,0xcab3961304ca70e8ull
+        ,0xb6b00d69bb55c8d1ull,0x3d607b97c5fd0d22ull
+        ,0xe45c10c42a2b3b05ull,0x8cb89a7db77c506aull
+        ,0x8eb98a7a9a5b04e3ull,0x77f3608e92adb242ull
+        ,0xb267ed1940f1c61cull,0x55f038b237591ed3ull
+        ,0xdf01e85f912e37a3ull,0x6b6c46dec52f6688ull
+        ,0x8b61313bbabce2c6ull,0x2323ac4b3b3da015ull
+        ,0xae397d8aa96c1b77ull,0xabec975e0a0d081aull
+        ,0xd9c7dced53c72255ull,0x96e7bd358c904a21ull
+        ,0x881cea14545c7575ull,0x7e50d64177da2e54ull
+        ,0xaa242499697392d2ull,0xdde50bd1d5d0b9e9ull
+        ,0xd4ad2dbfc3d07787ull,0x955e4ec64b44e864ull
+        ,0x84ec3c97da624ab4ull,0xbd5af13bef0b113eull
+        ,0xa6274bbdd0fadd61ull,0xecb1ad8aeacdd58eull
+        ,0xcfb11ead453994baull,0x67de18eda5814af2ull
+        ,0x81ceb32c4b43fcf4ull,0x80eacf948770ced7ull
+        ,0xa2425ff75e14fc31ull,0xa1258379a94d028dull
+        ,0xcad2f7f5359a3b3eull,0x096ee45813a04330ull
+        ,0xfd87b5f28300ca0dull,0x8bca9d6e188853fcull
+        ,0x9e74d1b791e07e48ull,0x775ea264cf55347eull
+        ,0xc612062576589ddaull,0x95364afe032a819eull
+        ,0xf79687aed3eec551ull,0x3a83ddbd83f52205ull
+        ,0x9abe14cd44753b52ull,0xc4926a9672793543ull
+        ,0xc16d9a0095928a27ull,0x75b7053c0f178294ull
+        ,0xf1c90080baf72cb1ull,0x5324c68b12dd6339ull
+        ,0x971da05074da7beeull,0xd3f6fc16ebca5e04ull
+        ,0xbce5086492111aeaull,0x88f4bb1ca6bcf585ull
+        ,0xec1e4a7db69561a5ull,0x2b31e9e3d06c32e6ull
+        ,0x9392ee8e921d5d07ull,0x3aff322e62439fd0ull
+        ,0xb877aa3236a4b449ull,0x09befeb9fad487c3ull
+        ,0xe69594bec44de15bull,0x4c2ebe687989a9b4ull
+        ,0x901d7cf73ab0acd9ull,0x0f9d37014bf60a11ull
+        ,0xb424dc35095cd80full,0x538484c19ef38c95ull
+        ,0xe12e13424bb40e13ull,0x2865a5f206b06fbaull
+        ,0x8cbccc096f5088cbull,0xf93f87b7442e45d4ull
+        ,0xafebff0bcb24aafeull,0xf78f69a51539d749ull
+        ,0xdbe6fecebdedd5beull,0xb573440e5a884d1cull
+        ,0x89705f4136b4a597ull,0x31680a88f8953031ull
+        ,0xabcc77118461cefcull,0xfdc20d2b36ba7c3eull
+        ,0xd6bf94d5e57a42bcull,0x3d32907604691b4dull
+        ,0x8637bd05af6c69b5ull,0xa63f9a49c2c1b110ull
+        ,0xa7c5ac471b478423ull,0x0fcf80dc33721d54ull
+        ,0xd1b71758e219652bull,0xd3c36113404ea4a9ull
+        ,0x83126e978d4fdf3bull,0x645a1cac083126eaull
+        ,0xa3d70a3d70a3d70aull,0x3d70a3d70a3d70a4ull
+        ,0xccccccccccccccccull,0xcccccccccccccccdull
+        ,0x8000000000000000ull,0x0000000000000000ull
+        ,0xa000000000000000ull,0x0000000000000000ull
+        ,0xc800000000000000ull,0x0000000000000000ull
+        ,0xfa00000000000000ull,0x0000000000000000ull
+        ,0x9c40000000000000ull,0x0000000000000000ull
+        ,0xc350000000000000ull,0x0000000000000000ull
+        ,0xf424000000000000ull,0x0000000000000000ull
+        ,0x9896800000000000ull,0x0000000000000000ull
+        ,0xbebc200000000000ull,0x0000000000000000ull
+        ,0xee6b280000000000ull,0x0000000000000000ull
+        ,0x9502f90000000000ull,0x0000000000000000ull
+        ,0xba43b74000000000ull,0x0000000000000000ull
+        ,0xe8d4a51000000000ull,0x0000000000000000ull
+        ,0x9184e72a00000000ull,0x0000000000000000ull
+        ,0xb5e620f480000000ull,0x0000000000000000ull
+        ,0xe35fa931a0000000ull,0x0000000000000000ull
+        ,0x8e1bc9bf04000000ull,0x0000000000000000ull
+        ,0xb1a2bc2ec5000000ull,0x0000000000000000ull
+        ,0xde0b6b3a76400000ull,0x0000000000000000ull
+        ,0x8ac7230489e80000ull,0x0000000000000000ull
+        ,0xad78ebc5ac620000ull,0x0000000000000000ull
+        ,0xd8d726b7177a8000ull,0x0000000000000000ull
+        ,0x878678326eac9000ull,0x0000000000000000ull
+        ,0xa968163f0a57b400ull,0x0000000000000000ull
+        ,0xd3c21bcecceda100ull,0x0000000000000000ull
+        ,0x84595161401484a0ull,0x0000000000000000ull
+        ,0xa56fa5b99019a5c8ull,0x0000000000000000ull
+        ,0xcecb8f27f4200f3aull,0x0000000000000000ull
+        ,0x813f3978f8940984ull,0x4000000000000000ull
+        ,0xa18f07d736b90be5ull,0x5000000000000000ull
+        ,0xc9f2c9cd04674edeull,0xa400000000000000ull
+        ,0xfc6f7c4045812296ull,0x4d00000000000000ull
+        ,0x9dc5ada82b70b59dull,0xf020000000000000ull
+        ,0xc5371912364ce305ull,0x6c28000000000000ull
+        ,0xf684df56c3e01bc6ull,0xc732000000000000ull
+        ,0x9a130b963a6c115cull,0x3c7f400000000000ull
+        ,0xc097ce7bc90715b3ull,0x4b9f100000000000ull
+        ,0xf0bdc21abb48db20ull,0x1e86d40000000000ull
+        ,0x96769950b50d88f4ull,0x1314448000000000ull
+        ,0xbc143fa4e250eb31ull,0x17d955a000000000ull
+        ,0xeb194f8e1ae525fdull,0x5dcfab0800000000ull
+        ,0x92efd1b8d0cf37beull,0x5aa1cae500000000ull
+        ,0xb7abc627050305adull,0xf14a3d9e40000000ull
+        ,0xe596b7b0c643c719ull,0x6d9ccd05d0000000ull
+        ,0x8f7e32ce7bea5c6full,0xe4820023a2000000ull
+        ,0xb35dbf821ae4f38bull,0xdda2802c8a800000ull
+        ,0xe0352f62a19e306eull,0xd50b2037ad200000ull
+        ,0x8c213d9da502de45ull,0x4526f422cc340000ull
+        ,0xaf298d050e4395d6ull,0x9670b12b7f410000ull
+        ,0xdaf3f04651d47b4cull,0x3c0cdd765f114000ull
+        ,0x88d8762bf324cd0full,0xa5880a69fb6ac800ull
+        ,0xab0e93b6efee0053ull,0x8eea0d047a457a00ull
+        ,0xd5d238a4abe98068ull,0x72a4904598d6d880ull
+        ,0x85a36366eb71f041ull,0x47a6da2b7f864750ull
+        ,0xa70c3c40a64e6c51ull,0x999090b65f67d924ull
+        ,0xd0cf4b50cfe20765ull,0xfff4b4e3f741cf6dull
+        ,0x82818f1281ed449full,0xbff8f10e7a8921a4ull
+        ,0xa321f2d7226895c7ull,0xaff72d52192b6a0dull
+        ,0xcbea6f8ceb02bb39ull,0x9bf4f8a69f764490ull
+        ,0xfee50b7025c36a08ull,0x02f236d04753d5b4ull
+        ,0x9f4f2726179a2245ull,0x01d762422c946590ull
+        ,0xc722f0ef9d80aad6ull,0x424d3ad2b7b97ef5ull
+        ,0xf8ebad2b84e0d58bull,0xd2e0898765a7deb2ull
+        ,0x9b934c3b330c8577ull,0x63cc55f49f88eb2full
+        ,0xc2781f49ffcfa6d5ull,0x3cbf6b71c76b25fbull
+        ,0xf316271c7fc3908aull,0x8bef464e3945ef7aull
+        ,0x97edd871cfda3a56ull,0x97758bf0e3cbb5acull
+        ,0xbde94e8e43d0c8ecull,0x3d52eeed1cbea317ull
+        ,0xed63a231d4c4fb27ull,0x4ca7aaa863ee4bddull
+        ,0x945e455f24fb1cf8ull,0x8fe8caa93e74ef6aull
+        ,0xb975d6b6ee39e436ull,0xb3e2fd538e122b44ull
+        ,0xe7d34c64a9c85d44ull,0x60dbbca87196b616ull
+        ,0x90e40fbeea1d3a4aull,0xbc8955e946fe31cdull
+        ,0xb51d13aea4a488ddull,0x6babab6398bdbe41ull
+        ,0xe264589a4dcdab14ull,0xc696963c7eed2dd1ull
+        ,0x8d7eb76070a08aecull,0xfc1e1de5cf543ca2ull
+        ,0xb0de65388cc8ada8ull,0x3b25a55f43294bcbull
+        ,0xdd15fe86affad912ull,0x49ef0eb713f39ebeull
+        ,0x8a2dbf142dfcc7abull,0x6e3569326c784337ull
+        ,0xacb92ed9397bf996ull,0x49c2c37f07965404ull
+        ,0xd7e77a8f87daf7fbull,0xdc33745ec97be906ull
+        ,0x86f0ac99b4e8dafdull,0x69a028bb3ded71a3ull
+        ,0xa8acd7c0222311bcull,0xc40832ea0d68ce0cull
+        ,0xd2d80db02aabd62bull,0xf50a3fa490c30190ull
+        ,0x83c7088e1aab65dbull,0x792667c6da79e0faull
+        ,0xa4b8cab1a1563f52ull,0x577001b891185938ull
+        ,0xcde6fd5e09abcf26ull,0xed4c0226b55e6f86ull
+        ,0x80b05e5ac60b6178ull,0x544f8158315b05b4ull
+        ,0xa0dc75f1778e39d6ull,0x696361ae3db1c721ull
+        ,0xc913936dd571c84cull,0x03bc3a19cd1e38e9ull
+        ,0xfb5878494ace3a5full,0x04ab48a04065c723ull
+        ,0x9d174b2dcec0e47bull,0x62eb0d64283f9c76ull
+        ,0xc45d1df942711d9aull,0x3ba5d0bd324f8394ull
+        ,0xf5746577930d6500ull,0xca8f44ec7ee36479ull
+        ,0x9968bf6abbe85f20ull,0x7e998b13cf4e1ecbull
+        ,0xbfc2ef456ae276e8ull,0x9e3fedd8c321a67eull
+        ,0xefb3ab16c59b14a2ull,0xc5cfe94ef3ea101eull
+        ,0x95d04aee3b80ece5ull,0xbba1f1d158724a12ull
+        ,0xbb445da9ca61281full,0x2a8a6e45ae8edc97ull
+        ,0xea1575143cf97226ull,0xf52d09d71a3293bdull
+        ,0x924d692ca61be758ull,0x593c2626705f9c56ull
+        ,0xb6e0c377cfa2e12eull,0x6f8b2fb00c77836cull
+        ,0xe498f455c38b997aull,0x0b6dfb9c0f956447ull
+        ,0x8edf98b59a373fecull,0x4724bd4189bd5eacull
+        ,0xb2977ee300c50fe7ull,0x58edec91ec2cb657ull
+        ,0xdf3d5e9bc0f653e1ull,0x2f2967b66737e3edull
+        ,0x8b865b215899f46cull,0xbd79e0d20082ee74ull
+        ,0xae67f1e9aec07187ull,0xecd8590680a3aa11ull
+        ,0xda01ee641a708de9ull,0xe80e6f4820cc9495ull
+        ,0x884134fe908658b2ull,0x3109058d147fdcddull
+        ,0xaa51823e34a7eedeull,0xbd4b46f0599fd415ull
+        ,0xd4e5e2cdc1d1ea96ull,0x6c9e18ac7007c91aull
+        ,0x850fadc09923329eull,0x03e2cf6bc604ddb0ull
+        ,0xa6539930bf6bff45ull,0x84db8346b786151cull
+        ,0xcfe87f7cef46ff16ull,0xe612641865679a63ull
+        ,0x81f14fae158c5f6eull,0x4fcb7e8f3f60c07eull
+        ,0xa26da3999aef7749ull,0xe3be5e330f38f09dull
+        ,0xcb090c8001ab551cull,0x5cadf5bfd3072cc5ull
+        ,0xfdcb4fa002162a63ull,0x73d9732fc7c8f7f6ull
+        ,0x9e9f11c4014dda7eull,0x2867e7fddcdd9afaull
+        ,0xc646d63501a1511dull,0xb281e1fd541501b8ull
+        ,0xf7d88bc24209a565ull,0x1f225a7ca91a4226ull
+        ,0x9ae757596946075full,0x3375788de9b06958ull
+        ,0xc1a12d2fc3978937ull,0x0052d6b1641c83aeull
+        ,0xf209787bb47d6b84ull,0xc0678c5dbd23a49aull
+        ,0x9745eb4d50ce6332ull,0xf840b7ba963646e0ull
+        ,0xbd176620a501fbffull,0xb650e5a93bc3d898ull
+        ,0xec5d3fa8ce427affull,0xa3e51f138ab4cebeull
+        ,0x93ba47c980e98cdfull,0xc66f336c36b10137ull
+        ,0xb8a8d9bbe123f017ull,0xb80b0047445d4184ull
+        ,0xe6d3102ad96cec1dull,0xa60dc059157491e5ull
+        ,0x9043ea1ac7e41392ull,0x87c89837ad68db2full
+        ,0xb454e4a179dd1877ull,0x29babe4598c311fbull
+        ,0xe16a1dc9d8545e94ull,0xf4296dd6fef3d67aull
+        ,0x8ce2529e2734bb1dull,0x1899e4a65f58660cull
+        ,0xb01ae745b101e9e4ull,0x5ec05dcff72e7f8full
+        ,0xdc21a1171d42645dull,0x76707543f4fa1f73ull
+        ,0x899504ae72497ebaull,0x6a06494a791c53a8ull
+        ,0xabfa45da0edbde69ull,0x0487db9d17636892ull
+        ,0xd6f8d7509292d603ull,0x45a9d2845d3c42b6ull
+        ,0x865b86925b9bc5c2ull,0x0b8a2392ba45a9b2ull
+        ,0xa7f26836f282b732ull,0x8e6cac7768d7141eull
+        ,0xd1ef0244af2364ffull,0x3207d795430cd926ull
+        ,0x8335616aed761f1full,0x7f44e6bd49e807b8ull
+        ,0xa402b9c5a8d3a6e7ull,0x5f16206c9c6209a6ull
+        ,0xcd036837130890a1ull,0x36dba887c37a8c0full
+        ,0x802221226be55a64ull,0xc2494954da2c9789ull
+        ,0xa02aa96b06deb0fdull,0xf2db9baa10b7bd6cull
+        ,0xc83553c5c8965d3dull,0x6f92829494e5acc7ull
+        ,0xfa42a8b73abbf48cull,0xcb772339ba1f17f9ull
+        ,0x9c69a97284b578d7ull,0xff2a760414536efbull
+        ,0xc38413cf25e2d70dull,0xfef5138519684abaull
+        ,0xf46518c2ef5b8cd1ull,0x7eb258665fc25d69ull
+        ,0x98bf2f79d5993802ull,0xef2f773ffbd97a61ull
+        ,0xbeeefb584aff8603ull,0xaafb550ffacfd8faull
+        ,0xeeaaba2e5dbf6784ull,0x95ba2a53f983cf38ull
+        ,0x952ab45cfa97a0b2ull,0xdd945a747bf26183ull
+        ,0xba756174393d88dfull,0x94f971119aeef9e4ull
+        ,0xe912b9d1478ceb17ull,0x7a37cd5601aab85dull
+        ,0x91abb422ccb812eeull,0xac62e055c10ab33aull
+        ,0xb616a12b7fe617aaull,0x577b986b314d6009ull
+        ,0xe39c49765fdf9d94ull,0xed5a7e85fda0b80bull
+        ,0x8e41ade9fbebc27dull,0x14588f13be847307ull
+        ,0xb1d219647ae6b31cull,0x596eb2d8ae258fc8ull
+        ,0xde469fbd99a05fe3ull,0x6fca5f8ed9aef3bbull
+        ,0x8aec23d680043beeull,0x25de7bb9480d5854ull
+        ,0xada72ccc20054ae9ull,0xaf561aa79a10ae6aull
+        ,0xd910f7ff28069da4ull,0x1b2ba1518094da04ull
+        ,0x87aa9aff79042286ull,0x90fb44d2f05d0842ull
+        ,0xa99541bf57452b28ull,0x353a1607ac744a53ull
+        ,0xd3fa922f2d1675f2ull,0x42889b8997915ce8ull
+        ,0x847c9b5d7c2e09b7ull,0x69956135febada11ull
+        ,0xa59bc234db398c25ull,0x43fab9837e699095ull
+        ,0xcf02b2c21207ef2eull,0x94f967e45e03f4bbull
+        ,0x8161afb94b44f57dull,0x1d1be0eebac278f5ull
+        ,0xa1ba1ba79e1632dcull,0x6462d92a69731732ull
+        ,0xca28a291859bbf93ull,0x7d7b8f7503cfdcfeull
+        ,0xfcb2cb35e702af78ull,0x5cda735244c3d43eull
+        ,0x9defbf01b061adabull,0x3a0888136afa64a7ull
+        ,0xc56baec21c7a1916ull,0x088aaa1845b8fdd0ull
+        ,0xf6c69a72a3989f5bull,0x8aad549e57273d45ull
+        ,0x9a3c2087a63f6399ull,0x36ac54e2f678864bull
+        ,0xc0cb28a98fcf3c7full,0x84576a1bb416a7ddull
+        ,0xf0fdf2d3f3c30b9full,0x656d44a2a11c51d5ull
+        ,0x969eb7c47859e743ull,0x9f644ae5a4b1b325ull
+        ,0xbc4665b596706114ull,0x873d5d9f0dde1feeull
+        ,0xeb57ff22fc0c7959ull,0xa90cb506d155a7eaull
+        ,0x9316ff75dd87cbd8ull,0x09a7f12442d588f2ull
+        ,0xb7dcbf5354e9beceull,0x0c11ed6d538aeb2full
+        ,0xe5d3ef282a242e81ull,0x8f1668c8a86da5faull
+        ,0x8fa475791a569d10ull,0xf96e017d694487bcull
+        ,0xb38d92d760ec4455ull,0x37c981dcc395a9acull
+        ,0xe070f78d3927556aull,0x85bbe253f47b1417ull
+        ,0x8c469ab843b89562ull,0x93956d7478ccec8eull
+        ,0xaf58416654a6babbull,0x387ac8d1970027b2ull
+        ,0xdb2e51bfe9d0696aull,0x06997b05fcc0319eull
+        ,0x88fcf317f22241e2ull,0x441fece3bdf81f03ull
+        ,0xab3c2fddeeaad25aull,0xd527e81cad7626c3ull
+        ,0xd60b3bd56a5586f1ull,0x8a71e223d8d3b074ull
+        ,0x85c7056562757456ull,0xf6872d5667844e49ull
+        ,0xa738c6bebb12d16cull,0xb428f8ac016561dbull
+        ,0xd106f86e69d785c7ull,0xe13336d701beba52ull
+        ,0x82a45b450226b39cull,0xecc0024661173473ull
+        ,0xa34d721642b06084ull,0x27f002d7f95d0190ull
+        ,0xcc20ce9bd35c78a5ull,0x31ec038df7b441f4ull
+        ,0xff290242c83396ceull,0x7e67047175a15271ull
+        ,0x9f79a169bd203e41ull,0x0f0062c6e984d386ull
+        ,0xc75809c42c684dd1ull,0x52c07b78a3e60868ull
+        ,0xf92e0c3537826145ull,0xa7709a56ccdf8a82ull
+        ,0x9bbcc7a142b17ccbull,0x88a66076400bb691ull
+        ,0xc2abf989935ddbfeull,0x6acff893d00ea435ull
+        ,0xf356f7ebf83552feull,0x0583f6b8c4124d43ull
+        ,0x98165af37b2153deull,0xc3727a337a8b704aull
+        ,0xbe1bf1b059e9a8d6ull,0x744f18c0592e4c5cull
+        ,0xeda2ee1c7064130cull,0x1162def06f79df73ull
+        ,0x9485d4d1c63e8be7ull,0x8addcb5645ac2ba8ull
+        ,0xb9a74a0637ce2ee1ull,0x6d953e2bd7173692ull
+        ,0xe8111c87c5c1ba99ull,0xc8fa8db6ccdd0437ull
+        ,0x910ab1d4db9914a0ull,0x1d9c9892400a22a2ull
+        ,0xb54d5e4a127f59c8ull,0x2503beb6d00cab4bull
+        ,0xe2a0b5dc971f303aull,0x2e44ae64840fd61dull
+        ,0x8da471a9de737e24ull,0x5ceaecfed289e5d2ull
+        ,0xb10d8e1456105dadull,0x7425a83e872c5f47ull
+        ,0xdd50f1996b947518ull,0xd12f124e28f77719ull
+        ,0x8a5296ffe33cc92full,0x82bd6b70d99aaa6full
+        ,0xace73cbfdc0bfb7bull,0x636cc64d1001550bull
+        ,0xd8210befd30efa5aull,0x3c47f7e05401aa4eull
+        ,0x8714a775e3e95c78ull,0x65acfaec34810a71ull
+        ,0xa8d9d1535ce3b396ull,0x7f1839a741a14d0dull
+        ,0xd31045a8341ca07cull,0x1ede48111209a050ull
+        ,0x83ea2b892091e44dull,0x934aed0aab460432ull
+        ,0xa4e4b66b68b65d60ull,0xf81da84d5617853full
+        ,0xce1de40642e3f4b9ull,0x36251260ab9d668eull
+        ,0x80d2ae83e9ce78f3ull,0xc1d72b7c6b426019ull
+        ,0xa1075a24e4421730ull,0xb24cf65b8612f81full
+        ,0xc94930ae1d529cfcull,0xdee033f26797b627ull
+        ,0xfb9b7cd9a4a7443cull,0x169840ef017da3b1ull
+        ,0x9d412e0806e88aa5ull,0x8e1f289560ee864eull
+        ,0xc491798a08a2ad4eull,0xf1a6f2bab92a27e2ull
+        ,0xf5b5d7ec8acb58a2ull,0xae10af696774b1dbull
+        ,0x9991a6f3d6bf1765ull,0xacca6da1e0a8ef29ull
+        ,0xbff610b0cc6edd3full,0x17fd090a58d32af3ull
+        ,0xeff394dcff8a948eull,0xddfc4b4cef07f5b0ull
+        ,0x95f83d0a1fb69cd9ull,0x4abdaf101564f98eull
+        ,0xbb764c4ca7a4440full,0x9d6d1ad41abe37f1ull
+        ,0xea53df5fd18d5513ull,0x84c86189216dc5edull
+        ,0x92746b9be2f8552cull,0x32fd3cf5b4e49bb4ull
+        ,0xb7118682dbb66a77ull,0x3fbc8c33221dc2a1ull
+        ,0xe4d5e82392a40515ull,0x0fabaf3feaa5334aull
+        ,0x8f05b1163ba6832dull,0x29cb4d87f2a7400eull
+        ,0xb2c71d5bca9023f8ull,0x743e20e9ef511012ull
+        ,0xdf78e4b2bd342cf6ull,0x914da9246b255416ull
+        ,0x8bab8eefb6409c1aull,0x1ad089b6c2f7548eull
+        ,0xae9672aba3d0c320ull,0xa184ac2473b529b1ull
+        ,0xda3c0f568cc4f3e8ull,0xc9e5d72d90a2741eull
+        ,0x8865899617fb1871ull,0x7e2fa67c7a658892ull
+        ,0xaa7eebfb9df9de8dull,0xddbb901b98feeab7ull
+        ,0xd51ea6fa85785631ull,0x552a74227f3ea565ull
+        ,0x8533285c936b35deull,0xd53a88958f87275full
+        ,0xa67ff273b8460356ull,0x8a892abaf368f137ull
+        ,0xd01fef10a657842cull,0x2d2b7569b0432d85ull
+        ,0x8213f56a67f6b29bull,0x9c3b29620e29fc73ull
+        ,0xa298f2c501f45f42ull,0x8349f3ba91b47b8full
+        ,0xcb3f2f7642717713ull,0x241c70a936219a73ull
+        ,0xfe0efb53d30dd4d7ull,0xed238cd383aa0110ull
+        ,0x9ec95d1463e8a506ull,0xf4363804324a40aaull
+        ,0xc67bb4597ce2ce48ull,0xb143c6053edcd0d5ull
+        ,0xf81aa16fdc1b81daull,0xdd94b7868e94050aull
+        ,0x9b10a4e5e9913128ull,0xca7cf2b4191c8326ull
+        ,0xc1d4ce1f63f57d72ull,0xfd1c2f611f63a3f0ull
+        ,0xf24a01a73cf2dccfull,0xbc633b39673c8cecull
+        ,0x976e41088617ca01ull,0xd5be0503e085d813ull
+        ,0xbd49d14aa79dbc82ull,0x4b2d8644d8a74e18ull
+        ,0xec9c459d51852ba2ull,0xddf8e7d60ed1219eull
+        ,0x93e1ab8252f33b45ull,0xcabb90e5c942b503ull
+        ,0xb8da1662e7b00a17ull,0x3d6a751f3b936243ull
+        ,0xe7109bfba19c0c9dull,0x0cc512670a783ad4ull
+        ,0x906a617d450187e2ull,0x27fb2b80668b24c5ull
+        ,0xb484f9dc9641e9daull,0xb1f9f660802dedf6ull
+        ,0xe1a63853bbd26451ull,0x5e7873f8a0396973ull
+        ,0x8d07e33455637eb2ull,0xdb0b487b6423e1e8ull
+        ,0xb049dc016abc5e5full,0x91ce1a9a3d2cda62ull
+        ,0xdc5c5301c56b75f7ull,0x7641a140cc7810fbull
+        ,0x89b9b3e11b6329baull,0xa9e904c87fcb0a9dull
+        ,0xac2820d9623bf429ull,0x546345fa9fbdcd44ull
+        ,0xd732290fbacaf133ull,0xa97c177947ad4095ull
+        ,0x867f59a9d4bed6c0ull,0x49ed8eabcccc485dull
+        ,0xa81f301449ee8c70ull,0x5c68f256bfff5a74ull
+        ,0xd226fc195c6a2f8cull,0x73832eec6fff3111ull
+        ,0x83585d8fd9c25db7ull,0xc831fd53c5ff7eabull
+        ,0xa42e74f3d032f525ull,0xba3e7ca8b77f5e55ull
+        ,0xcd3a1230c43fb26full,0x28ce1bd2e55f35ebull
+        ,0x80444b5e7aa7cf85ull,0x7980d163cf5b81b3ull
+        ,0xa0555e361951c366ull,0xd7e105bcc332621full
+        ,0xc86ab5c39fa63440ull,0x8dd9472bf3fefaa7ull
+        ,0xfa856334878fc150ull,0xb14f98f6f0feb951ull
+        ,0x9c935e00d4b9d8d2ull,0x6ed1bf9a569f33d3ull
+        ,0xc3b8358109e84f07ull,0x0a862f80ec4700c8ull
+        ,0xf4a642e14c6262c8ull,0xcd27bb612758c0faull
+        ,0x98e7e9cccfbd7dbdull,0x8038d51cb897789cull
+        ,0xbf21e44003acdd2cull,0xe0470a63e6bd56c3ull
+        ,0xeeea5d5004981478ull,0x1858ccfce06cac74ull
+        ,0x95527a5202df0ccbull,0x0f37801e0c43ebc8ull
+        ,0xbaa718e68396cffdull,0xd30560258f54e6baull
+        ,0xe950df20247c83fdull,0x47c6b82ef32a2069ull
+        ,0x91d28b7416cdd27eull,0x4cdc331d57fa5441ull
+        ,0xb6472e511c81471dull,0xe0133fe4adf8e952ull
+        ,0xe3d8f9e563a198e5ull,0x58180fddd97723a6ull
+        ,0x8e679c2f5e44ff8full,0x570f09eaa7ea7648ull
+    };
+    static_assert(sizeof(table) == 651 * 2 * sizeof(std::uint64_t), "");
 
-    return std::strtof(buf, nullptr);
+    return table + 2 * (q + 342);
 }
 
-template<typename To>
-typename std::enable_if<std::is_same<To, std::string>::value, To>::type
-conv_to(const char *ptr, std::size_t len, To) { return {ptr, len}; }
+struct uint128 {
+    std::uint64_t lo;
+    std::uint64_t hi;
+};
 
-template<typename To>
-typename std::enable_if<std::is_same<To, flatjson::string_view>::value, To>::type
-conv_to(const char *ptr, std::size_t len, To) { return {ptr, len}; }
+inline uint128 mul_64x64(std::uint64_t l, std::uint64_t r) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ using uint128_t = unsigned __int128;
+    const uint128_t res = static_cast<uint128_t>(l) * r;
 
-} // ns details
+    return {static_cast<std::uint64_t>(res), static_cast<std::uint64_t>(res >> 64)};
+#else
+    const std::uint64_t ll = l & 0xffffffffu, lh = l >> 32;
+    const std::uint64_t rl = r & 0xffffffffu, rh = r >> 32;
+    const std::uint64_t p0 = ll * rl, p1 = ll * rh, p2 = lh * rl, p3 = lh * rh;
+    const std::uint64_t mid = (p0 >> 32) + (p1 & 0xffffffffu) + (p2 & 0xffffffffu);
 
-/*************************************************************************************************/
-// 40 bytes for now
-struct token {
-    const char *key;
-    const char *val;
-    token *parent;
-    token *end;
-    FJ_CHILDS_TYPE childs;
-    FJ_VLEN_TYPE vlen;
-    FJ_KLEN_TYPE klen;
-    token_type type;
-    std::uint8_t flags;
-    std::uint8_t unused;
-};
+    return {(mid << 32) | (p0 & 0xffffffffu), p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32)};
+#endif
+}
 
-/*************************************************************************************************/
+inline int clz64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(v);
+#else
+    int res = 0;
+    for ( ; !(v & (1ull << 63)); v <<= 1, ++res )
+        ;
+    return res;
+#endif
+}
 
-using alloc_fnptr = void*(*)(std::size_t);
-using free_fnptr = void(*)(void *);
+inline int ctz64(std::uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int res = 0;
+    for ( ; !(v & 1u); v >>= 1, ++res )
+        ;
+    return res;
+#endif
+}
 
-struct parser {
-    const char *str_beg;
-    const char *str_cur;
-    const char *str_end;
+template<typename T>
+struct float_traits;
 
-    token *toks_beg;
-    token *toks_cur;
-    token *toks_end;
+template<>
+struct float_traits<double> {
+    using bits_type = std::uint64_t;
+    static constexpr int mantissa_bits = 52;
+    static constexpr int bias = 1023;
+    static constexpr int min_pow10 = -342; // less is zero
+    static constexpr int max_pow10 = 308;  // greater is infinity
+    static constexpr int max_exact_pow10 = 22;
+    static constexpr std::uint64_t max_exact_mantissa = 1ull << 53;
+
+    static double exact_pow10(int e) {
+        static constexpr double table[] = {
+             1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11
+            ,1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
 
-    alloc_fnptr alloc_fn;
-    free_fnptr  free_fn;
-    error_code  error;
-    bool dyn_tokens;
-    bool dyn_parser;
-    std::uint32_t ref_cnt;
+        return table[e];
+    }
+};
 
-    static std::size_t inc_refcnt(parser *parser) { return ++parser->ref_cnt; }
-    static std::size_t dec_refcnt(parser *parser) { return --parser->ref_cnt; }
+template<>
+struct float_traits<float> {
+    using bits_type = std::uint32_t;
+    static constexpr int mantissa_bits = 23;
+    static constexpr int bias = 127;
+    static constexpr int min_pow10 = -65;
+    static constexpr int max_pow10 = 38;
+    static constexpr int max_exact_pow10 = 10;
+    static constexpr std::uint64_t max_exact_mantissa = 1ull << 24;
+
+    static float exact_pow10(int e) {
+        static constexpr float table[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+
+        return table[e];
+    }
 };
 
-/*************************************************************************************************/
+// computes the nearest T for w * 10^q.
+// returns false if the result can't be decided, then the slow path should be used.
+template<typename T>
+bool eisel_lemire(std::uint64_t w, std::int64_t q, bool neg, T *res) {
+    using traits = float_traits<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr int shift = 64 - traits::mantissa_bits - 3;
+    constexpr std::uint64_t mask = (1ull << shift) - 1;
+
+    // the Clinger's fast path: both w and 10^q are exact
+    if ( q >= -traits::max_exact_pow10 && q <= traits::max_exact_pow10
+        && w <= traits::max_exact_mantissa )
+    {
+        T v = static_cast<T>(w);
+        v = q < 0
+            ? v / traits::exact_pow10(static_cast<int>(-q))
+            : v * traits::exact_pow10(static_cast<int>(q))
+        ;
+        *res = neg ? -v : v;
 
-namespace details {
+        return true;
+    }
+    if ( w == 0 || q < traits::min_pow10 ) {
+        *res = neg ? -T{0} : T{0};
 
-/*************************************************************************************************/
-// for debug purposes
+        return true;
+    }
+    if ( q > traits::max_pow10 ) {
+        *res = neg
+            ? -std::numeric_limits<T>::infinity()
+            : std::numeric_limits<T>::infinity()
+        ;
 
-inline void dump_tokens_impl(
-     std::FILE *stream
-    ,const token *beg
-    ,const token *cur
-    ,const token *end
-    ,std::size_t indent)
-{
-    static const char* tnames[] = {
-         "INV" // invalid type
-        ,"STR" // string type
-        ,"NUM" // number type
-        ,"BOL" // bool type
-        ,"NUL" // null type
-        ,"+OB" // start object
-        ,"-OB" // and object
-        ,"+AR" // start array
-        ,"-AR" // end array
-    };
-    static const char spaces[] = "                                                         ";
+        return true;
+    }
 
-    int local_indent = 0;
-    for ( auto it = beg; it != end; ++it ) {
-        if ( it->type == FJ_TYPE_ARRAY_END || it->type == FJ_TYPE_OBJECT_END ) {
-            assert(indent > 0);
-            local_indent -= static_cast<int>(indent);
-        }
-        std::fprintf(stream, "%3d:%c type=%.*s%3s, addr=%p, end=%p, parent=%p, childs=%d, key=\"%.*s\", val=\"%.*s\"\n"
-            ,(int)(it - beg)
-            ,(it == cur ? '>' : ' ')
-            ,local_indent, spaces, tnames[it->type]
-            ,it
-            ,it->end
-            ,it->parent
-            ,(int)it->childs
-            ,(int)(it->klen ? it->klen : 5), (it->klen ? it->key : "(nil)")
-            ,(int)(it->vlen ? it->vlen : 5), (it->vlen ? it->val : "(nil)")
-        );
-        std::fflush(stream);
-        if ( it->type == FJ_TYPE_ARRAY || it->type == FJ_TYPE_OBJECT ) {
-            local_indent += static_cast<int>(indent);
+    const std::uint64_t *pow5 = pow5_128(q);
+    const std::int64_t exponent = (((152170 + 65536) * q) >> 16) + traits::bias + 1 + 63;
+    int lz = clz64(w);
+    w <<= lz;
+
+    auto product = mul_64x64(w, pow5[0]);
+    std::uint64_t lower = product.lo;
+    std::uint64_t upper = product.hi;
+    if ( (upper & mask) == mask && lower + w < lower ) {
+        // the approximation is not precise enough, use the 128 bits of 5^q
+        product = mul_64x64(w, pow5[1]);
+        const std::uint64_t product_low = product.lo;
+        std::uint64_t product_middle = lower + product.hi;
+        std::uint64_t product_high = upper + static_cast<std::uint64_t>(product_middle < lower);
+        if ( product_middle + 1 == 0 && (product_high & mask) == mask && product_low + w < product_low ) {
+            return false;
         }
+        upper = product_high;
+        lower = product_middle;
     }
-}
 
-// dump using parser
-inline void dump_tokens(std::FILE *stream, const char *caption, parser *parser, std::size_t indent = 3) {
-    std::fprintf(stream, "%s:\n", caption);
-    dump_tokens_impl(stream, parser->toks_beg, parser->toks_beg, parser->toks_end, indent);
-}
+    const std::uint64_t upperbit = upper >> 63;
+    std::uint64_t mantissa = upper >> (upperbit + shift);
+    lz += static_cast<int>(1 ^ upperbit);
+    // exactly in the middle between two floats
+    if ( lower == 0 && (upper & mask) == 0 && (mantissa & 3) == 1 ) {
+        return false;
+    }
 
-/*************************************************************************************************/
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if ( mantissa >= (2ull << traits::mantissa_bits) ) {
+        mantissa = 1ull << traits::mantissa_bits;
+        --lz;
+    }
+    mantissa &= ~(1ull << traits::mantissa_bits);
 
-inline const char* fj_skip_ws(const char *s) {
-    constexpr bool t = true;
-    constexpr bool f = false;
-    static const bool map[] = {
-         f,f,f,f,f,f,f,f,f,t,t,f,f,t,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,t,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
-    };
-    static_assert(sizeof(map) == 256, "");
+    const std::int64_t real_exponent = exponent - lz;
+    // the subnormals and the overflows are left for the slow path
+    if ( real_exponent < 1 || real_exponent > 2 * traits::bias ) {
+        return false;
+    }
 
-    for ( ;map[static_cast<std::uint8_t>(*s)]; ++s );
+    bits_type bits = static_cast<bits_type>(mantissa)
+        | static_cast<bits_type>(static_cast<bits_type>(real_exponent) << traits::mantissa_bits)
+        | static_cast<bits_type>(static_cast<bits_type>(neg) << (sizeof(bits_type) * 8 - 1))
+    ;
+    std::memcpy(res, &bits, sizeof(bits));
 
-    return s;
+    return true;
 }
 
-#define __FJ__CUR_CHAR(p) \
-    ((p->str_cur = fj_skip_ws(p->str_cur)), (*(p->str_cur) == 0 ? ((int)-1) : *(p->str_cur)))
+// the unsigned integer of the fixed capacity for the slow paths of the float conversions.
+// the limbs are little-endian.
+struct bigint {
+    // the 800 decimal digits scaled by 5^1150
+    static constexpr std::size_t capacity = 112;
 
-inline error_code check_and_skip(parser *p, char expected) {
-    char ch = *(p->str_cur);
-    if ( ch == expected ) {
-        p->str_cur++;
+    std::uint32_t limbs[capacity];
+    std::size_t size = 0;
 
-        return FJ_EC_OK;
+    explicit bigint(std::uint64_t v = 0) {
+        for ( ; v; v >>= 32 ) {
+            limbs[size++] = static_cast<std::uint32_t>(v);
+        }
     }
 
-    if ( ch == ((int)-1) ) {
-        return FJ_EC_INCOMPLETE;
+    bool is_zero() const { return size == 0; }
+
+    void mul(std::uint32_t m) {
+        std::uint64_t carry = 0;
+        for ( std::size_t i = 0; i < size; ++i ) {
+            carry += static_cast<std::uint64_t>(limbs[i]) * m;
+            limbs[i] = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        push(carry);
     }
+    void mul(std::uint64_t m) {
+        const auto hi = static_cast<std::uint32_t>(m >> 32);
+        if ( !hi ) {
+            mul(static_cast<std::uint32_t>(m));
 
-    return FJ_EC_INVALID;
-}
+            return;
+        }
 
-inline error_code escape_len(int *escape_len, const char *s, std::size_t len) {
-    switch ( *s ) {
-        case 'u': {
-            if ( len < 6 ) {
-                return FJ_EC_INCOMPLETE;
-            }
-            if ( fj_is_hex_digit4_macro(*(s+1), *(s+2), *(s+3), *(s+4)) ) {
-                *escape_len = 5;
+        bigint high{*this};
+        high.mul(hi);
+        high.shl(32);
+        mul(static_cast<std::uint32_t>(m));
+        add(high);
+    }
+    void add(std::uint32_t v) {
+        std::uint64_t carry = v;
+        for ( std::size_t i = 0; i < size && carry; ++i ) {
+            carry += limbs[i];
+            limbs[i] = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        push(carry);
+    }
+    void add(const bigint &r) {
+        const std::size_t n = size > r.size ? size : r.size;
+        std::uint64_t carry = 0;
+        for ( std::size_t i = 0; i < n; ++i ) {
+            carry += static_cast<std::uint64_t>(i < size ? limbs[i] : 0u) + (i < r.size ? r.limbs[i] : 0u);
+            limbs[i] = static_cast<std::uint32_t>(carry);
+            carry >>= 32;
+        }
+        size = n;
+        push(carry);
+    }
+    // requires the *this >= r
+    void sub(const bigint &r) {
+        std::int64_t borrow = 0;
+        for ( std::size_t i = 0; i < size; ++i ) {
+            borrow += static_cast<std::int64_t>(limbs[i]) - (i < r.size ? r.limbs[i] : 0u);
+            limbs[i] = static_cast<std::uint32_t>(borrow);
+            borrow = borrow < 0 ? -1 : 0;
+        }
+        assert(!borrow);
+        for ( ; size && !limbs[size - 1]; --size )
+            ;
+    }
+    void mul_pow5(std::uint64_t n) {
+        // 5^13 is the greatest one which fits into the limb
+        for ( ; n >= 13; n -= 13 ) {
+            mul(std::uint32_t{1220703125u});
+        }
+        static constexpr std::uint32_t small[] = {1, 5, 25, 125, 625, 3125, 15625, 78125
+            ,390625, 1953125, 9765625, 48828125, 244140625};
+        mul(small[n]);
+    }
+    void shl(std::uint64_t n) {
+        if ( !size ) {
+            return;
+        }
 
-                return FJ_EC_OK;
+        const auto limbs_n = static_cast<std::size_t>(n / 32);
+        const auto bits = static_cast<unsigned>(n % 32);
+        assert(size + limbs_n < capacity);
+        if ( bits ) {
+            std::uint32_t carry = 0;
+            for ( std::size_t i = 0; i < size; ++i ) {
+                const auto v = limbs[i];
+                limbs[i] = (v << bits) | carry;
+                carry = v >> (32 - bits);
             }
+            push(carry);
+        }
+        if ( limbs_n ) {
+            std::memmove(limbs + limbs_n, limbs, size * sizeof(limbs[0]));
+            std::memset(limbs, 0, limbs_n * sizeof(limbs[0]));
+            size += limbs_n;
+        }
+    }
 
-            return FJ_EC_INVALID;
+    friend int compare(const bigint &l, const bigint &r) {
+        if ( l.size != r.size ) {
+            return l.size < r.size ? -1 : 1;
         }
-        case '"':
-        case '\\':
-        case '/':
-        case 'b':
-        case 'f':
-        case 'n':
-        case 'r':
-        case 't': {
-            if ( len < 2 ) {
-                return FJ_EC_INCOMPLETE;
+        for ( std::size_t i = l.size; i--; ) {
+            if ( l.limbs[i] != r.limbs[i] ) {
+                return l.limbs[i] < r.limbs[i] ? -1 : 1;
             }
+        }
 
-            *escape_len = 1;
+        return 0;
+    }
 
-            return FJ_EC_OK;
+private:
+    void push(std::uint64_t v) {
+        for ( ; v; v >>= 32 ) {
+            assert(size < capacity);
+            limbs[size++] = static_cast<std::uint32_t>(v);
         }
     }
+};
 
-    return FJ_EC_INVALID;
-}
+// the T from the m * 2^e, where the m has the mantissa_bits + 1 bits, or less for the subnormals
+template<typename T>
+T make_float(bool neg, std::uint64_t m, std::int64_t e) {
+    using traits = float_traits<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr std::int64_t min_exp = 1 - traits::bias - traits::mantissa_bits;
+    constexpr std::int64_t max_exp = traits::bias - traits::mantissa_bits;
+    constexpr std::uint64_t hidden = 1ull << traits::mantissa_bits;
+
+    if ( e > max_exp ) {
+        return neg ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+    }
 
-/*************************************************************************************************/
+    const auto biased = m < hidden ? 0 : static_cast<std::uint64_t>(e - min_exp + 1);
+    const auto bits = static_cast<bits_type>((m & (hidden - 1))
+        | (biased << traits::mantissa_bits)
+        | (static_cast<std::uint64_t>(neg) << (sizeof(bits_type) * 8 - 1)))
+    ;
+    T res;
+    std::memcpy(&res, &bits, sizeof(bits));
 
-template<bool ParseMode, std::size_t ExLen>
-inline error_code expect(parser *p, const char (&s)[ExLen], const char **ptr, std::size_t *size) {
-    if ( p->str_cur + (ExLen-1) > p->str_end )
-        return FJ_EC_INCOMPLETE;
+    return res;
+}
 
-    if ( std::strncmp(p->str_cur, s, ExLen - 1) != 0 ) {
-        return FJ_EC_INVALID;
+// the hex integers, rounded to nearest even
+template<typename T>
+T parse_hex_float(const char *ptr, std::size_t len) {
+    constexpr int bits = float_traits<T>::mantissa_bits + 1;
+    const char *p = ptr;
+    const char *end = ptr + len;
+    const bool neg = *p == '-';
+    p += static_cast<std::size_t>(neg) + 2;
+
+    std::uint64_t m = 0;
+    std::int64_t e = 0;
+    bool sticky = false;
+    for ( ; p != end; ++p ) {
+        const auto ch = static_cast<std::uint64_t>(*p);
+        const auto digit = fj_is_digit_macro(*p) ? ch - '0' : (ch | 0x20u) - 'a' + 10;
+        if ( m >> 60 ) {
+            e += 4;
+            sticky |= digit != 0;
+        } else {
+            m = (m << 4) | digit;
+        }
+    }
+    if ( !m ) {
+        return neg ? -T{0} : T{0};
     }
 
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        *ptr = p->str_cur;
-        *size = ExLen - 1;
+    const int shift = 64 - clz64(m) - bits;
+    if ( shift <= 0 ) {
+        return make_float<T>(neg, m << -shift, e + shift);
     }
 
-    p->str_cur += ExLen - 1;
+    const std::uint64_t rest = m & ((1ull << shift) - 1);
+    const std::uint64_t half = 1ull << (shift - 1);
+    m >>= shift;
+    e += shift;
+    if ( rest > half || (rest == half && (sticky || (m & 1))) ) {
+        if ( ++m == (2ull << (bits - 1)) ) {
+            m >>= 1;
+            ++e;
+        }
+    }
 
-    return FJ_EC_OK;
+    return make_float<T>(neg, m, e);
 }
 
-template<bool ParseMode>
-inline error_code parse_string(parser *p, const char **value, std::size_t *vlen) {
-    auto ec = check_and_skip(p, '"');
-    if ( ec != FJ_EC_OK ) {
-        return ec;
+// the slow path, on the token span, without the copying and the locale:
+// the nearest candidate is taken from the leading 19 digits, then it's moved while
+// the value of all the digits is out of the halfway points to the neighbors,
+// see "How to Read Floating Point Numbers Accurately" by William D. Clinger (AlgorithmR).
+template<typename T>
+T parse_float_slow(const char *ptr, std::size_t len) {
+    using traits = float_traits<T>;
+    // the halfway points have up to 767 significant digits, the next ones only break the tie
+    constexpr std::size_t max_digits = 800;
+    constexpr std::int64_t min_exp = 1 - traits::bias - traits::mantissa_bits;
+    constexpr std::uint64_t hidden = 1ull << traits::mantissa_bits;
+
+    const char *p = ptr;
+    const char *end = ptr + len;
+    const bool neg = *p == '-';
+    p += static_cast<std::size_t>(neg);
+    if ( end - p > 1 && p[1] == 'x' ) {
+        return parse_hex_float<T>(ptr, len);
     }
 
-    std::uint8_t ch = 0;
-    auto *start = p->str_cur;
-    for ( std::size_t len = 0; p->str_cur < p->str_end; p->str_cur += len ) {
-        ch = *(p->str_cur);
-        len = fj_utf8_char_len((unsigned char)ch);
-        if ( !(ch >= 32 && len > 0) ) {
-            return FJ_EC_INVALID;
+    // the value is `big * 10^exp`, the leading digits are `w * 10^q`
+    bigint big;
+    std::int64_t exp = 0;
+    std::size_t digits = 0;
+    std::uint64_t w = 0;
+    std::int64_t q = 0;
+    bool sticky = false;
+    std::uint32_t chunk = 0;
+    std::uint32_t chunk_mul = 1;
+    const auto put_digit = [&](char ch, bool fraction) {
+        const auto d = static_cast<std::uint32_t>(ch - '0');
+        if ( !digits && !d ) {
+            exp -= static_cast<std::int64_t>(fraction);
+            q -= static_cast<std::int64_t>(fraction);
+            return;
         }
-        if ( static_cast<std::ptrdiff_t>(len) > (p->str_end - p->str_cur) ) {
-            return FJ_EC_INCOMPLETE;
+        if ( digits < 19 ) {
+            w = w * 10 + d;
+            q -= static_cast<std::int64_t>(fraction);
+        } else {
+            q += static_cast<std::int64_t>(!fraction);
         }
-
-        if ( ch == '\\' ) {
-            int n = 0;
-            ec = escape_len(&n, p->str_cur + 1, p->str_end - p->str_cur);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            len += n;
-        } else if ( ch == '"' ) {
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *value = start;
-                *vlen = p->str_cur - start;
+        if ( digits < max_digits ) {
+            ++digits;
+            chunk = chunk * 10 + d;
+            chunk_mul *= 10;
+            if ( chunk_mul == 1000000000u ) {
+                big.mul(chunk_mul);
+                big.add(chunk);
+                chunk = 0;
+                chunk_mul = 1;
             }
-
-            ++p->str_cur;
-
-            break;
+            exp -= static_cast<std::int64_t>(fraction);
+        } else {
+            exp += static_cast<std::int64_t>(!fraction);
+            sticky |= d != 0;
         }
+    };
+    for ( ; p != end && fj_is_digit_macro(*p); ++p ) {
+        put_digit(*p, false);
     }
-
-    return ch == '"' ? FJ_EC_OK : FJ_EC_INCOMPLETE;
-}
-
-template<bool ParseMode>
-inline error_code parse_number(parser *p, const char **value, std::size_t *vlen) {
-    auto *start = p->str_cur;
-    p->str_cur = (*(p->str_cur) == '-') ? p->str_cur + 1 : p->str_cur;
-    if ( p->str_cur >= p->str_end ) {
-        return FJ_EC_INCOMPLETE;
+    if ( p != end && *p == '.' ) {
+        for ( ++p; p != end && fj_is_digit_macro(*p); ++p ) {
+            put_digit(*p, true);
+        }
     }
-    if ( p->str_cur + 1 < p->str_end && *(p->str_cur) == '0' && *(p->str_cur+1) == 'x' ) {
-        p->str_cur += 2;
-        if ( p->str_cur >= p->str_end ) {
-            return FJ_EC_INCOMPLETE;
+    if ( p != end && (*p == 'e' || *p == 'E') ) {
+        ++p;
+        const bool eneg = p != end && *p == '-';
+        p += static_cast<std::size_t>(p != end && (*p == '-' || *p == '+'));
+        std::int64_t e = 0;
+        for ( ; p != end && fj_is_digit_macro(*p); ++p ) {
+            if ( e < 100000 ) {
+                e = e * 10 + (*p - '0');
+            }
         }
-        if ( !fj_is_hex_digit_macro(*(p->str_cur)) ) {
-            return FJ_EC_INVALID;
+        exp += eneg ? -e : e;
+        q += eneg ? -e : e;
+    }
+    if ( sticky ) {
+        // any digit in between of the halfway point and the next digits
+        chunk = chunk * 10 + 1;
+        chunk_mul *= 10;
+        --exp;
+    }
+    big.mul(chunk_mul);
+    big.add(chunk);
+
+    // the value is in [10^(digits+exp-1), 10^(digits+exp))
+    const auto magnitude = static_cast<std::int64_t>(digits) + exp;
+    if ( big.is_zero() || magnitude <= traits::min_pow10 ) {
+        return neg ? -T{0} : T{0};
+    }
+    if ( magnitude - 1 > traits::max_pow10 ) {
+        return neg ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+    }
+
+    // the candidate `m * 2^e`: the leading digits are scaled by the 64 bits of 5^q,
+    // the value is about `upper * 2^(floor(q * log2(10)) + 1 - lz)`
+    std::uint64_t m = 0;
+    std::int64_t e = min_exp;
+    if ( q >= -342 && q <= 308 ) {
+        const int lz = clz64(w);
+        const auto upper = mul_64x64(w << lz, pow5_128(q)[0]).hi;
+        const int bits = 64 - clz64(upper);
+        const std::int64_t uexp = ((217706 * q) >> 16) + 1 - lz;
+        e = uexp + bits - 1 - traits::mantissa_bits;
+        e = e < min_exp ? min_exp : e;
+        const auto shift = e - uexp;
+        m = shift >= 64 ? 0 : upper >> shift;
+        if ( e > traits::bias - traits::mantissa_bits ) {
+            m = hidden;
+            e = traits::bias - traits::mantissa_bits + 1;
         }
-        for ( ; p->str_cur < p->str_end && fj_is_hex_digit_macro(*(p->str_cur))
-              ; ++p->str_cur )
-        {}
+    }
+
+    // compares the value with the `hm * 2^he`
+    bigint scaled{big}; // the value, or the digits if the exp is negative
+    bigint pow5{1u};
+    if ( exp >= 0 ) {
+        scaled.mul_pow5(static_cast<std::uint64_t>(exp));
     } else {
-        if ( !fj_is_digit_macro(*(p->str_cur)) ) {
-            return FJ_EC_INVALID;
+        pow5.mul_pow5(static_cast<std::uint64_t>(-exp));
+    }
+    const auto cmp = [&](std::uint64_t hm, std::int64_t he) {
+        bigint l{scaled};
+        bigint r{pow5};
+        r.mul(hm);
+        // both are multiplied by 5^-exp * 2^-exp for the negative exp,
+        // then only the powers of two differ
+        const auto diff = he - exp;
+        if ( diff > 0 ) {
+            r.shl(static_cast<std::uint64_t>(diff));
+        } else {
+            l.shl(static_cast<std::uint64_t>(-diff));
         }
-        for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
-              ; ++p->str_cur )
-        {}
-        if ( p->str_cur < p->str_end && *(p->str_cur) == '.' ) {
-            p->str_cur++;
-            if ( p->str_cur >= p->str_end ) {
-                return FJ_EC_INCOMPLETE;
-            }
-            if ( !fj_is_digit_macro(*(p->str_cur)) ) {
-                return FJ_EC_INVALID;
+
+        return compare(l, r);
+    };
+    for ( ;; ) {
+        const bool is_inf = e > traits::bias - traits::mantissa_bits;
+        if ( !is_inf ) {
+            // the halfway to the next one
+            const int res = cmp(2 * m + 1, e - 1);
+            if ( res > 0 || (res == 0 && (m & 1)) ) {
+                if ( ++m == 2 * hidden ) {
+                    m = hidden;
+                    ++e;
+                }
+                continue;
             }
-            for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
-                  ; ++p->str_cur )
-            {}
         }
-        if ( p->str_cur < p->str_end && (*(p->str_cur) == 'e' || *(p->str_cur) == 'E') ) {
-            p->str_cur++;
-            if ( p->str_cur >= p->str_end ) {
-                return FJ_EC_INCOMPLETE;
-            }
-            if ( *(p->str_cur) == '+' || *(p->str_cur) == '-' ) {
-                p->str_cur++;
+        if ( m ) {
+            // the halfway to the previous one
+            const bool binade = m == hidden && e > min_exp;
+            const int res = binade ? cmp(4 * m - 1, e - 2) : cmp(2 * m - 1, e - 1);
+            if ( res < 0 || (res == 0 && (m & 1)) ) {
+                if ( binade ) {
+                    m = 2 * hidden - 1;
+                    --e;
+                } else {
+                    --m;
+                }
+                continue;
             }
-            if ( p->str_cur >= p->str_end ) {
-                return FJ_EC_INCOMPLETE;
+        }
+
+        return make_float<T>(neg, m, e);
+    }
+}
+
+// converts the JSON number in place, without copying
+template<typename T>
+T parse_float(const char *ptr, std::size_t len) {
+    const char *p = ptr;
+    const char *end = ptr + len;
+
+    const bool neg = p != end && *p == '-';
+    p += static_cast<std::size_t>(neg);
+
+    // up to 19 significant digits are fit into the 64 bits
+    std::uint64_t w = 0;
+    std::int64_t q = 0;
+    int digits = 0;
+    bool truncated = false;
+    for ( ; p != end && fj_is_digit_macro(*p); ++p ) {
+        if ( digits < 19 ) {
+            w = w * 10 + static_cast<std::uint64_t>(*p - '0');
+            digits += static_cast<int>(w != 0);
+        } else {
+            ++q;
+            truncated |= *p != '0';
+        }
+    }
+    if ( p != end && *p == '.' ) {
+        for ( ++p; p != end && fj_is_digit_macro(*p); ++p ) {
+            if ( digits < 19 ) {
+                w = w * 10 + static_cast<std::uint64_t>(*p - '0');
+                digits += static_cast<int>(w != 0);
+                --q;
+            } else {
+                truncated |= *p != '0';
             }
-            if ( !fj_is_digit_macro(*(p->str_cur)) ) {
-                return FJ_EC_INVALID;
+        }
+    }
+    if ( p != end && (*p == 'e' || *p == 'E') ) {
+        ++p;
+        const bool eneg = p != end && *p == '-';
+        p += static_cast<std::size_t>(p != end && (*p == '-' || *p == '+'));
+        std::int64_t e = 0;
+        for ( ; p != end && fj_is_digit_macro(*p); ++p ) {
+            if ( e < 100000 ) {
+                e = e * 10 + (*p - '0');
             }
-            for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
-                  ; ++p->str_cur )
-            {}
         }
+        q += eneg ? -e : e;
     }
-
-    if ( (p->str_cur - start) > 1 && (start[0] == '0' && start[1] != '.') ) {
-        return FJ_EC_INVALID;
+    if ( p != end ) {
+        return parse_float_slow<T>(ptr, len);
     }
 
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        *value = start;
-        *vlen = p->str_cur - start;
+    T res{};
+    if ( !truncated ) {
+        if ( eisel_lemire(w, q, neg, &res) ) {
+            return res;
+        }
+    } else {
+        // the value is between w and w+1, it's OK if both are rounded to the same
+        T res2{};
+        if ( eisel_lemire(w, q, neg, &res) && eisel_lemire(w + 1, q, neg, &res2) && res == res2 ) {
+            return res;
+        }
     }
 
-    return FJ_EC_OK;
+    return parse_float_slow<T>(ptr, len);
 }
 
-template<bool ParseMode>
-inline error_code parse_value(
-     parser *p
-    ,const char **value
-    ,std::size_t *vlen
-    ,token_type *toktype
-    ,token *parent
-);
+template<typename To>
+typename std::enable_if<std::is_same<To, double>::value, To>::type
+conv_to(const char *ptr, std::size_t len, To) {
+    return parse_float<double>(ptr, len);
+}
 
-template<bool ParseMode>
-inline error_code parse_array(parser *p, token *parent) {
-    auto ec = check_and_skip(p, '[');
-    if ( ec != FJ_EC_OK ) {
-        return ec;
-    }
+template<typename To>
+typename std::enable_if<std::is_same<To, float>::value, To>::type
+conv_to(const char *ptr, std::size_t len, To) {
+    return parse_float<float>(ptr, len);
+}
 
-    __FJ__CONSTEXPR_IF ( ParseMode ) {
-        if ( p->toks_cur == p->toks_end ) {
-            return FJ_EC_NO_FREE_TOKENS;
-        }
-    }
+template<typename To>
+typename std::enable_if<std::is_same<To, std::string>::value, To>::type
+conv_to(const char *ptr, std::size_t len, To) { return {ptr, len}; }
 
-    auto *startarr = p->toks_cur++;
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        startarr->type = FJ_TYPE_ARRAY;
-        startarr->flags = 1;
-        startarr->parent = parent;
-        if ( startarr->parent ) {
-            __FJ__CHECK_OVERFLOW(startarr->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-            ++startarr->parent->childs;
-        }
-    }
+template<typename To>
+typename std::enable_if<std::is_same<To, flatjson::string_view>::value, To>::type
+conv_to(const char *ptr, std::size_t len, To) { return {ptr, len}; }
 
-    while ( __FJ__CUR_CHAR(p) != ']' ) {
-        __FJ__CONSTEXPR_IF ( ParseMode ) {
-            if ( p->toks_cur == p->toks_end ) {
-                return FJ_EC_NO_FREE_TOKENS;
-            }
-        }
+/*************************************************************************************************/
+// the checked conversions
+
+// parses the 8 digits at once, see "Faster Integer Parsing" by Wojciech Mula
+inline std::uint64_t load_eight_bytes(const char *ptr) {
+    const auto *p = reinterpret_cast<const std::uint8_t *>(ptr);
+
+    return static_cast<std::uint64_t>(p[0])
+        | static_cast<std::uint64_t>(p[1]) << 8
+        | static_cast<std::uint64_t>(p[2]) << 16
+        | static_cast<std::uint64_t>(p[3]) << 24
+        | static_cast<std::uint64_t>(p[4]) << 32
+        | static_cast<std::uint64_t>(p[5]) << 40
+        | static_cast<std::uint64_t>(p[6]) << 48
+        | static_cast<std::uint64_t>(p[7]) << 56
+    ;
+}
 
-        auto *current_token = p->toks_cur++;
-        __FJ__CONSTEXPR_IF( ParseMode ) {
-            *current_token = token{};
-        }
-        char ch = *(p->str_cur);
-        if ( ch == '{' || ch == '[' ) {
-            p->toks_cur -= 1;
-        } else {
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                current_token->parent = startarr;
-                __FJ__CHECK_OVERFLOW(startarr->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-                ++startarr->childs;
-            }
-        }
+inline bool is_eight_digits(std::uint64_t v) {
+    return ((v & 0xf0f0f0f0f0f0f0f0ull) | (((v + 0x0606060606060606ull) & 0xf0f0f0f0f0f0f0f0ull) >> 4))
+        == 0x3333333333333333ull
+    ;
+}
 
-        std::size_t size = 0;
-        ec = parse_value<ParseMode>(
-             p
-            ,&(current_token->val)
-            ,&size
-            ,&(current_token->type)
-            ,startarr
-        );
-        if ( ec != FJ_EC_OK ) {
-            return ec;
-        }
-        __FJ__CONSTEXPR_IF( ParseMode ) {
-            startarr->flags = (startarr->flags == 0)
-                ? startarr->flags
-                : fj_is_simple_type_macro(current_token->type)
-            ;
-            __FJ__CHECK_OVERFLOW(size, FJ_VLEN_TYPE, FJ_EC_VLEN_OVERFLOW);
-            current_token->vlen = static_cast<FJ_VLEN_TYPE>(size);
+inline std::uint32_t parse_eight_digits(std::uint64_t v) {
+    v -= 0x3030303030303030ull;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000ff000000ffull) * (100 + (1000000ull << 32)))
+        + (((v >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32;
+
+    return static_cast<std::uint32_t>(v);
+}
+
+// only the digits are allowed, no sign, fraction or exponent
+inline error_code try_conv_uint64(const char *ptr, std::size_t len, std::uint64_t *out) {
+    const char *end = ptr + len;
+    if ( ptr == end ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
+    for ( ; end - ptr > 1 && *ptr == '0'; ++ptr )
+        ;
+
+    std::uint64_t res = 0;
+    const char *p = ptr;
+    for ( ; end - p >= 8; p += 8 ) {
+        const auto v = load_eight_bytes(p);
+        if ( !is_eight_digits(v) || p - ptr >= 16 ) {
+            break;
         }
+        res = res * 100000000u + parse_eight_digits(v);
+    }
+    for ( ; p != end && fj_is_digit_macro(*p) && p - ptr < 19; ++p ) {
+        res = res * 10 + static_cast<std::uint64_t>(*p - '0');
+    }
+    if ( p == end ) {
+        *out = res;
 
-        if ( __FJ__CUR_CHAR(p) == ',' ) {
-            p->str_cur++;
-            if ( *(p->str_cur) == ']' ) {
-                return FJ_EC_INVALID;
-            }
+        return FJ_EC_OK;
+    }
+    if ( !fj_is_digit_macro(*p) ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
+
+    // the 20th digit
+    const auto digit = static_cast<std::uint64_t>(*p - '0');
+    for ( const char *it = p + 1; it != end; ++it ) {
+        if ( !fj_is_digit_macro(*it) ) {
+            return FJ_EC_NOT_CONVERTIBLE;
         }
     }
+    if ( p + 1 != end || res > (UINT64_MAX - digit) / 10 ) {
+        return FJ_EC_VALUE_OVERFLOW;
+    }
+    *out = res * 10 + digit;
 
-    ec = check_and_skip(p, ']');
+    return FJ_EC_OK;
+}
+
+template<typename To>
+typename std::enable_if<
+    (std::is_integral<To>::value && std::is_unsigned<To>::value) &&
+    !std::is_same<To, bool>::value, error_code
+>::type
+try_conv(const char *ptr, std::size_t len, To *out) {
+    std::uint64_t res;
+    auto ec = try_conv_uint64(ptr, len, &res);
     if ( ec != FJ_EC_OK ) {
         return ec;
     }
-
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        if ( p->toks_cur == p->toks_end ) {
-            return FJ_EC_NO_FREE_TOKENS;
-        }
-        auto *endarr = p->toks_cur++;
-        *endarr = token{};
-        endarr->type = FJ_TYPE_ARRAY_END;
-        endarr->parent = startarr;
-        __FJ__CHECK_OVERFLOW(endarr->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-        ++endarr->parent->childs;
-        startarr->end = endarr;
-    } else {
-        ++p->toks_cur;
+    if ( res > (std::numeric_limits<To>::max)() ) {
+        return FJ_EC_VALUE_OVERFLOW;
     }
+    *out = static_cast<To>(res);
 
     return FJ_EC_OK;
 }
 
-template<bool ParseMode>
-inline error_code parse_object(parser *p, token *parent) {
-    auto ec = check_and_skip(p, '{');
+template<typename To>
+typename std::enable_if<
+    (std::is_integral<To>::value && std::is_signed<To>::value) &&
+    !std::is_same<To, bool>::value, error_code
+>::type
+try_conv(const char *ptr, std::size_t len, To *out) {
+    using UnsignedTo = typename std::make_unsigned<To>::type;
+
+    const bool neg = len && *ptr == '-';
+    const auto skip = static_cast<std::size_t>(neg);
+    std::uint64_t res;
+    auto ec = try_conv_uint64(ptr + skip, len - skip, &res);
     if ( ec != FJ_EC_OK ) {
         return ec;
     }
 
-    __FJ__CONSTEXPR_IF ( ParseMode ) {
-        if ( p->toks_cur == p->toks_end ) {
-            return FJ_EC_NO_FREE_TOKENS;
-        }
+    const auto max = static_cast<std::uint64_t>((std::numeric_limits<To>::max)());
+    if ( res > max + static_cast<std::uint64_t>(neg) ) {
+        return FJ_EC_VALUE_OVERFLOW;
     }
+    // the two's complement negation, is valid for the min() too
+    *out = neg
+        ? static_cast<To>(static_cast<UnsignedTo>(~static_cast<UnsignedTo>(res) + 1u))
+        : static_cast<To>(res)
+    ;
 
-    auto *startobj = p->toks_cur++;
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        startobj->type = FJ_TYPE_OBJECT;
-        startobj->flags = 1;
-        startobj->parent = parent;
-        if ( startobj->parent ) {
-            __FJ__CHECK_OVERFLOW(startobj->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-            ++startobj->parent->childs;
-        }
+    return FJ_EC_OK;
+}
+
+template<typename To>
+typename std::enable_if<std::is_same<To, bool>::value, error_code>::type
+try_conv(const char *ptr, std::size_t len, To *out) {
+    if ( len == 4 && std::memcmp(ptr, "true", 4) == 0 ) {
+        *out = true;
+    } else if ( len == 5 && std::memcmp(ptr, "false", 5) == 0 ) {
+        *out = false;
+    } else {
+        return FJ_EC_NOT_CONVERTIBLE;
     }
 
-    while ( __FJ__CUR_CHAR(p) != '}' ) {
-        char ch = *(p->str_cur);
-        if ( ch != '"' ) {
-            if ( ch == ((int)-1) ) {
-                return FJ_EC_INCOMPLETE;
-            }
+    return FJ_EC_OK;
+}
 
-            return FJ_EC_INVALID;
-        }
+template<typename To>
+typename std::enable_if<std::is_floating_point<To>::value, error_code>::type
+try_conv(const char *ptr, std::size_t len, To *out) {
+    if ( !len ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
 
-        __FJ__CONSTEXPR_IF ( ParseMode ) {
-            if ( p->toks_cur == p->toks_end ) {
-                return FJ_EC_NO_FREE_TOKENS;
-            }
-        }
+    const auto res = conv_to(ptr, len, To{});
+    if ( res == std::numeric_limits<To>::infinity() || res == -std::numeric_limits<To>::infinity() ) {
+        return FJ_EC_VALUE_OVERFLOW;
+    }
+    *out = res;
 
-        auto *current_token = p->toks_cur++;
-        __FJ__CONSTEXPR_IF( ParseMode ) {
-            *current_token = token{};
+    return FJ_EC_OK;
+}
+
+template<typename To>
+typename std::enable_if<
+    std::is_same<To, std::string>::value || std::is_same<To, flatjson::string_view>::value, error_code
+>::type
+try_conv(const char *ptr, std::size_t len, To *out) {
+    *out = To{ptr, len};
+
+    return FJ_EC_OK;
+}
+
+} // ns details
+
+/*************************************************************************************************/
+
+// the bits of token::flags
+enum token_flag: std::uint8_t {
+     FJ_FLAG_SIMPLE_CHILDS = 1u << 0 // OBJECT/ARRAY: all the members are of simple types
+    ,FJ_FLAG_KEY_ESCAPED   = 1u << 1 // the key contains escapes
+    ,FJ_FLAG_VALUE_ESCAPED = 1u << 2 // STRING: the value contains escapes
+    // NUMBER only, see iterator::number_kind()
+    ,FJ_FLAG_NUM_NEGATIVE  = 1u << 3 // has the leading '-'
+    ,FJ_FLAG_NUM_INTEGER   = 1u << 4 // no fraction and no exponent
+    ,FJ_FLAG_NUM_HEX       = 1u << 5 // has the '0x' prefix
+    ,FJ_FLAG_NUM_FITS_64   = 1u << 6 // fits into std::uint64_t, or into std::int64_t if negative
+};
+
+/*************************************************************************************************/
+// 40 bytes for now
+struct token {
+    union {
+        const char *key;
+        const void *index; // for OBJECT_END/ARRAY_END only: the lookup index, see build_index()
+    };
+    const char *val;
+    token *parent;
+    token *end;
+    FJ_CHILDS_TYPE childs;
+    FJ_VLEN_TYPE vlen;
+    FJ_KLEN_TYPE klen;
+    token_type type;
+    std::uint8_t flags;
+    std::uint8_t khash; // the short hash of the key, see details::key_hash8()
+};
+
+/*************************************************************************************************/
+
+using alloc_fnptr = void*(*)(std::size_t);
+using free_fnptr = void(*)(void *);
+
+namespace details {
+
+// the chunk of the bump allocator: the side arena of the parser where the lookup indexes
+// are living, and flatjson::arena
+struct arena_chunk {
+    arena_chunk *next;
+    std::size_t size;
+    std::size_t used;
+};
+
+// allocates from the head chunk, or from the new one which becomes the head.
+// the sizes are aligned to 8 bytes. returns nullptr if the `alloc_fn` fails.
+inline void* chunk_alloc(arena_chunk *&head, std::size_t size, std::size_t chunk_size, alloc_fnptr alloc_fn) {
+    size = (size + 7u) & ~static_cast<std::size_t>(7u);
+
+    auto *chunk = head;
+    if ( !chunk || chunk->size - chunk->used < size ) {
+        chunk_size = (std::max)(size, chunk_size);
+        chunk = static_cast<arena_chunk *>(alloc_fn(sizeof(arena_chunk) + chunk_size));
+        if ( !chunk ) {
+            return nullptr;
         }
-        std::size_t size = 0;
-        ec = parse_value<ParseMode>(
-             p
-            ,&(current_token->key)
-            ,&size
-            ,&(current_token->type)
-            ,startobj
+        chunk->next = head;
+        chunk->size = chunk_size;
+        chunk->used = 0;
+        head = chunk;
+    }
+
+    void *ptr = reinterpret_cast<char *>(chunk + 1) + chunk->used;
+    chunk->used += size;
+
+    return ptr;
+}
+
+inline void chunk_free_all(arena_chunk *&head, free_fnptr free_fn) {
+    while ( head ) {
+        auto *next = head->next;
+        free_fn(head);
+        head = next;
+    }
+}
+
+} // ns details
+
+struct parser {
+    const char *str_beg;
+    const char *str_cur;
+    const char *str_end;
+
+    token *toks_beg;
+    token *toks_cur;
+    token *toks_end;
+
+    details::arena_chunk *arena;
+
+    alloc_fnptr alloc_fn;
+    free_fnptr  free_fn;
+    error_code  error;
+    bool dyn_tokens;
+    bool dyn_parser;
+    std::uint32_t ref_cnt;
+
+    static std::size_t inc_refcnt(parser *parser) { return ++parser->ref_cnt; }
+    static std::size_t dec_refcnt(parser *parser) { return --parser->ref_cnt; }
+};
+
+/*************************************************************************************************/
+
+namespace details {
+
+/*************************************************************************************************/
+// for debug purposes
+
+inline void dump_tokens_impl(
+     std::FILE *stream
+    ,const token *beg
+    ,const token *cur
+    ,const token *end
+    ,std::size_t indent)
+{
+    static const char* tnames[] = {
+         "INV" // invalid type
+        ,"STR" // string type
+        ,"NUM" // number type
+        ,"BOL" // bool type
+        ,"NUL" // null type
+        ,"+OB" // start object
+        ,"-OB" // and object
+        ,"+AR" // start array
+        ,"-AR" // end array
+    };
+    static const char spaces[] = "                                                         ";
+
+    int local_indent = 0;
+    for ( auto it = beg; it != end; ++it ) {
+        if ( it->type == FJ_TYPE_ARRAY_END || it->type == FJ_TYPE_OBJECT_END ) {
+            assert(indent > 0);
+            local_indent -= static_cast<int>(indent);
+        }
+        std::fprintf(stream, "%3d:%c type=%.*s%3s, addr=%p, end=%p, parent=%p, childs=%d, key=\"%.*s\", val=\"%.*s\"\n"
+            ,(int)(it - beg)
+            ,(it == cur ? '>' : ' ')
+            ,local_indent, spaces, tnames[it->type]
+            ,it
+            ,it->end
+            ,it->parent
+            ,(int)it->childs
+            ,(int)(it->klen ? it->klen : 5), (it->klen ? it->key : "(nil)")
+            ,(int)(it->vlen ? it->vlen : 5), (it->vlen ? it->val : "(nil)")
         );
-        if ( ec != FJ_EC_OK ) {
-            return ec;
+        std::fflush(stream);
+        if ( it->type == FJ_TYPE_ARRAY || it->type == FJ_TYPE_OBJECT ) {
+            local_indent += static_cast<int>(indent);
+        }
+    }
+}
+
+// dump using parser
+inline void dump_tokens(std::FILE *stream, const char *caption, parser *parser, std::size_t indent = 3) {
+    std::fprintf(stream, "%s:\n", caption);
+    dump_tokens_impl(stream, parser->toks_beg, parser->toks_beg, parser->toks_end, indent);
+}
+
+/*************************************************************************************************/
+
+inline const char* fj_skip_ws(const char *s) {
+    constexpr bool t = true;
+    constexpr bool f = false;
+    static const bool map[] = {
+         f,f,f,f,f,f,f,f,f,t,t,f,f,t,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,t,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+        ,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f,f
+    };
+    static_assert(sizeof(map) == 256, "");
+
+    for ( ;map[static_cast<std::uint8_t>(*s)]; ++s );
+
+    return s;
+}
+
+#define __FJ__CUR_CHAR(p) \
+    ((p->str_cur = fj_skip_ws(p->str_cur)), (*(p->str_cur) == 0 ? ((int)-1) : *(p->str_cur)))
+
+inline error_code check_and_skip(parser *p, char expected) {
+    char ch = *(p->str_cur);
+    if ( ch == expected ) {
+        p->str_cur++;
+
+        return FJ_EC_OK;
+    }
+
+    if ( ch == ((int)-1) ) {
+        return FJ_EC_INCOMPLETE;
+    }
+
+    return FJ_EC_INVALID;
+}
+
+inline error_code escape_len(int *escape_len, const char *s, std::size_t len) {
+    switch ( *s ) {
+        case 'u': {
+            if ( len < 6 ) {
+                return FJ_EC_INCOMPLETE;
+            }
+            if ( fj_is_hex_digit4_macro(*(s+1), *(s+2), *(s+3), *(s+4)) ) {
+                *escape_len = 5;
+
+                return FJ_EC_OK;
+            }
+
+            return FJ_EC_INVALID;
+        }
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't': {
+            if ( len < 2 ) {
+                return FJ_EC_INCOMPLETE;
+            }
+
+            *escape_len = 1;
+
+            return FJ_EC_OK;
+        }
+    }
+
+    return FJ_EC_INVALID;
+}
+
+/*************************************************************************************************/
+// FNV-1a
+
+inline std::uint32_t key_hash(const char *key, std::size_t klen) {
+    std::uint32_t h = 2166136261u;
+    for ( const auto *it = key, *end = key + klen; it != end; ++it ) {
+        h ^= static_cast<std::uint8_t>(*it);
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+// the short hash is stored in each token to reject the mismatched keys by one compare
+inline std::uint8_t key_hash8(std::uint32_t h) {
+#ifdef __FJ__DONT_HASH_KEYS
+    (void)h;
+    return 0;
+#else
+    h ^= h >> 16;
+    h ^= h >> 8;
+
+    return static_cast<std::uint8_t>(h);
+#endif // __FJ__DONT_HASH_KEYS
+}
+
+/*************************************************************************************************/
+
+template<bool ParseMode, std::size_t ExLen>
+inline error_code expect(parser *p, const char (&s)[ExLen], const char **ptr, std::size_t *size) {
+    if ( p->str_cur + (ExLen-1) > p->str_end )
+        return FJ_EC_INCOMPLETE;
+
+    if ( std::strncmp(p->str_cur, s, ExLen - 1) != 0 ) {
+        return FJ_EC_INVALID;
+    }
+
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        *ptr = p->str_cur;
+        *size = ExLen - 1;
+    }
+
+    p->str_cur += ExLen - 1;
+
+    return FJ_EC_OK;
+}
+
+template<bool ParseMode>
+inline error_code parse_string(parser *p, const char **value, std::size_t *vlen, std::uint8_t *flags) {
+    auto ec = check_and_skip(p, '"');
+    if ( ec != FJ_EC_OK ) {
+        return ec;
+    }
+
+    std::uint8_t ch = 0;
+    bool escaped = false;
+    auto *start = p->str_cur;
+    for ( std::size_t len = 0; p->str_cur < p->str_end; p->str_cur += len ) {
+        ch = *(p->str_cur);
+        len = fj_utf8_char_len((unsigned char)ch);
+        if ( !(ch >= 32 && len > 0) ) {
+            return FJ_EC_INVALID;
+        }
+        if ( static_cast<std::ptrdiff_t>(len) > (p->str_end - p->str_cur) ) {
+            return FJ_EC_INCOMPLETE;
+        }
+
+        if ( ch == '\\' ) {
+            int n = 0;
+            ec = escape_len(&n, p->str_cur + 1, p->str_end - p->str_cur);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            len += n;
+            escaped = true;
+        } else if ( ch == '"' ) {
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *value = start;
+                *vlen = p->str_cur - start;
+                *flags = escaped ? FJ_FLAG_VALUE_ESCAPED : 0;
+            }
+
+            ++p->str_cur;
+
+            break;
+        }
+    }
+
+    return ch == '"' ? FJ_EC_OK : FJ_EC_INCOMPLETE;
+}
+
+// the number kind for the token::flags
+inline std::uint8_t number_flags(const char *ptr, std::size_t len, bool is_hex, bool is_integer) {
+    std::uint8_t flags = 0;
+    const bool neg = len && *ptr == '-';
+    if ( neg ) {
+        flags |= FJ_FLAG_NUM_NEGATIVE;
+        ++ptr;
+        --len;
+    }
+    if ( !is_integer ) {
+        return flags;
+    }
+
+    flags |= FJ_FLAG_NUM_INTEGER;
+    if ( is_hex ) {
+        flags |= FJ_FLAG_NUM_HEX;
+        ptr += 2;
+        len -= 2;
+    }
+    for ( ; len > 1 && *ptr == '0'; ++ptr, --len )
+        ;
+
+    bool fits;
+    if ( is_hex ) {
+        // INT64_MIN is -0x8000000000000000
+        fits = len < 16 || (len == 16 && (!neg || *ptr < '8'
+            || (*ptr == '8' && std::memcmp(ptr + 1, "000000000000000", 15) == 0)));
+    } else {
+        static const char u64max[] = "18446744073709551615";
+        static const char i64min[] = "9223372036854775808";
+        const char *lim = neg ? i64min : u64max;
+        const std::size_t limlen = neg ? sizeof(i64min) - 1 : sizeof(u64max) - 1;
+        fits = len < limlen || (len == limlen && std::memcmp(ptr, lim, len) <= 0);
+    }
+    if ( fits ) {
+        flags |= FJ_FLAG_NUM_FITS_64;
+    }
+
+    return flags;
+}
+
+// the same, but finds the fraction, the exponent and the '0x' by itself
+inline std::uint8_t number_flags(const char *ptr, std::size_t len) {
+    bool is_hex = false;
+    bool is_integer = true;
+    for ( const char *it = ptr, *end = ptr + len; it != end; ++it ) {
+        is_hex |= *it == 'x';
+        is_integer &= *it != '.' && ((*it != 'e' && *it != 'E') || is_hex);
+    }
+
+    return number_flags(ptr, len, is_hex, is_integer);
+}
+
+template<bool ParseMode>
+inline error_code parse_number(parser *p, const char **value, std::size_t *vlen, std::uint8_t *flags) {
+    auto *start = p->str_cur;
+    bool is_hex = false;
+    bool is_integer = true;
+    p->str_cur = (*(p->str_cur) == '-') ? p->str_cur + 1 : p->str_cur;
+    if ( p->str_cur >= p->str_end ) {
+        return FJ_EC_INCOMPLETE;
+    }
+    if ( p->str_cur + 1 < p->str_end && *(p->str_cur) == '0' && *(p->str_cur+1) == 'x' ) {
+        is_hex = true;
+        p->str_cur += 2;
+        if ( p->str_cur >= p->str_end ) {
+            return FJ_EC_INCOMPLETE;
+        }
+        if ( !fj_is_hex_digit_macro(*(p->str_cur)) ) {
+            return FJ_EC_INVALID;
+        }
+        for ( ; p->str_cur < p->str_end && fj_is_hex_digit_macro(*(p->str_cur))
+              ; ++p->str_cur )
+        {}
+    } else {
+        if ( !fj_is_digit_macro(*(p->str_cur)) ) {
+            return FJ_EC_INVALID;
+        }
+        for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
+              ; ++p->str_cur )
+        {}
+        if ( p->str_cur < p->str_end && *(p->str_cur) == '.' ) {
+            is_integer = false;
+            p->str_cur++;
+            if ( p->str_cur >= p->str_end ) {
+                return FJ_EC_INCOMPLETE;
+            }
+            if ( !fj_is_digit_macro(*(p->str_cur)) ) {
+                return FJ_EC_INVALID;
+            }
+            for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
+                  ; ++p->str_cur )
+            {}
+        }
+        if ( p->str_cur < p->str_end && (*(p->str_cur) == 'e' || *(p->str_cur) == 'E') ) {
+            is_integer = false;
+            p->str_cur++;
+            if ( p->str_cur >= p->str_end ) {
+                return FJ_EC_INCOMPLETE;
+            }
+            if ( *(p->str_cur) == '+' || *(p->str_cur) == '-' ) {
+                p->str_cur++;
+            }
+            if ( p->str_cur >= p->str_end ) {
+                return FJ_EC_INCOMPLETE;
+            }
+            if ( !fj_is_digit_macro(*(p->str_cur)) ) {
+                return FJ_EC_INVALID;
+            }
+            for ( ; p->str_cur < p->str_end && fj_is_digit_macro(*(p->str_cur))
+                  ; ++p->str_cur )
+            {}
+        }
+    }
+
+    if ( (p->str_cur - start) > 1 && (start[0] == '0' && start[1] != '.') ) {
+        return FJ_EC_INVALID;
+    }
+
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        *value = start;
+        *vlen = p->str_cur - start;
+        *flags = number_flags(start, *vlen, is_hex, is_integer);
+    }
+
+    return FJ_EC_OK;
+}
+
+// the `flags` are set for the simple types only, the containers are setting their own
+template<bool ParseMode>
+inline error_code parse_value(
+     parser *p
+    ,const char **value
+    ,std::size_t *vlen
+    ,token_type *toktype
+    ,token *parent
+    ,std::uint8_t *flags
+);
+
+template<bool ParseMode>
+inline error_code parse_array(parser *p, token *parent) {
+    auto ec = check_and_skip(p, '[');
+    if ( ec != FJ_EC_OK ) {
+        return ec;
+    }
+
+    __FJ__CONSTEXPR_IF ( ParseMode ) {
+        if ( p->toks_cur == p->toks_end ) {
+            return FJ_EC_NO_FREE_TOKENS;
+        }
+    }
+
+    auto *startarr = p->toks_cur++;
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        startarr->type = FJ_TYPE_ARRAY;
+        startarr->val = p->str_cur - 1;
+        startarr->flags = FJ_FLAG_SIMPLE_CHILDS;
+        startarr->parent = parent;
+        if ( startarr->parent ) {
+            __FJ__CHECK_OVERFLOW(startarr->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+            ++startarr->parent->childs;
+        }
+    }
+
+    while ( __FJ__CUR_CHAR(p) != ']' ) {
+        __FJ__CONSTEXPR_IF ( ParseMode ) {
+            if ( p->toks_cur == p->toks_end ) {
+                return FJ_EC_NO_FREE_TOKENS;
+            }
+        }
+
+        auto *current_token = p->toks_cur++;
+        __FJ__CONSTEXPR_IF( ParseMode ) {
+            *current_token = token{};
+        }
+        char ch = *(p->str_cur);
+        if ( ch == '{' || ch == '[' ) {
+            p->toks_cur -= 1;
+        } else {
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                current_token->parent = startarr;
+                __FJ__CHECK_OVERFLOW(startarr->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+                ++startarr->childs;
+            }
+        }
+
+        std::size_t size = 0;
+        ec = parse_value<ParseMode>(
+             p
+            ,&(current_token->val)
+            ,&size
+            ,&(current_token->type)
+            ,startarr
+            ,&(current_token->flags)
+        );
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+        __FJ__CONSTEXPR_IF( ParseMode ) {
+            if ( !fj_is_simple_type_macro(current_token->type) ) {
+                startarr->flags &= ~FJ_FLAG_SIMPLE_CHILDS;
+            }
+            __FJ__CHECK_OVERFLOW(size, FJ_VLEN_TYPE, FJ_EC_VLEN_OVERFLOW);
+            current_token->vlen = static_cast<FJ_VLEN_TYPE>(size);
+        }
+
+        if ( __FJ__CUR_CHAR(p) == ',' ) {
+            p->str_cur++;
+            if ( *(p->str_cur) == ']' ) {
+                return FJ_EC_INVALID;
+            }
+        }
+    }
+
+    ec = check_and_skip(p, ']');
+    if ( ec != FJ_EC_OK ) {
+        return ec;
+    }
+
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        if ( p->toks_cur == p->toks_end ) {
+            return FJ_EC_NO_FREE_TOKENS;
+        }
+        auto *endarr = p->toks_cur++;
+        *endarr = token{};
+        endarr->type = FJ_TYPE_ARRAY_END;
+        endarr->val = p->str_cur - 1;
+        endarr->parent = startarr;
+        __FJ__CHECK_OVERFLOW(endarr->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+        ++endarr->parent->childs;
+        startarr->end = endarr;
+    } else {
+        ++p->toks_cur;
+    }
+
+    return FJ_EC_OK;
+}
+
+template<bool ParseMode>
+inline error_code parse_object(parser *p, token *parent) {
+    auto ec = check_and_skip(p, '{');
+    if ( ec != FJ_EC_OK ) {
+        return ec;
+    }
+
+    __FJ__CONSTEXPR_IF ( ParseMode ) {
+        if ( p->toks_cur == p->toks_end ) {
+            return FJ_EC_NO_FREE_TOKENS;
+        }
+    }
+
+    auto *startobj = p->toks_cur++;
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        startobj->type = FJ_TYPE_OBJECT;
+        startobj->val = p->str_cur - 1;
+        startobj->flags = FJ_FLAG_SIMPLE_CHILDS;
+        startobj->parent = parent;
+        if ( startobj->parent ) {
+            __FJ__CHECK_OVERFLOW(startobj->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+            ++startobj->parent->childs;
+        }
+    }
+
+    while ( __FJ__CUR_CHAR(p) != '}' ) {
+        char ch = *(p->str_cur);
+        if ( ch != '"' ) {
+            if ( ch == ((int)-1) ) {
+                return FJ_EC_INCOMPLETE;
+            }
+
+            return FJ_EC_INVALID;
+        }
+
+        __FJ__CONSTEXPR_IF ( ParseMode ) {
+            if ( p->toks_cur == p->toks_end ) {
+                return FJ_EC_NO_FREE_TOKENS;
+            }
+        }
+
+        auto *current_token = p->toks_cur++;
+        __FJ__CONSTEXPR_IF( ParseMode ) {
+            *current_token = token{};
+        }
+        std::size_t size = 0;
+        std::uint8_t key_flags = 0;
+        ec = parse_value<ParseMode>(
+             p
+            ,&(current_token->key)
+            ,&size
+            ,&(current_token->type)
+            ,startobj
+            ,&key_flags
+        );
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+        __FJ__CONSTEXPR_IF( ParseMode ) {
+            __FJ__CHECK_OVERFLOW(size, FJ_KLEN_TYPE, FJ_EC_KLEN_OVERFLOW);
+            current_token->klen = static_cast<FJ_KLEN_TYPE>(size);
+#ifndef __FJ__DONT_HASH_KEYS
+            current_token->khash = key_hash8(key_hash(current_token->key, size));
+#endif // __FJ__DONT_HASH_KEYS
+        }
+
+        ec = check_and_skip(p, ':');
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+
+        ch = __FJ__CUR_CHAR(p);
+        if ( ch == '[' || ch == '{' ) {
+            p->toks_cur -= 1;
+            const char *unused_str;
+            std::size_t unused_size;
+            ec = parse_value<ParseMode>(
+                 p
+                ,&unused_str
+                ,&unused_size
+                ,&(current_token->type)
+                ,startobj
+                ,&(current_token->flags)
+            );
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                startobj->flags &= ~FJ_FLAG_SIMPLE_CHILDS;
+            }
+        } else {
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                current_token->parent = startobj;
+                __FJ__CHECK_OVERFLOW(startobj->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+                ++startobj->childs;
+            }
+
+            ec = parse_value<ParseMode>(
+                 p
+                ,&(current_token->val)
+                ,&size
+                ,&(current_token->type)
+                ,startobj
+                ,&(current_token->flags)
+            );
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                __FJ__CHECK_OVERFLOW(size, FJ_VLEN_TYPE, FJ_EC_VLEN_OVERFLOW);
+                current_token->vlen = static_cast<FJ_VLEN_TYPE>(size);
+            }
+        }
+
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+        __FJ__CONSTEXPR_IF( ParseMode ) {
+            if ( key_flags & FJ_FLAG_VALUE_ESCAPED ) {
+                current_token->flags |= FJ_FLAG_KEY_ESCAPED;
+            }
+        }
+
+        if ( __FJ__CUR_CHAR(p) == ',' ) {
+            p->str_cur++;
+            if ( *(p->str_cur) == '}' ) {
+                return FJ_EC_INVALID;
+            }
+        }
+    }
+
+    ec = check_and_skip(p, '}');
+    if ( ec != FJ_EC_OK ) {
+        return ec;
+    }
+
+    __FJ__CONSTEXPR_IF( ParseMode ) {
+        if ( p->toks_cur == p->toks_end ) {
+            return FJ_EC_NO_FREE_TOKENS;
+        }
+        auto *endobj = p->toks_cur++;
+        *endobj = token{};
+        endobj->type = FJ_TYPE_OBJECT_END;
+        endobj->val = p->str_cur - 1;
+        endobj->parent = startobj;
+        __FJ__CHECK_OVERFLOW(endobj->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
+        endobj->parent->childs += 1;
+        startobj->end = endobj;
+    } else {
+        ++p->toks_cur;
+    }
+
+    return FJ_EC_OK;
+}
+
+template<bool ParseMode>
+inline error_code parse_value(
+     parser *p
+    ,const char **value
+    ,std::size_t *vlen
+    ,token_type *toktype
+    ,token *parent
+    ,std::uint8_t *flags)
+{
+    char ch = __FJ__CUR_CHAR(p);
+    switch ( ch ) {
+        case '{': {
+            auto ec = parse_object<ParseMode>(p, parent);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_OBJECT;
+            }
+            break;
+        }
+        case '[': {
+            auto ec = parse_array<ParseMode>(p, parent);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_ARRAY;
+            }
+            break;
+        }
+        case 'n': {
+            auto ec = expect<ParseMode>(p, "null", value, vlen);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            // on root token
+            if ( p->toks_cur == p->toks_beg ) {
+                ++p->toks_cur;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_NULL;
+                *flags = 0;
+            }
+            break;
+        }
+        case 't': {
+            auto ec = expect<ParseMode>(p, "true", value, vlen);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            // on root token
+            if ( p->toks_cur == p->toks_beg ) {
+                ++p->toks_cur;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_BOOL;
+                *flags = 0;
+            }
+            break;
+        }
+        case 'f': {
+            auto ec = expect<ParseMode>(p, "false", value, vlen);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            // on root token
+            if ( p->toks_cur == p->toks_beg ) {
+                ++p->toks_cur;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_BOOL;
+                *flags = 0;
+            }
+            break;
+        }
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+            auto ec = parse_number<ParseMode>(p, value, vlen, flags);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            // on root token
+            if ( p->toks_cur == p->toks_beg ) {
+                ++p->toks_cur;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_NUMBER;
+            }
+            break;
+        }
+        case '"': {
+            auto ec = parse_string<ParseMode>(p, value, vlen, flags);
+            if ( ec != FJ_EC_OK ) {
+                return ec;
+            }
+            // on root token
+            if ( p->toks_cur == p->toks_beg ) {
+                ++p->toks_cur;
+            }
+            __FJ__CONSTEXPR_IF( ParseMode ) {
+                *toktype = FJ_TYPE_STRING;
+            }
+            break;
+        }
+        default:
+            if ( ch == ((int)-1) ) {
+                return FJ_EC_INCOMPLETE;
+            } else {
+                return FJ_EC_INVALID;
+            }
+    }
+
+    return FJ_EC_OK;
+}
+
+/*************************************************************************************************/
+
+inline void init_parser(
+     parser *p
+    ,token *toksbeg
+    ,token *toksend
+    ,const char *strbeg
+    ,const char *strend
+    ,alloc_fnptr alloc_fn
+    ,free_fnptr free_fn
+    ,bool dyn_parser
+    ,bool dyn_tokens)
+{
+    // root token
+    if ( toksbeg ) {
+        toksbeg->type   = FJ_TYPE_INVALID;
+        toksbeg->key    = nullptr;
+        toksbeg->klen   = 0;
+        toksbeg->val    = nullptr;
+        toksbeg->vlen   = 0;
+        toksbeg->parent = nullptr;
+        toksbeg->childs = 0;
+        toksbeg->end    = nullptr;
+        toksbeg->khash  = 0;
+    }
+
+    p->str_beg   = strbeg;
+    p->str_cur   = strbeg;
+    p->str_end   = strend;
+    p->toks_beg  = toksbeg;
+    p->toks_cur  = toksbeg;
+    p->toks_end  = toksend;
+    p->arena     = nullptr;
+    p->alloc_fn  = alloc_fn;
+    p->free_fn   = free_fn;
+    p->error     = FJ_EC_INVALID;
+    p->dyn_parser= dyn_parser;
+    p->dyn_tokens= dyn_tokens;
+    p->ref_cnt   = 0;
+}
+
+} // ns details
+
+/*************************************************************************************************/
+
+// zero-alloc routines
+
+inline parser make_parser(
+     token *toksbeg
+    ,token *toksend
+    ,const char *strbeg
+    ,const char *strend)
+{
+    parser p;
+    details::init_parser(
+         &p
+        ,toksbeg
+        ,toksend
+        ,strbeg
+        ,strend
+        ,nullptr
+        ,nullptr
+        ,false
+        ,false
+    );
+
+    return p;
+}
+
+template<std::size_t N>
+inline parser make_parser(
+     token *toksbeg
+    ,token *toksend
+    ,const char (&str)[N])
+{
+    return make_parser(toksbeg, toksend, str, &str[N]);
+}
+
+inline parser init_parser(
+     alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    parser p;
+    details::init_parser(
+         &p
+        ,nullptr
+        ,nullptr
+        ,nullptr
+        ,nullptr
+        ,alloc_fn
+        ,free_fn
+        ,false
+        ,false
+    );
+
+    return p;
+}
+
+/*************************************************************************************************/
+// dyn-alloc routines
+
+inline parser* alloc_parser(
+     token *toksbeg
+    ,token *toksend
+    ,const char *strbeg
+    ,const char *strend
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    auto *p = static_cast<parser *>(alloc_fn(sizeof(parser)));
+    if ( p ) {
+        details::init_parser(
+             p
+            ,toksbeg
+            ,toksend
+            ,strbeg
+            ,strend
+            ,alloc_fn
+            ,free_fn
+            ,true
+            ,false
+        );
+    }
+
+    return p;
+}
+
+template<std::size_t N>
+inline parser* alloc_parser(
+     token *toksbeg
+    ,token *toksend
+    ,const char (&str)[N]
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    return alloc_parser(toksbeg, toksend, str, &str[N], alloc_fn, free_fn);
+}
+
+inline std::size_t num_tokens(error_code *ecptr, const char *beg, const char *end) {
+    static token fake;
+    auto p = make_parser(&fake, &fake, beg, end);
+
+    std::size_t vlen;
+    token_type type;
+    std::uint8_t flags;
+    error_code ec = details::parse_value<false>(
+         &p
+        ,&(p.toks_beg->val)
+        ,&vlen
+        ,&type
+        ,nullptr
+        ,&flags
+    );
+    (void)type;
+
+    if ( !ec && p.str_cur+1 != p.str_end ) {
+        p.str_cur = details::fj_skip_ws(p.str_cur);
+        if ( p.str_cur != p.str_end ) {
+            if ( ecptr ) { *ecptr = FJ_EC_INVALID; }
+
+            return 0;
+        }
+    }
+
+    std::size_t toknum = p.toks_cur - p.toks_beg;
+
+    return toknum;
+}
+
+inline parser make_parser(
+     const char *strbeg
+    ,const char *strend
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    parser p;
+    details::init_parser(
+         &p
+        ,nullptr
+        ,nullptr
+        ,nullptr
+        ,nullptr
+        ,alloc_fn
+        ,free_fn
+        ,false
+        ,true
+    );
+
+    if ( strend - strbeg == 1 && *strbeg == '\0' ) {
+        return p;
+    }
+
+    error_code ec{};
+    auto toknum = num_tokens(&ec, strbeg, strend);
+    if ( ec ) {
+        p.error = ec;
+        return p;
+    }
+
+    auto in_bytes = sizeof(token) * toknum;
+    auto *toksbeg = static_cast<token *>(alloc_fn(in_bytes));
+    auto *toksend = toksbeg + toknum;
+
+    details::init_parser(
+         &p
+        ,toksbeg
+        ,toksend
+        ,strbeg
+        ,strend
+        ,alloc_fn
+        ,free_fn
+        ,false
+        ,true
+    );
+
+    return p;
+}
+
+template<std::size_t N>
+inline parser make_parser(
+     const char (&str)[N]
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    return make_parser(str, &str[N], alloc_fn, free_fn);
+}
+
+inline parser* alloc_parser(
+     const char *strbeg
+    ,const char *strend
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    auto *p = static_cast<parser *>(alloc_fn(sizeof(parser)));
+    if ( p ) {
+        details::init_parser(
+             p
+            ,nullptr
+            ,nullptr
+            ,nullptr
+            ,nullptr
+            ,alloc_fn
+            ,free_fn
+            ,true
+            ,true
+        );
+    } else {
+        return nullptr;
+    }
+
+    if ( strend - strbeg == 1 && *strbeg == '\0' ) {
+        return p;
+    }
+
+    error_code ec{};
+    auto toknum = num_tokens(&ec, strbeg, strend);
+    if ( ec ) {
+        p->error = ec;
+        return p;
+    }
+    auto in_bytes = sizeof(token) * toknum;
+    auto *toksbeg = static_cast<token *>(alloc_fn(in_bytes));
+    auto *toksend = toksbeg + toknum;
+
+    if ( p ) {
+        details::init_parser(
+             p
+            ,toksbeg
+            ,toksend
+            ,strbeg
+            ,strend
+            ,alloc_fn
+            ,free_fn
+            ,true
+            ,true
+        );
+    }
+
+    return p;
+}
+
+template<std::size_t N>
+inline parser* alloc_parser(
+     const char (&str)[N]
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    return alloc_parser(str, &str[N], alloc_fn, free_fn);
+}
+
+inline void free_parser(parser *p) {
+    if ( p->dyn_tokens && p->toks_beg ) {
+        p->free_fn(p->toks_beg);
+    }
+    details::chunk_free_all(p->arena, p->free_fn);
+
+    p->toks_beg = nullptr;
+    p->toks_cur = nullptr;
+    p->toks_end = nullptr;
+    p->error = FJ_EC_INVALID;
+
+    if ( p->dyn_parser ) {
+        p->free_fn(p);
+    }
+}
+
+/*************************************************************************************************/
+// parsing
+
+inline std::size_t parse(parser *p) {
+    if ( !p->toks_beg ) {
+        return 0;
+    }
+
+    std::size_t vlen = 0;
+    token_type type;
+    std::uint8_t flags = 0;
+    p->error = details::parse_value<true>(
+         p
+        ,&(p->toks_beg->val)
+        ,&vlen
+        ,&type
+        ,nullptr
+        ,&flags
+    );
+    p->toks_beg->type = type;
+    if ( fj_is_simple_type_macro(type) ) {
+        p->toks_beg->flags = flags;
+    }
+    assert(vlen <= std::numeric_limits<FJ_VLEN_TYPE>::max());
+    p->toks_beg->vlen = static_cast<FJ_VLEN_TYPE>(vlen);
+    p->toks_beg->end = p->toks_cur;
+    p->toks_end = p->toks_cur;
+
+    return p->toks_cur - p->toks_beg;
+}
+
+// returns the num of tokens
+inline std::size_t parse(token *tokbeg, token *tokend, const char *strbeg, const char *strend) {
+    auto p = make_parser(tokbeg, tokend, strbeg, strend);
+
+    return parse(&p);
+}
+
+// returns the dyn-allocated parser
+inline parser* parse(
+     const char *strbeg
+    ,const char *strend
+    ,alloc_fnptr alloc_fn = &malloc
+    ,free_fnptr free_fn = &free)
+{
+    auto *p = alloc_parser(strbeg, strend, alloc_fn, free_fn);
+    parse(p);
+
+    return p;
+}
+
+/*************************************************************************************************/
+// parser state
+
+inline bool is_valid(const parser *p) {
+    return p && p->error == FJ_EC_OK;
+}
+
+inline error_code get_error(const parser *p) {
+    return p->error;
+}
+
+inline const char* get_error_message(const parser *p) {
+    return error_string(p->error);
+}
+
+inline std::size_t num_tokens(const parser *p) {
+    return p->toks_end - p->toks_beg;
+}
+
+inline std::size_t num_childs(const parser *p) {
+    return (!fj_is_simple_type_macro(p->toks_beg->type))
+       ? p->toks_beg->childs - 1
+       : static_cast<std::size_t>(p->toks_beg->type != FJ_TYPE_INVALID)
+    ;
+}
+
+inline bool is_empty(const parser *p) {
+    return p == nullptr || p->toks_beg == p->toks_end;
+}
+
+inline bool is_array(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_ARRAY; }
+
+inline bool is_object(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_OBJECT; }
+
+inline bool is_null(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_NULL; }
+
+inline bool is_bool(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_BOOL; }
+
+inline bool is_number(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_NUMBER; }
+
+inline bool is_string(const parser *p)
+{ return p->toks_beg->type == FJ_TYPE_STRING; }
+
+inline bool is_simple_type(const parser *p)
+{ return fj_is_simple_type_macro(p->toks_beg->type); }
+
+/*************************************************************************************************/
+// iterators
+
+struct iterator {
+    token *beg;
+    token *cur;
+    token *end;
+
+    string_view key() const { return {cur->key, cur->klen}; }
+    string_view value() const { return {cur->val, cur->vlen}; }
+    std::size_t childs() const { return cur->childs; }
+    const token* parent() const { return cur->parent; }
+//    const token* end() const { return cur->end; }
+
+    token_type type() const { return cur->type; }
+    const char* type_name() const { return flatjson::type_name(type()); }
+    bool is_valid() const { return cur && type() != FJ_TYPE_INVALID; }
+    bool is_array() const { return type() == FJ_TYPE_ARRAY; }
+    bool is_object() const { return type() == FJ_TYPE_OBJECT; }
+    bool is_null() const { return type() == FJ_TYPE_NULL; }
+    bool is_bool() const { return type() == FJ_TYPE_BOOL; }
+    bool is_number() const { return type() == FJ_TYPE_NUMBER; }
+    bool is_string() const { return type() == FJ_TYPE_STRING; }
+    bool is_simple_type() const { return fj_is_simple_type_macro(type()); }
+    // the escapes were seen while parsing, see unescape()
+    bool is_key_escaped() const { return (cur->flags & FJ_FLAG_KEY_ESCAPED) != 0; }
+    bool is_value_escaped() const { return is_string() && (cur->flags & FJ_FLAG_VALUE_ESCAPED) != 0; }
+    // the FJ_FLAG_NUM_* bits recorded while parsing, zero for not a NUMBER
+    std::uint8_t number_kind() const {
+        static constexpr std::uint8_t mask =
+            FJ_FLAG_NUM_NEGATIVE | FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_HEX | FJ_FLAG_NUM_FITS_64;
+        return is_number() ? static_cast<std::uint8_t>(cur->flags & mask) : 0;
+    }
+    bool is_integer() const { return (number_kind() & FJ_FLAG_NUM_INTEGER) != 0; }
+    bool is_negative() const { return (number_kind() & FJ_FLAG_NUM_NEGATIVE) != 0; }
+
+    string_view to_string_view() const { return value(); }
+    std::string to_string() const { auto s = to_string_view(); return {s.data(), s.size()}; }
+    // the exact bytes of the source: with the quotes for STRING, with the brackets for containers.
+    // the containers are pointing to '{'/'[' and their END tokens to '}'/']', see details::end_token().
+    string_view raw() const {
+        if ( is_string() ) {
+            return {cur->val - 1, cur->vlen + 2u};
+        }
+        if ( is_simple_type() ) {
+            return value();
+        }
+
+        const token *e = cur->parent ? cur->end : cur->end - 1;
+        if ( !cur->val || !e->val ) {
+            return {static_cast<const char *>(nullptr), std::size_t{0}};
+        }
+
+        return {cur->val, static_cast<std::size_t>(e->val + 1 - cur->val)};
+    }
+
+    template<typename T>
+    T to() const { auto s = to_string_view(); return details::conv_to(s.data(), s.size(), T{}); }
+    // the checked conversion: the numbers for the arithmetic types, true/false for bool.
+    // the `out` is not changed on error.
+    template<typename T>
+    error_code try_to(T &out) const {
+        if ( !is_valid() ) {
+            return FJ_EC_NOT_CONVERTIBLE;
+        }
+        __FJ__CONSTEXPR_IF ( std::is_same<T, bool>::value ) {
+            if ( !is_bool() ) {
+                return FJ_EC_NOT_CONVERTIBLE;
+            }
+        } else __FJ__CONSTEXPR_IF ( std::is_arithmetic<T>::value ) {
+            if ( !is_number() ) {
+                return FJ_EC_NOT_CONVERTIBLE;
+            }
+            // the integers are rejected by the number kind, without the rescan
+            __FJ__CONSTEXPR_IF ( std::is_integral<T>::value ) {
+                const auto kind = number_kind();
+                if ( (kind & (FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_HEX)) != FJ_FLAG_NUM_INTEGER
+                    || (std::is_unsigned<T>::value && (kind & FJ_FLAG_NUM_NEGATIVE)) )
+                {
+                    return FJ_EC_NOT_CONVERTIBLE;
+                }
+                if ( !(kind & FJ_FLAG_NUM_FITS_64) ) {
+                    return FJ_EC_VALUE_OVERFLOW;
+                }
+            }
+        }
+        auto s = to_string_view();
+
+        return details::try_conv(s.data(), s.size(), &out);
+    }
+    bool to_bool() const { return to<bool>(); }
+    std::uint32_t to_uint() const { return to<std::uint32_t>(); }
+    std::int32_t to_int() const { return to<std::int32_t>(); }
+    std::uint64_t to_uint64() const { return to<std::uint64_t>(); }
+    std::int64_t to_int64() const { return to<std::int64_t>(); }
+    double to_double() const { return to<double>(); }
+    float to_float() const { return to<float>(); }
+
+    std::size_t members() const {
+        return (!is_simple_type())
+           ? childs() - 1
+           : static_cast<std::size_t>(type() != FJ_TYPE_INVALID)
+        ;
+    }
+};
+
+namespace details {
+
+// dump using iterator
+inline void dump_tokens(std::FILE *stream, const char *caption, const iterator &it, std::size_t indent = 3) {
+    std::fprintf(stream, "%s:\n", caption);
+    dump_tokens_impl(stream, it.beg, it.cur, it.end, indent);
+}
+
+} // ns details
+
+inline iterator iter_begin(const parser *p) {
+    assert(p && p->toks_beg);
+    return {p->toks_beg, p->toks_beg, p->toks_end-1};
+}
+
+inline iterator iter_end(const parser *p) {
+    assert(p && p->toks_beg);
+    return {p->toks_end-1, p->toks_end-1, p->toks_end-1};
+}
+
+inline iterator iter_begin(const iterator &it) {
+    if ( !it.is_simple_type() ) {
+        return {it.cur, it.cur, it.cur->end};
+    }
+
+    return {it.cur, it.cur, it.cur->parent->end};
+}
+
+inline iterator iter_end(const iterator &it) {
+    if ( !it.is_simple_type() ) {
+        return {it.cur->end, it.cur->end, it.cur->end};
+    }
+
+    return {it.end, it.end, it.end};
+}
+
+inline bool iter_equal(const iterator &l, const iterator &r)
+{ return l.cur == r.cur; }
+
+inline bool iter_not_equal(const iterator &l, const iterator &r)
+{ return !iter_equal(l, r); }
+
+inline std::size_t iter_members(const iterator &it) {
+    if ( it.is_simple_type() ) {
+        return 0;
+    }
+
+    return it.cur->childs - 1;
+}
+
+inline iterator iter_next(const iterator &it) {
+    assert(it.cur != it.end);
+
+    // from the container to its first member
+    if ( it.cur == it.beg && !it.is_simple_type() ) {
+        return {it.beg, it.cur + 1, it.end};
+    }
+    // to the next sibling, the subtree of the member container is skipped using its `end`
+    if ( it.cur->parent == it.beg ) {
+        auto next = it.is_simple_type() ? it.cur + 1 : it.cur->end + 1;
+        return {it.beg, next, it.end};
+    }
+
+    auto next = it.cur + 1;
+    if ( next != it.end && next->parent == it.beg ) {
+        return {it.beg, next, it.end};
+    }
+
+    for ( ; next != it.end && next->parent != it.beg; ++next )
+        ;
+
+    return {it.beg, next, it.end};
+}
+
+inline std::size_t iter_distance(const iterator &from, const iterator &to) {
+    assert(from.cur->parent == to.cur->parent);
+
+    if ( from.cur->parent->flags & FJ_FLAG_SIMPLE_CHILDS ) {
+        return to.cur - from.cur;
+    }
+
+    std::size_t cnt{};
+    iterator it{from};
+    for ( ; iter_not_equal(it, to); it = iter_next(it), ++cnt )
+    {}
+
+    return cnt;
+}
+
+/*************************************************************************************************/
+// escapes
+
+namespace details {
+
+inline std::uint32_t hex4_to_cp(const char *p) {
+    std::uint32_t cp = 0;
+    for ( const char *end = p + 4; p != end; ++p ) {
+        const auto ch = static_cast<std::uint32_t>(*p);
+        cp = (cp << 4) | (fj_is_digit_macro(*p) ? ch - '0' : (ch | 0x20u) - 'a' + 10);
+    }
+
+    return cp;
+}
+
+inline std::size_t utf8_len(std::uint32_t cp) {
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+}
+
+inline char* put_utf8(char *out, std::uint32_t cp) {
+    if ( cp < 0x80 ) {
+        *out++ = static_cast<char>(cp);
+    } else if ( cp < 0x800 ) {
+        *out++ = static_cast<char>(0xc0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else if ( cp < 0x10000 ) {
+        *out++ = static_cast<char>(0xe0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        *out++ = static_cast<char>(0xf0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3f));
+    }
+
+    return out;
+}
+
+// decodes the escaped string, the surrogate pairs are combined, the lone surrogates are
+// replaced by U+FFFD. the runs without escapes are found by memchr() and copied by memcpy(),
+// both are vectorized by the libc.
+// the result is never longer than the source.
+// returns the number of written bytes, or std::string::npos if the `size` is not enough.
+inline std::size_t unescape(const char *src, std::size_t len, char *dst, std::size_t size) {
+    const char *end = src + len;
+    char *out = dst;
+    char *oend = dst + size;
+    while ( src != end ) {
+        const auto *bs = static_cast<const char *>(std::memchr(src, '\\', static_cast<std::size_t>(end - src)));
+        const auto run = static_cast<std::size_t>((bs ? bs : end) - src);
+        if ( run > static_cast<std::size_t>(oend - out) ) {
+            return std::string::npos;
+        }
+        std::memcpy(out, src, run);
+        out += run;
+        src += run;
+        if ( !bs || end - src < 2 ) {
+            break;
+        }
+
+        const char ch = src[1];
+        src += 2;
+        if ( ch == 'u' ) {
+            if ( end - src < 4 ) {
+                break;
+            }
+            auto cp = hex4_to_cp(src);
+            src += 4;
+            if ( cp >= 0xd800 && cp <= 0xdbff && end - src >= 6 && src[0] == '\\' && src[1] == 'u' ) {
+                const auto lo = hex4_to_cp(src + 2);
+                if ( lo >= 0xdc00 && lo <= 0xdfff ) {
+                    cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                    src += 6;
+                }
+            }
+            if ( cp >= 0xd800 && cp <= 0xdfff ) {
+                cp = 0xfffd;
+            }
+            if ( utf8_len(cp) > static_cast<std::size_t>(oend - out) ) {
+                return std::string::npos;
+            }
+            out = put_utf8(out, cp);
+        } else {
+            if ( out == oend ) {
+                return std::string::npos;
+            }
+            switch ( ch ) {
+                case 'b': *out++ = '\b'; break;
+                case 'f': *out++ = '\f'; break;
+                case 'n': *out++ = '\n'; break;
+                case 'r': *out++ = '\r'; break;
+                case 't': *out++ = '\t'; break;
+                default : *out++ = ch;
+            }
+        }
+    }
+
+    return static_cast<std::size_t>(out - dst);
+}
+
+inline bool has_escapes(const char *str, std::size_t len)
+{ return std::memchr(str, '\\', len) != nullptr; }
+
+// decodes the escaped key into the `buf`, or into the `heap` if the key is long.
+// returns the view of the decoded key.
+inline string_view unescape_key(const char *key, std::size_t klen, char (&buf)[256], std::string &heap) {
+    char *dst = buf;
+    if ( klen > sizeof(buf) ) {
+        heap.resize(klen);
+        dst = &heap[0];
+    }
+
+    return {dst, unescape(key, klen, dst, klen)};
+}
+
+// compares the escaped key with the not escaped `str`
+inline bool unescaped_equal(const char *key, std::size_t klen, const char *str, std::size_t len) {
+    // the decoded is never longer
+    if ( len > klen ) {
+        return false;
+    }
+
+    char buf[256];
+    std::string heap;
+    const auto decoded = unescape_key(key, klen, buf, heap);
+
+    return decoded.size() == len && std::memcmp(decoded.data(), str, len) == 0;
+}
+
+} // ns details
+
+/*************************************************************************************************/
+// lookup indexes
+
+namespace details {
+
+struct index_header {
+    std::uint32_t type; // FJ_TYPE_OBJECT or FJ_TYPE_ARRAY
+    std::uint32_t size; // number of slots
+};
+
+// for objects: open addressing over the key hashes.
+// for arrays: the offsets of the elements from the array token, as std::uint32_t[size].
+struct index_slot {
+    std::uint32_t hash;
+    std::uint32_t offset; // offset of the member token from the object token, 0 for a free slot
+};
+
+// the END token of the container. the root token is pointing to the past-the-end token.
+inline token* end_token(const token *container) {
+    return container->parent ? container->end : container->end - 1;
+}
+
+inline const index_header* get_index(const token *container) {
+    return static_cast<const index_header *>(end_token(container)->index);
+}
+
+inline void* arena_alloc(parser *p, std::size_t size)
+{ return chunk_alloc(p->arena, size, 4096u, p->alloc_fn); }
+
+// the escaped keys are inserted twice: by the hash of the key as is, and of the decoded key
+inline const index_header* build_object_index(parser *p, token *obj) {
+    const token *end = end_token(obj);
+    std::size_t keys = 0;
+    for ( const token *it = obj + 1; it != end; ) {
+        keys += (it->flags & FJ_FLAG_KEY_ESCAPED) ? 2 : 1;
+        it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1;
+    }
+
+    std::size_t size = 4;
+    for ( ; size < keys * 2; size <<= 1 )
+        ;
+
+    auto *hdr = static_cast<index_header *>(
+        arena_alloc(p, sizeof(index_header) + size * sizeof(index_slot))
+    );
+    if ( !hdr ) {
+        return nullptr;
+    }
+    hdr->type = FJ_TYPE_OBJECT;
+    hdr->size = static_cast<std::uint32_t>(size);
+
+    auto *slots = reinterpret_cast<index_slot *>(hdr + 1);
+    std::memset(slots, 0, size * sizeof(index_slot));
+
+    const std::size_t mask = size - 1;
+    const auto insert = [slots, mask](std::uint32_t h, std::uint32_t offset) {
+        auto idx = h & mask;
+        for ( ; slots[idx].offset; idx = (idx + 1) & mask )
+            ;
+        slots[idx].hash = h;
+        slots[idx].offset = offset;
+    };
+    for ( const token *it = obj + 1; it != end; ) {
+        const auto offset = static_cast<std::uint32_t>(it - obj);
+        insert(key_hash(it->key, it->klen), offset);
+        if ( it->flags & FJ_FLAG_KEY_ESCAPED ) {
+            char buf[256];
+            std::string heap;
+            const auto decoded = unescape_key(it->key, it->klen, buf, heap);
+            insert(key_hash(decoded.data(), decoded.size()), offset);
+        }
+
+        it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1;
+    }
+
+    return hdr;
+}
+
+inline const index_header* build_array_index(parser *p, token *arr) {
+    const std::size_t members = arr->childs - 1u;
+    auto *hdr = static_cast<index_header *>(
+        arena_alloc(p, sizeof(index_header) + members * sizeof(std::uint32_t))
+    );
+    if ( !hdr ) {
+        return nullptr;
+    }
+    hdr->type = FJ_TYPE_ARRAY;
+    hdr->size = static_cast<std::uint32_t>(members);
+
+    auto *offsets = reinterpret_cast<std::uint32_t *>(hdr + 1);
+    const token *end = end_token(arr);
+    for ( const token *it = arr + 1; it != end; ++offsets ) {
+        *offsets = static_cast<std::uint32_t>(it - arr);
+
+        it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1;
+    }
+
+    return hdr;
+}
+
+inline const token* index_find(
+     const index_header *hdr
+    ,const token *obj
+    ,const char *key
+    ,std::size_t klen
+    ,std::uint32_t h)
+{
+    const auto *slots = reinterpret_cast<const index_slot *>(hdr + 1);
+    const std::size_t mask = hdr->size - 1;
+    for ( auto idx = h & mask; slots[idx].offset; idx = (idx + 1) & mask ) {
+        if ( slots[idx].hash != h ) {
+            continue;
+        }
+
+        const token *it = obj + slots[idx].offset;
+        if ( it->klen == klen && std::memcmp(it->key, key, klen) == 0 ) {
+            return it;
+        }
+        if ( (it->flags & FJ_FLAG_KEY_ESCAPED) && unescaped_equal(it->key, it->klen, key, klen) ) {
+            return it;
+        }
+    }
+
+    return nullptr;
+}
+
+} // ns details
+
+// builds the lookup index for the OBJECT or ARRAY pointed by the iterator.
+// the index is allocated in the side arena of the parser using the `alloc_fn`,
+// and is released by `free_parser()`. the parsers without `alloc_fn` are not indexable.
+// the arrays of simple types are random-accessible without the index.
+// the lookups never build the index, they use the one which is built.
+// is not thread-safe against the concurrent lookups in the same parser,
+// so the indexes are built before the document is shared between threads.
+inline bool build_index(const parser *p, const iterator &it) {
+    if ( !p || !p->alloc_fn || !it.cur || it.is_simple_type() ) {
+        return false;
+    }
+    if ( it.is_array() && (it.cur->flags & FJ_FLAG_SIMPLE_CHILDS) ) {
+        return true;
+    }
+
+    auto *end = details::end_token(it.cur);
+    if ( end->index ) {
+        return true;
+    }
+
+    // the index is just a cache, so it is OK to build it for a const parser
+    end->index = it.is_object()
+        ? details::build_object_index(const_cast<parser *>(p), it.cur)
+        : details::build_array_index(const_cast<parser *>(p), it.cur)
+    ;
+
+    return end->index != nullptr;
+}
+
+// builds the indexes for all the containers with more than `threshold` members.
+// returns false if one of them is not built.
+inline bool build_indexes(const parser *p, std::size_t threshold = FJ_INDEX_THRESHOLD) {
+    if ( !p || !p->toks_beg ) {
+        return false;
+    }
+
+    bool ok = true;
+    for ( token *t = p->toks_beg; t != p->toks_cur; ++t ) {
+        if ( (t->type == FJ_TYPE_OBJECT || t->type == FJ_TYPE_ARRAY) && t->childs > threshold ) {
+            ok = build_index(p, iterator{t, t, t->end}) && ok;
+        }
+    }
+
+    return ok;
+}
+
+inline bool has_index(const iterator &it) {
+    return it.cur && !it.is_simple_type() && details::get_index(it.cur) != nullptr;
+}
+
+namespace details {
+
+// find by key name, the `h` is the key_hash() of the key
+inline iterator iter_find(
+     const char *key
+    ,std::size_t klen
+    ,std::uint32_t h
+    ,const iterator &beg
+    ,const iterator &end)
+{
+    if ( !beg.cur ) {
+        return end;
+    }
+    if ( beg.cur && beg.cur->parent && beg.cur->parent->type != FJ_TYPE_OBJECT ) {
+        return end;
+    }
+
+    const token *obj = beg.cur->parent;
+    if ( obj && beg.cur == obj + 1 ) {
+        if ( const auto *hdr = get_index(obj) ) {
+            auto *found = const_cast<token *>(index_find(hdr, obj, key, klen, h));
+            if ( !found ) {
+                return end;
+            }
+
+            return fj_is_simple_type_macro(found->type)
+                ? iterator{beg.beg, found, found + 1}
+                : iterator{found, found, found->end}
+            ;
+        }
+    }
+
+    const auto h8 = key_hash8(h);
+    iterator it{beg};
+    while ( iter_not_equal(it, end) ) {
+        if ( it.type() == FJ_TYPE_OBJECT_END ) {
+            return end;
+        }
+        if ( it.cur->khash == h8 && it.cur->klen == klen
+            && std::memcmp(it.cur->key, key, klen) == 0 )
+        {
+            break;
+        }
+        // the escaped keys are matched both as is and decoded
+        if ( (it.cur->flags & FJ_FLAG_KEY_ESCAPED)
+            && unescaped_equal(it.cur->key, it.cur->klen, key, klen) )
+        {
+            break;
+        }
+
+        it = it.is_simple_type()
+            ? iterator{it.beg, it.cur + 1, it.end}
+            : iterator{it.beg, it.cur->end + 1, it.end}
+        ;
+    }
+
+    const auto type = it.type();
+    switch ( type ) {
+        case FJ_TYPE_STRING:
+        case FJ_TYPE_NUMBER:
+        case FJ_TYPE_BOOL:
+        case FJ_TYPE_NULL: {
+            return {it.beg, it.cur, it.cur + 1};
+        }
+        case FJ_TYPE_OBJECT:
+        case FJ_TYPE_ARRAY: {
+            return {it.cur, it.cur, it.cur->end};
+        }
+        default: {
+            if ( iter_equal(it, end) && it.type() == FJ_TYPE_OBJECT_END ) {
+                return end;
+            }
+        }
+    }
+
+    assert(!"unreachable!");
+
+    return end;
+}
+
+// find by key name
+inline iterator iter_find(const char *key, std::size_t klen, const iterator &beg, const iterator &end)
+{ return iter_find(key, klen, key_hash(key, klen), beg, end); }
+
+} // ns details
+
+// at by key name, from the parser.
+// the index is used when it was built by build_index()/build_indexes(), the lookups
+// themselves do not change the parser, so they are safe to run concurrently.
+inline iterator iter_at(const char *key, std::size_t klen, const parser *p) {
+    assert(p && p->toks_beg);
+
+    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
+    iterator beg = {
+         p->toks_beg
+        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
+        ,p->toks_end
+    };
+    iterator end = iter_end(p);
+
+    return details::iter_find(key, klen, beg, end);
+}
+
+template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
+iterator iter_at(T key, const parser *p) {
+    assert(p && p->toks_beg);
+
+    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
+    iterator beg = {
+         p->toks_beg
+        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
+        ,p->toks_end
+    };
+    iterator end = iter_end(p);
+
+    return details::iter_find(key, std::strlen(key), beg, end);
+}
+
+template<std::size_t N>
+iterator iter_at(const char (&key)[N], const parser *p) {
+    assert(p && p->toks_beg);
+
+    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
+    iterator beg = {
+         p->toks_beg
+        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
+        ,p->toks_end
+    };
+    iterator end = iter_end(p);
+
+    return details::iter_find(key, N-1, beg, end);
+}
+
+// at by key name, from the iterators
+inline iterator iter_at(const char *key, std::size_t klen, const iterator &it) {
+    assert(it.cur != it.end);
+
+    iterator beg = {
+         it.beg
+        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
+        ,it.end
+    };
+    auto end = iter_end(it);
+
+    return details::iter_find(key, klen, beg, end);
+}
+
+template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
+iterator iter_at(T key, const iterator &it) {
+    assert(it.cur != it.end);
+
+    iterator beg = {
+         it.beg
+        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
+        ,it.end
+    };
+    auto end = iter_end(it);
+
+    return details::iter_find(key, std::strlen(key), beg, end);
+}
+
+template<std::size_t N>
+iterator iter_at(const char (&key)[N], const iterator &it) {
+    assert(it.cur != it.end);
+
+    iterator beg = {
+         it.beg
+        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
+        ,it.end
+    };
+    auto end = iter_end(it);
+
+    return details::iter_find(key, N-1, beg, end);
+}
+
+namespace details {
+
+// find by index
+inline iterator iter_find(std::size_t idx, const iterator &beg, const iterator &end) {
+    if ( !beg.cur ) {
+        return end;
+    }
+    if ( beg.cur && beg.cur->parent->type != FJ_TYPE_ARRAY ) {
+        return end;
+    }
+    if ( idx >= beg.cur->parent->childs ) {
+        return end;
+    }
+    if ( beg.cur->parent->flags & FJ_FLAG_SIMPLE_CHILDS ) {
+        return {beg.beg, beg.cur + idx, beg.end};
+    }
+    const token *arr = beg.cur->parent;
+    const auto *hdr = get_index(arr);
+    if ( hdr && beg.cur == arr + 1 ) {
+        if ( idx >= hdr->size ) {
+            return end;
+        }
+        const auto offset = reinterpret_cast<const std::uint32_t *>(hdr + 1)[idx];
+        auto *found = const_cast<token *>(arr) + offset;
+
+        return fj_is_simple_type_macro(found->type)
+            ? iterator{beg.beg, found, found + 1}
+            : iterator{found, found, found->end}
+        ;
+    } else {
+        iterator it{beg};
+        for ( ; iter_not_equal(it, end) && idx; --idx ) {
+            if ( it.type() == FJ_TYPE_ARRAY_END ) {
+                return end;
+            }
+
+            it = it.is_simple_type()
+                ? iterator{it.beg, it.cur + 1, it.end}
+                : iterator{it.beg, it.cur->end + 1, it.end}
+            ;
+        }
+
+        const auto type = it.type();
+        switch ( type ) {
+            case FJ_TYPE_STRING:
+            case FJ_TYPE_NUMBER:
+            case FJ_TYPE_BOOL:
+            case FJ_TYPE_NULL: {
+                return {it.beg, it.cur, it.cur + 1};
+            }
+            case FJ_TYPE_OBJECT:
+            case FJ_TYPE_ARRAY: {
+                return {it.cur, it.cur, it.cur->end};
+            }
+            default: {
+                if ( iter_equal(it, end) && it.type() == FJ_TYPE_ARRAY_END ) {
+                    return end;
+                }
+            }
+        }
+    }
+    assert(!"unreachable!");
+
+    return end;
+}
+
+} // ns details
+
+// at by index, from a parser, the same as by key name about the index
+inline iterator iter_at(std::size_t idx, const parser *p) {
+    assert(p && p->toks_beg);
+
+    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
+    iterator beg = {
+         p->toks_beg
+        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
+        ,p->toks_end
+    };
+    iterator end = iter_end(p);
+
+    return details::iter_find(idx, beg, end);
+}
+
+// at by index, from a iterator
+inline iterator iter_at(std::size_t idx, const iterator &it) {
+    assert(it.cur != it.end);
+
+    iterator beg = {
+         it.beg
+        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
+        ,it.end
+    };
+    iterator end = iter_end(it);
+
+    return details::iter_find(idx, beg, end);
+}
+
+namespace details {
+
+// the iterator for the value token, the same as returned by iter_find()
+inline iterator make_iterator(token *t) {
+    if ( fj_is_simple_type_macro(t->type) ) {
+        return {t->parent ? t->parent : t, t, t + 1};
+    }
+
+    return {t, t, end_token(t)};
+}
+
+} // ns details
+
+/*************************************************************************************************/
+// JSON Pointer (RFC 6901)
+
+namespace details {
+
+// the array index of the reference token, or size_t(-1).
+// the leading zeros and the '-' are not the indexes.
+inline std::size_t parse_array_index(const char *str, std::size_t len) {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    if ( len == 0 || len > 19 || (len > 1 && *str == '0') ) {
+        return npos;
+    }
+
+    std::size_t idx{};
+    for ( const char *end = str + len; str != end; ++str ) {
+        if ( !fj_is_digit_macro(*str) ) {
+            return npos;
+        }
+        idx = idx * 10 + static_cast<std::size_t>(*str - '0');
+    }
+
+    return idx;
+}
+
+} // ns details
+
+// the pointer is compiled once: the segments are unescaped, hashed,
+// and the array indexes are parsed, so the resolving does not allocate.
+struct pointer {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    pointer() = default;
+    template<std::size_t N>
+    explicit pointer(const char (&str)[N])
+        :pointer{str, N-1}
+    {}
+    template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
+    explicit pointer(T str)
+        :pointer{str, std::strlen(str)}
+    {}
+    pointer(const char *str, std::size_t len)
+        :m_valid{compile(str, len)}
+    {}
+
+    // false for a syntax error: no leading '/' or a bad '~' escape
+    bool is_valid() const { return m_valid; }
+    // number of reference tokens, zero for the whole document
+    std::size_t size() const { return m_segs.size(); }
+    string_view segment(std::size_t idx) const
+    { return {m_buf.data() + m_segs[idx].offset, m_segs[idx].len}; }
+    // the array index of the segment, or npos
+    std::size_t index(std::size_t idx) const { return m_segs[idx].idx; }
+
+    // returns not valid iterator if the value is not found
+    iterator resolve(const iterator &it) const { return resolve(it, m_segs.size()); }
+    // by the first `num` segments only, resolve(it, size() - 1) is the parent
+    iterator resolve(const iterator &it, std::size_t num) const {
+        if ( !m_valid || !it.cur || num > m_segs.size() ) {
+            return {};
+        }
+
+        iterator cur{it};
+        for ( std::size_t i = 0; i < num; ++i ) {
+            const auto &seg = m_segs[i];
+            if ( cur.is_simple_type() ) {
+                return {};
+            }
+
+            token *endtok = details::end_token(cur.cur);
+            iterator beg{cur.cur, cur.cur + 1, endtok};
+            iterator end{endtok, endtok, endtok};
+            if ( cur.is_object() ) {
+                cur = details::iter_find(m_buf.data() + seg.offset, seg.len, seg.hash, beg, end);
+            } else if ( seg.idx != npos ) {
+                cur = details::iter_find(seg.idx, beg, end);
+            } else {
+                return {};
+            }
+            if ( cur.cur == endtok ) {
+                return {};
+            }
+        }
+
+        return cur;
+    }
+    iterator resolve(const parser *p) const {
+        assert(p && p->toks_beg);
+
+        return resolve(iter_begin(p));
+    }
+
+private:
+    struct segment_t {
+        std::size_t offset;
+        std::size_t len;
+        std::size_t idx; // the array index, or npos
+        std::uint32_t hash;
+    };
+
+    bool compile(const char *str, std::size_t len) {
+        const char *end = str + len;
+        if ( str != end && *str != '/' ) {
+            return false;
+        }
+
+        m_buf.reserve(len);
+        while ( str != end ) {
+            ++str; // skip '/'
+            segment_t seg{m_buf.size(), 0, npos, 0};
+            for ( ; str != end && *str != '/'; ++str ) {
+                char ch = *str;
+                if ( ch == '~' ) {
+                    if ( ++str == end || (*str != '0' && *str != '1') ) {
+                        return false;
+                    }
+                    ch = (*str == '0') ? '~' : '/';
+                }
+                m_buf.push_back(ch);
+            }
+
+            seg.len = m_buf.size() - seg.offset;
+            seg.hash = details::key_hash(m_buf.data() + seg.offset, seg.len);
+            seg.idx = details::parse_array_index(m_buf.data() + seg.offset, seg.len);
+            m_segs.push_back(seg);
+        }
+
+        return true;
+    }
+
+    std::string m_buf;
+    std::vector<segment_t> m_segs;
+    bool m_valid = true;
+};
+
+inline iterator iter_at(const pointer &ptr, const parser *p) { return ptr.resolve(p); }
+inline iterator iter_at(const pointer &ptr, const iterator &it) { return ptr.resolve(it); }
+
+/*************************************************************************************************/
+// JSONPath
+
+// the subset of JSONPath:
+//   $                root, must be the first
+//   .name ['name']   child
+//   .* [*]           all members/elements
+//   ..               recursive descent, followed by a name, '*' or a bracket
+//   [3] [-1]         array element
+//   [1:5] [::2]      array slice
+//   [?(@.a.b)]       filter by existence
+//   [?(@.a < 3)]     filter by comparison with a number, 'string', true, false or null.
+//                    the strings are compared as written, without unescaping.
+// the path is compiled once into a sequence of instructions,
+// which are evaluated over the tokens of the document.
+struct jsonpath {
+    jsonpath() = default;
+    template<std::size_t N>
+    explicit jsonpath(const char (&str)[N])
+        :jsonpath{str, N-1}
+    {}
+    template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
+    explicit jsonpath(T str)
+        :jsonpath{str, std::strlen(str)}
+    {}
+    jsonpath(const char *str, std::size_t len)
+        :m_valid{compile(str, len)}
+    {}
+
+    bool is_valid() const { return m_valid; }
+    // number of instructions
+    std::size_t size() const { return m_code.size(); }
+
+    // appends the matched values to the `out`, returns the number of matched values
+    std::size_t select(const iterator &it, std::vector<iterator> &out) const {
+        if ( !m_valid || !it.cur ) {
+            return 0;
+        }
+
+        std::vector<token *> cur{it.cur}, next, tmp;
+        for ( const auto &in: m_code ) {
+            next.clear();
+            // the descendants of the previous value are already selected
+            const token *covered_beg = nullptr;
+            const token *covered_end = nullptr;
+            for ( auto *t: cur ) {
+                if ( in.op == op_t::descend && t > covered_beg && t < covered_end ) {
+                    continue;
+                }
+                apply(in, t, next, tmp);
+                if ( in.op == op_t::descend && !fj_is_simple_type_macro(t->type) ) {
+                    covered_beg = t;
+                    covered_end = details::end_token(t);
+                }
+            }
+            cur.swap(next);
+            if ( cur.empty() ) {
+                return 0;
+            }
+        }
+
+        out.reserve(out.size() + cur.size());
+        for ( auto *t: cur ) {
+            out.push_back(t == it.cur ? it : details::make_iterator(t));
+        }
+
+        return cur.size();
+    }
+    std::size_t select(const parser *p, std::vector<iterator> &out) const {
+        assert(p && p->toks_beg);
+
+        return select(iter_begin(p), out);
+    }
+    std::vector<iterator> select(const iterator &it) const {
+        std::vector<iterator> res;
+        select(it, res);
+
+        return res;
+    }
+    std::vector<iterator> select(const parser *p) const {
+        std::vector<iterator> res;
+        select(p, res);
+
+        return res;
+    }
+
+private:
+    enum class op_t: std::uint8_t { child, wildcard, index, slice, filter, descend };
+    enum class cmp_t: std::uint8_t { exists, eq, ne, lt, le, gt, ge };
+
+    struct key_t {
+        std::size_t offset;
+        std::size_t len;
+        std::uint32_t hash;
+    };
+
+    struct instr_t {
+        op_t op;
+        key_t key;              // child: the key. filter: the string literal
+        std::ptrdiff_t beg;     // index, slice
+        std::ptrdiff_t end;     // slice
+        std::ptrdiff_t step;    // slice
+        bool has_beg;           // slice
+        bool has_end;           // slice
+        cmp_t cmp;              // filter
+        token_type lit_type;    // filter
+        double num;             // filter: the number literal
+        std::size_t subs_beg;   // filter: the relative path, in m_subs
+        std::size_t subs_end;
+    };
+
+    static token* next_member(token *t)
+    { return fj_is_simple_type_macro(t->type) ? t + 1 : t->end + 1; }
+
+    token* find_key(token *obj, const key_t &key) const {
+        token *endtok = details::end_token(obj);
+        iterator beg{obj, obj + 1, endtok};
+        iterator end{endtok, endtok, endtok};
+        auto it = details::iter_find(m_buf.data() + key.offset, key.len, key.hash, beg, end);
+
+        return it.cur == endtok ? nullptr : it.cur;
+    }
+
+    void apply(const instr_t &in, token *t, std::vector<token *> &out, std::vector<token *> &tmp) const {
+        switch ( in.op ) {
+            case op_t::descend: {
+                out.push_back(t);
+                if ( !fj_is_simple_type_macro(t->type) ) {
+                    for ( auto *it = t + 1, *end = details::end_token(t); it != end; ++it ) {
+                        if ( it->type != FJ_TYPE_OBJECT_END && it->type != FJ_TYPE_ARRAY_END ) {
+                            out.push_back(it);
+                        }
+                    }
+                }
+                break;
+            }
+            case op_t::child: {
+                if ( t->type == FJ_TYPE_OBJECT ) {
+                    if ( auto *found = find_key(t, in.key) ) {
+                        out.push_back(found);
+                    }
+                }
+                break;
+            }
+            case op_t::wildcard:
+            case op_t::filter: {
+                if ( fj_is_simple_type_macro(t->type) ) {
+                    break;
+                }
+                for ( auto *it = t + 1, *end = details::end_token(t); it != end; it = next_member(it) ) {
+                    if ( in.op == op_t::wildcard || test(in, it) ) {
+                        out.push_back(it);
+                    }
+                }
+                break;
+            }
+            case op_t::index: {
+                if ( t->type != FJ_TYPE_ARRAY ) {
+                    break;
+                }
+                const auto size = static_cast<std::ptrdiff_t>(t->childs - 1);
+                const auto idx = in.beg < 0 ? in.beg + size : in.beg;
+                if ( idx >= 0 && idx < size ) {
+                    token *endtok = details::end_token(t);
+                    iterator beg{t, t + 1, endtok};
+                    iterator end{endtok, endtok, endtok};
+                    out.push_back(details::iter_find(static_cast<std::size_t>(idx), beg, end).cur);
+                }
+                break;
+            }
+            case op_t::slice: {
+                if ( t->type != FJ_TYPE_ARRAY || in.step == 0 ) {
+                    break;
+                }
+                tmp.clear();
+                for ( auto *it = t + 1, *end = details::end_token(t); it != end; it = next_member(it) ) {
+                    tmp.push_back(it);
+                }
+
+                // the python semantic
+                const auto size = static_cast<std::ptrdiff_t>(tmp.size());
+                const auto norm = [size](std::ptrdiff_t v, std::ptrdiff_t lo, std::ptrdiff_t hi) {
+                    v = v < 0 ? v + size : v;
+                    return v < lo ? lo : v > hi ? hi : v;
+                };
+                if ( in.step > 0 ) {
+                    const auto beg = in.has_beg ? norm(in.beg, 0, size) : 0;
+                    const auto end = in.has_end ? norm(in.end, 0, size) : size;
+                    for ( auto idx = beg; idx < end; idx += in.step ) {
+                        out.push_back(tmp[static_cast<std::size_t>(idx)]);
+                    }
+                } else {
+                    const auto beg = in.has_beg ? norm(in.beg, -1, size - 1) : size - 1;
+                    const auto end = in.has_end ? norm(in.end, -1, size - 1) : -1;
+                    for ( auto idx = beg; idx > end; idx += in.step ) {
+                        out.push_back(tmp[static_cast<std::size_t>(idx)]);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    bool test(const instr_t &in, token *t) const {
+        for ( auto idx = in.subs_beg; idx != in.subs_end; ++idx ) {
+            if ( t->type != FJ_TYPE_OBJECT ) {
+                return false;
+            }
+            t = find_key(t, m_subs[idx]);
+            if ( !t ) {
+                return false;
+            }
+        }
+        if ( in.cmp == cmp_t::exists ) {
+            return true;
+        }
+        if ( t->type != in.lit_type ) {
+            return in.cmp == cmp_t::ne;
+        }
+
+        int res = 0;
+        switch ( in.lit_type ) {
+            case FJ_TYPE_NUMBER: {
+                const auto num = details::conv_to(t->val, t->vlen, double{});
+                res = num < in.num ? -1 : num > in.num ? 1 : 0;
+                break;
+            }
+            case FJ_TYPE_STRING: {
+                res = string_view{t->val, t->vlen}
+                    .compare(string_view{m_buf.data() + in.key.offset, in.key.len});
+                break;
+            }
+            default: {
+                // true, false, null: the equality only
+                const bool eq = t->vlen == in.key.len
+                    && std::memcmp(t->val, m_buf.data() + in.key.offset, in.key.len) == 0;
+                return in.cmp == cmp_t::eq ? eq : in.cmp == cmp_t::ne ? !eq : false;
+            }
+        }
+
+        switch ( in.cmp ) {
+            case cmp_t::eq: return res == 0;
+            case cmp_t::ne: return res != 0;
+            case cmp_t::lt: return res < 0;
+            case cmp_t::le: return res <= 0;
+            case cmp_t::gt: return res > 0;
+            case cmp_t::ge: return res >= 0;
+            default: return false;
+        }
+    }
+
+    /*********************************************************************************************/
+
+    static instr_t make_instr(op_t op) {
+        instr_t in{};
+        in.op = op;
+        in.step = 1;
+
+        return in;
+    }
+
+    key_t add_string(const char *str, std::size_t len) {
+        key_t key{m_buf.size(), len, details::key_hash(str, len)};
+        m_buf.append(str, len);
+
+        return key;
+    }
+
+    static bool is_name_char(char ch) {
+        return ch != '.' && ch != '[' && ch != ']' && ch != '(' && ch != ')'
+            && ch != ' ' && ch != '=' && ch != '!' && ch != '<' && ch != '>'
+        ;
+    }
+
+    static void skip_ws(const char *&p, const char *end) {
+        for ( ; p != end && *p == ' '; ++p )
+            ;
+    }
+
+    static bool parse_int(const char *&p, const char *end, std::ptrdiff_t *res) {
+        bool neg = p != end && *p == '-';
+        const char *b = p + static_cast<std::size_t>(neg);
+        const char *e = b;
+        for ( ; e != end && fj_is_digit_macro(*e); ++e )
+            ;
+        if ( e == b || e - b > 18 ) {
+            return false;
+        }
+
+        std::ptrdiff_t v{};
+        for ( ; b != e; ++b ) {
+            v = v * 10 + (*b - '0');
+        }
+        *res = neg ? -v : v;
+        p = e;
+
+        return true;
+    }
+
+    bool parse_quoted(const char *&p, const char *end, key_t *key) {
+        const char quote = *p++;
+        const char *b = p;
+        for ( ; p != end && *p != quote; ++p )
+            ;
+        if ( p == end ) {
+            return false;
+        }
+        *key = add_string(b, static_cast<std::size_t>(p - b));
+        ++p;
+
+        return true;
+    }
+
+    bool compile_filter(const char *&p, const char *end) {
+        auto in = make_instr(op_t::filter);
+        skip_ws(p, end);
+        if ( p == end || *p != '@' ) {
+            return false;
+        }
+        ++p;
+
+        in.subs_beg = m_subs.size();
+        while ( p != end && *p == '.' ) {
+            const char *b = ++p;
+            for ( ; p != end && is_name_char(*p); ++p )
+                ;
+            if ( p == b ) {
+                return false;
+            }
+            m_subs.push_back(add_string(b, static_cast<std::size_t>(p - b)));
+        }
+        in.subs_end = m_subs.size();
+
+        skip_ws(p, end);
+        if ( p == end ) {
+            return false;
+        }
+        if ( *p != ')' ) {
+            static const struct { const char *str; cmp_t cmp; } ops[] = {
+                 {"==", cmp_t::eq}, {"!=", cmp_t::ne}, {"<=", cmp_t::le}
+                ,{">=", cmp_t::ge}, {"<", cmp_t::lt}, {">", cmp_t::gt}
+            };
+            in.cmp = cmp_t::exists;
+            for ( const auto &op: ops ) {
+                const auto len = std::strlen(op.str);
+                if ( static_cast<std::size_t>(end - p) >= len && std::memcmp(p, op.str, len) == 0 ) {
+                    in.cmp = op.cmp;
+                    p += len;
+                    break;
+                }
+            }
+            if ( in.cmp == cmp_t::exists ) {
+                return false;
+            }
+
+            skip_ws(p, end);
+            if ( p == end ) {
+                return false;
+            }
+            if ( *p == '\'' || *p == '"' ) {
+                in.lit_type = FJ_TYPE_STRING;
+                if ( !parse_quoted(p, end, &in.key) ) {
+                    return false;
+                }
+            } else {
+                const char *b = p;
+                for ( ; p != end && *p != ' ' && *p != ')'; ++p )
+                    ;
+                const auto len = static_cast<std::size_t>(p - b);
+                if ( len == 0 || len > 300 ) {
+                    return false;
+                }
+                if ( (len == 4 && std::memcmp(b, "true", 4) == 0)
+                    || (len == 5 && std::memcmp(b, "false", 5) == 0) )
+                {
+                    in.lit_type = FJ_TYPE_BOOL;
+                } else if ( len == 4 && std::memcmp(b, "null", 4) == 0 ) {
+                    in.lit_type = FJ_TYPE_NULL;
+                } else if ( *b == '-' || fj_is_digit_macro(*b) ) {
+                    in.lit_type = FJ_TYPE_NUMBER;
+                    in.num = details::conv_to(b, len, double{});
+                } else {
+                    return false;
+                }
+                in.key = add_string(b, len);
+            }
+            skip_ws(p, end);
+        }
+        if ( p == end || *p != ')' ) {
+            return false;
+        }
+        ++p;
+        m_code.push_back(in);
+
+        return true;
+    }
+
+    // the `p` is pointing to '['
+    bool compile_bracket(const char *&p, const char *end) {
+        ++p;
+        if ( p == end ) {
+            return false;
+        }
+
+        if ( *p == '*' ) {
+            ++p;
+            m_code.push_back(make_instr(op_t::wildcard));
+        } else if ( *p == '\'' || *p == '"' ) {
+            auto in = make_instr(op_t::child);
+            if ( !parse_quoted(p, end, &in.key) ) {
+                return false;
+            }
+            m_code.push_back(in);
+        } else if ( *p == '?' ) {
+            if ( ++p == end || *p != '(' ) {
+                return false;
+            }
+            ++p;
+            if ( !compile_filter(p, end) ) {
+                return false;
+            }
+        } else {
+            auto in = make_instr(op_t::index);
+            in.has_beg = parse_int(p, end, &in.beg);
+            if ( p != end && *p == ':' ) {
+                in.op = op_t::slice;
+                ++p;
+                in.has_end = parse_int(p, end, &in.end);
+                if ( p != end && *p == ':' ) {
+                    ++p;
+                    if ( !parse_int(p, end, &in.step) ) {
+                        in.step = 1;
+                    }
+                }
+            } else if ( !in.has_beg ) {
+                return false;
+            }
+            m_code.push_back(in);
+        }
+
+        if ( p == end || *p != ']' ) {
+            return false;
+        }
+        ++p;
+
+        return true;
+    }
+
+    bool compile(const char *str, std::size_t len) {
+        const char *p = str;
+        const char *end = str + len;
+        if ( p == end || *p != '$' ) {
+            return false;
+        }
+
+        for ( ++p; p != end; ) {
+            if ( *p == '[' ) {
+                if ( !compile_bracket(p, end) ) {
+                    return false;
+                }
+                continue;
+            }
+            if ( *p != '.' ) {
+                return false;
+            }
+
+            ++p;
+            if ( p != end && *p == '.' ) {
+                ++p;
+                m_code.push_back(make_instr(op_t::descend));
+                if ( p != end && *p == '[' ) {
+                    if ( !compile_bracket(p, end) ) {
+                        return false;
+                    }
+                    continue;
+                }
+            }
+            if ( p == end ) {
+                return false;
+            }
+            if ( *p == '*' ) {
+                ++p;
+                m_code.push_back(make_instr(op_t::wildcard));
+                continue;
+            }
+
+            const char *b = p;
+            for ( ; p != end && is_name_char(*p); ++p )
+                ;
+            if ( p == b ) {
+                return false;
+            }
+            auto in = make_instr(op_t::child);
+            in.key = add_string(b, static_cast<std::size_t>(p - b));
+            m_code.push_back(in);
+        }
+
+        return true;
+    }
+
+    std::string m_buf;
+    std::vector<key_t> m_subs;
+    std::vector<instr_t> m_code;
+    bool m_valid = false;
+};
+
+/*************************************************************************************************/
+// unescaping of strings
+
+// the bump allocator for the decoded strings, the memory is released by clear() or the dtor.
+struct arena {
+    explicit arena(
+         std::size_t chunk_size = 4096
+        ,alloc_fnptr alloc_fn = &malloc
+        ,free_fnptr free_fn = &free)
+        :m_chunks{nullptr}
+        ,m_chunk_size{chunk_size}
+        ,m_alloc_fn{alloc_fn}
+        ,m_free_fn{free_fn}
+    {}
+    arena(const arena &) = delete;
+    arena& operator= (const arena &) = delete;
+    ~arena() { clear(); }
+
+    // returns nullptr if the `alloc_fn` fails
+    char* alloc(std::size_t size)
+    { return static_cast<char *>(details::chunk_alloc(m_chunks, size, m_chunk_size, m_alloc_fn)); }
+
+    void clear() { details::chunk_free_all(m_chunks, m_free_fn); }
+
+private:
+    details::arena_chunk *m_chunks;
+    std::size_t m_chunk_size;
+    alloc_fnptr m_alloc_fn;
+    free_fnptr m_free_fn;
+};
+
+// returns the value of the STRING with the escapes decoded into the arena.
+// the original value is returned as is if it has no escapes.
+// for other types the value is returned as is.
+inline string_view unescape(const iterator &it, arena &a) {
+    const auto str = it.value();
+    if ( !it.is_string() || !it.is_value_escaped() ) {
+        return str;
+    }
+
+    char *buf = a.alloc(str.size());
+    if ( !buf ) {
+        return {static_cast<const char *>(nullptr), std::size_t{0}};
+    }
+    const auto len = details::unescape(str.data(), str.size(), buf, str.size());
+
+    return {buf, len};
+}
+
+// the same as unescape(), but decodes into the `buf`.
+// the buffer of `it.value().size()` bytes is always enough,
+// the view with nullptr is returned if the `size` is not enough.
+inline string_view unescape_to(const iterator &it, char *buf, std::size_t size) {
+    const auto str = it.value();
+    if ( !it.is_string() || !it.is_value_escaped() ) {
+        return str;
+    }
+
+    const auto len = details::unescape(str.data(), str.size(), buf, size);
+    if ( len == std::string::npos ) {
+        return {static_cast<const char *>(nullptr), std::size_t{0}};
+    }
+
+    return {buf, len};
+}
+
+inline string_view unescape_to(const iterator &it, std::string &buf) {
+    const auto str = it.value();
+    if ( !it.is_string() || !it.is_value_escaped() ) {
+        return str;
+    }
+
+    buf.resize(str.size());
+    buf.resize(details::unescape(str.data(), str.size(), &buf[0], buf.size()));
+
+    return {buf.data(), buf.size()};
+}
+
+/*************************************************************************************************/
+// bulk extraction of arrays
+
+namespace details {
+
+template<typename T>
+bool is_convertible_type(token_type type) {
+    return std::is_same<T, bool>::value ? type == FJ_TYPE_BOOL : type == FJ_TYPE_NUMBER;
+}
+
+// the `n` digits in [1..8] by the eight bytes at once, the bytes after them
+// are replaced by the leading '0's
+inline std::uint64_t load_digits(const char *ptr, std::size_t n) {
+    const auto shift = static_cast<unsigned>(8 * (8 - n));
+    const auto v = load_eight_bytes(ptr);
+
+    return shift ? (v << shift) | (0x3030303030303030ull >> (64 - shift)) : v;
+}
+
+// the short numbers without the sign, as `w / 10^frac`: up to 16 digits of the integers,
+// up to 8 integral and 8 fractional digits of the others. the digits are read by the eight
+// bytes at once, the bytes up to the `limit` are readable.
+inline bool parse_short_number(
+     const char *ptr
+    ,std::size_t len
+    ,bool is_integer
+    ,const char *limit
+    ,std::uint64_t *w
+    ,std::size_t *frac)
+{
+    static constexpr std::uint64_t pow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000};
+    static constexpr std::uint64_t ones = 0x0101010101010101ull;
+    if ( !limit || limit - ptr < 9 ) {
+        return false;
+    }
+
+    if ( is_integer ) {
+        if ( len <= 8 ) {
+            *w = parse_eight_digits(load_digits(ptr, len));
+        } else if ( len <= 16 ) {
+            *w = parse_eight_digits(load_digits(ptr, len - 8)) * pow10[8]
+                + parse_eight_digits(load_eight_bytes(ptr + len - 8));
+        } else {
+            return false;
+        }
+        *frac = 0;
+
+        return true;
+    }
+
+    // the position of the point by the zero byte
+    const auto dots = load_eight_bytes(ptr) ^ (ones * '.');
+    const auto found = (dots - ones) & ~dots & (ones * 0x80);
+    const auto ilen = found ? static_cast<std::size_t>(ctz64(found) / 8) : 8u;
+    if ( !ilen || ilen >= len || ptr[ilen] != '.' ) {
+        return false;
+    }
+    const auto flen = len - ilen - 1;
+    const char *fptr = ptr + ilen + 1;
+    if ( flen > 8 || limit - fptr < 8 ) {
+        return false;
+    }
+    // the exponent is not a digit
+    const auto fraction = load_digits(fptr, flen);
+    if ( !is_eight_digits(fraction) ) {
+        return false;
+    }
+    *w = parse_eight_digits(load_digits(ptr, ilen)) * pow10[flen] + parse_eight_digits(fraction);
+    *frac = flen;
+
+    return true;
+}
+
+// the fast paths for the common short numbers, the others are converted by try_conv().
+// the kinds of the numbers are known from the flags set by the parser.
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, bool>::type
+extract_fast(const token *t, const char *limit, T *out) {
+    if ( t->type != FJ_TYPE_NUMBER
+        || (t->flags & (FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_HEX)) != FJ_FLAG_NUM_INTEGER )
+    {
+        return false;
+    }
+
+    const bool neg = (t->flags & FJ_FLAG_NUM_NEGATIVE) != 0;
+    const auto skip = static_cast<std::size_t>(neg);
+    std::uint64_t w;
+    std::size_t frac;
+    if ( (neg && std::is_unsigned<T>::value)
+        || !parse_short_number(t->val + skip, t->vlen - skip, true, limit, &w, &frac) )
+    {
+        return false;
+    }
+    const auto max = static_cast<std::uint64_t>((std::numeric_limits<T>::max)());
+    if ( w > max + static_cast<std::uint64_t>(neg) ) {
+        return false;
+    }
+    using unsigned_type = typename std::make_unsigned<T>::type;
+    *out = neg
+        ? static_cast<T>(static_cast<unsigned_type>(~static_cast<unsigned_type>(w) + 1u))
+        : static_cast<T>(w)
+    ;
+
+    return true;
+}
+
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+extract_fast(const token *t, const char *limit, T *out) {
+    using traits = float_traits<double>;
+    if ( t->type != FJ_TYPE_NUMBER || (t->flags & FJ_FLAG_NUM_HEX) ) {
+        return false;
+    }
+
+    const bool neg = (t->flags & FJ_FLAG_NUM_NEGATIVE) != 0;
+    const auto skip = static_cast<std::size_t>(neg);
+    const bool is_integer = (t->flags & FJ_FLAG_NUM_INTEGER) != 0;
+    std::uint64_t w;
+    std::size_t frac;
+    if ( !parse_short_number(t->val + skip, t->vlen - skip, is_integer, limit, &w, &frac)
+        || w > traits::max_exact_mantissa || frac > static_cast<std::size_t>(traits::max_exact_pow10) )
+    {
+        return false;
+    }
+    // both are exact, so the division is rounded once
+    double v = static_cast<double>(w);
+    v = frac ? v / traits::exact_pow10(static_cast<int>(frac)) : v;
+    // the float is rounded twice, which differs only for the halfway points between the floats
+    if ( !std::is_same<T, double>::value ) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        if ( (bits & 0x1fffffffull) == 0x10000000ull ) {
+            return false;
+        }
+    }
+    *out = static_cast<T>(neg ? -v : v);
+
+    return true;
+}
+
+template<typename T>
+typename std::enable_if<std::is_same<T, bool>::value, bool>::type
+extract_fast(const token *t, const char *, T *out) {
+    if ( t->type != FJ_TYPE_BOOL ) {
+        return false;
+    }
+    *out = *t->val == 't';
+
+    return true;
+}
+
+// the elements of the array of simple types are the consecutive tokens,
+// the source is readable up to the `limit`.
+// returns the number of converted, stops on the first not convertible.
+template<typename T>
+std::size_t extract_range(const token *toks, std::size_t n, const char *limit, T *out) {
+    for ( std::size_t idx = 0; idx < n; ++idx ) {
+        const token *t = toks + idx;
+        if ( extract_fast(t, limit, out + idx) ) {
+            continue;
+        }
+        if ( !is_convertible_type<T>(t->type) || try_conv(t->val, t->vlen, out + idx) != FJ_EC_OK ) {
+            return idx;
+        }
+    }
+
+    return n;
+}
+
+#ifdef __FJ__EXTRACT_ARRAY_THREADS
+// splits the array into the chunks of FJ_EXTRACT_ARRAY_MT_CHUNK elements at least,
+// converted by up to `threads` threads.
+// returns the number of elements converted before the first error.
+template<typename T>
+std::size_t extract_range_mt(const token *toks, std::size_t n, const char *limit, T *out, std::size_t threads) {
+    const std::size_t num = (std::min)(threads ? threads : 1u, n / FJ_EXTRACT_ARRAY_MT_CHUNK);
+    if ( num < 2 ) {
+        return extract_range(toks, n, limit, out);
+    }
+
+    const std::size_t per = (n + num - 1) / num;
+    std::vector<std::size_t> res(num);
+    std::vector<std::thread> workers;
+    workers.reserve(num - 1);
+    for ( std::size_t idx = 1; idx < num; ++idx ) {
+        workers.emplace_back([=, &res] {
+            const std::size_t beg = idx * per;
+            const std::size_t cnt = (std::min)(per, n - beg);
+            res[idx] = beg + extract_range(toks + beg, cnt, limit, out + beg);
+        });
+    }
+    res[0] = extract_range(toks, (std::min)(per, n), limit, out);
+    for ( auto &it: workers ) {
+        it.join();
+    }
+
+    for ( std::size_t idx = 0; idx < num; ++idx ) {
+        if ( res[idx] != (std::min)((idx + 1) * per, n) ) {
+            return res[idx];
+        }
+    }
+
+    return n;
+}
+#endif // __FJ__EXTRACT_ARRAY_THREADS
+
+} // ns details
+
+// converts up to `n` elements of the ARRAY pointed by the iterator into `out`,
+// with the same rules as for try_to().
+// returns the number of converted elements, the conversion stops on the first
+// element which is not a number (or not a bool, for bool).
+// the large arrays are converted using threads if __FJ__EXTRACT_ARRAY_THREADS is defined.
+// the ARRAYs of more than 65534 elements need the wider FJ_CHILDS_TYPE, e.g. std::uint32_t,
+// the parser stops with FJ_EC_CHILDS_OVERFLOW otherwise.
+template<typename T>
+std::size_t extract_array(const iterator &it, T *out, std::size_t n) {
+    static_assert(std::is_arithmetic<T>::value, "only the arithmetic types are supported");
+
+    if ( !it.cur || !it.is_array() ) {
+        return 0;
+    }
+
+    n = (std::min)(n, static_cast<std::size_t>(it.cur->childs - 1u));
+    // the source is readable up to the closing bracket
+    const token *end = details::end_token(it.cur);
+    const char *limit = end->val ? end->val + 1 : nullptr;
+#ifdef __FJ__EXTRACT_ARRAY_THREADS
+    return details::extract_range_mt(it.cur + 1, n, limit, out, std::thread::hardware_concurrency());
+#else
+    return details::extract_range(it.cur + 1, n, limit, out);
+#endif // __FJ__EXTRACT_ARRAY_THREADS
+}
+
+// the `out` is resized to the number of converted elements
+template<typename T>
+std::size_t extract_array(const iterator &it, std::vector<T> &out) {
+    out.resize(it.cur && it.is_array() ? it.cur->childs - 1u : 0u);
+    out.resize(extract_array(it, out.data(), out.size()));
+
+    return out.size();
+}
+
+/*************************************************************************************************/
+// multi-path extraction
+
+// the set of JSON Pointers merged into a trie, which is matched
+// against the document in a single pass over the tokens.
+// extractor ex{"/id", "/user/name", "/items/0/price"};
+// iterator out[3];
+// ex.extract(parser, out);
+struct extractor {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    extractor()
+        :m_nodes(1)
+    {}
+    extractor(std::initializer_list<const char *> paths)
+        :extractor{}
+    {
+        for ( const auto *path: paths ) {
+            add(path, std::strlen(path));
+        }
+    }
+
+    // returns the position of the path in the output.
+    // a path with the syntax error is never matched, and makes the extractor not valid.
+    std::size_t add(const char *path, std::size_t len) {
+        const auto idx = m_paths++;
+        pointer ptr{path, len};
+        if ( !ptr.is_valid() ) {
+            m_valid = false;
+
+            return idx;
+        }
+
+        std::size_t node = 0;
+        for ( auto seg = 0u; seg < ptr.size(); ++seg ) {
+            const auto key = ptr.segment(seg);
+            std::size_t child = npos;
+            for ( auto c: m_nodes[node].childs ) {
+                const auto &ckey = m_nodes[c].key;
+                if ( ckey.size() == key.size() && std::memcmp(ckey.data(), key.data(), key.size()) == 0 ) {
+                    child = c;
+                    break;
+                }
+            }
+            if ( child == npos ) {
+                child = m_nodes.size();
+                m_nodes.push_back(node_t{});
+                auto &n = m_nodes.back();
+                n.key.assign(key.data(), key.size());
+                n.hash = details::key_hash8(details::key_hash(key.data(), key.size()));
+                n.idx = details::parse_array_index(key.data(), key.size());
+                m_nodes[node].childs.push_back(child);
+            }
+            node = child;
+        }
+        m_nodes[node].paths.push_back(idx);
+
+        return idx;
+    }
+    template<std::size_t N>
+    std::size_t add(const char (&path)[N]) { return add(path, N-1); }
+    template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
+    std::size_t add(T path) { return add(path, std::strlen(path)); }
+
+    bool is_valid() const { return m_valid; }
+    // number of paths
+    std::size_t size() const { return m_paths; }
+
+    // fills the `out[size()]` by the values found, the missing are left as not valid iterators.
+    // returns the number of found paths.
+    std::size_t extract(const iterator &it, iterator *out) const {
+        for ( auto idx = 0u; idx < m_paths; ++idx ) {
+            out[idx] = iterator{};
+        }
+        if ( !it.cur ) {
+            return 0;
+        }
+
+        std::size_t found = 0;
+        for ( auto idx: m_nodes[0].paths ) {
+            if ( !out[idx].cur ) {
+                out[idx] = it;
+                ++found;
+            }
+        }
+
+        // every node is matched once at most, so the flags are not reset between the containers
+        unsigned char small[64];
+        std::vector<unsigned char> heap;
+        unsigned char *seen = small;
+        if ( m_nodes.size() > sizeof(small) ) {
+            heap.resize(m_nodes.size());
+            seen = heap.data();
+        }
+        std::memset(seen, 0, m_nodes.size());
+        walk(m_nodes[0], it.cur, out, found, seen);
+
+        return found;
+    }
+    std::size_t extract(const parser *p, iterator *out) const {
+        assert(p && p->toks_beg);
+
+        return extract(iter_begin(p), out);
+    }
+    std::size_t extract(const iterator &it, std::vector<iterator> &out) const {
+        out.resize(m_paths);
+
+        return extract(it, out.data());
+    }
+    std::size_t extract(const parser *p, std::vector<iterator> &out) const {
+        out.resize(m_paths);
+
+        return extract(p, out.data());
+    }
+
+private:
+    struct node_t {
+        std::string key;
+        std::uint8_t hash;              // key_hash8() of the key
+        std::size_t idx;                // the array index, or npos
+        std::vector<std::size_t> childs;
+        std::vector<std::size_t> paths; // the paths ending at this node
+    };
+
+    // the members not referenced by the trie are skipped with their subtrees
+    void walk(const node_t &node, token *t, iterator *out, std::size_t &found, unsigned char *seen) const {
+        if ( node.childs.empty() || fj_is_simple_type_macro(t->type) ) {
+            return;
+        }
+
+        const bool is_object = t->type == FJ_TYPE_OBJECT;
+        // the first of the duplicated keys wins, the next ones are skipped with their subtrees
+        std::size_t matched = 0;
+        std::size_t member = 0;
+        const token *end = details::end_token(t);
+        for ( token *it = t + 1; it != end && found != m_paths; ++member ) {
+            token *next = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1;
+            for ( auto ci: node.childs ) {
+                if ( seen[ci] ) {
+                    continue;
+                }
+                const auto &child = m_nodes[ci];
+                const bool match = is_object
+                    ? (it->flags & FJ_FLAG_KEY_ESCAPED)
+                        ? details::unescaped_equal(it->key, it->klen, child.key.data(), child.key.size())
+                        : (it->khash == child.hash && it->klen == child.key.size()
+                            && std::memcmp(it->key, child.key.data(), it->klen) == 0)
+                    : child.idx == member
+                ;
+                if ( !match ) {
+                    continue;
+                }
+
+                seen[ci] = 1;
+                for ( auto idx: child.paths ) {
+                    if ( !out[idx].cur ) {
+                        out[idx] = details::make_iterator(it);
+                        ++found;
+                    }
+                }
+                walk(child, it, out, found, seen);
+                ++matched;
+                break;
+            }
+            if ( matched == node.childs.size() ) {
+                break;
+            }
+
+            it = next;
+        }
+    }
+
+    std::vector<node_t> m_nodes; // [0] is the root
+    std::size_t m_paths = 0;
+    bool m_valid = true;
+};
+
+/*************************************************************************************************/
+// serialization sinks
+
+// the sink is the output for walk_tokens() and serialize_to():
+//   void write(const char *ptr, std::size_t len);
+//   void flush();
+//   int error() const; // not zero stops the walk
+// the pointers passed to write() are valid until the end of the walk.
+
+// counts nothing, the walk returns the length
+struct length_sink {
+    void write(const char *, std::size_t) {}
+    void flush() {}
+    int error() const { return 0; }
+};
+
+// the fixed size buffer, ENOBUFS on overflow
+struct buffer_sink {
+    buffer_sink(char *buf, std::size_t size)
+        :m_beg{buf}
+        ,m_ptr{buf}
+        ,m_end{buf + size}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( static_cast<std::size_t>(m_end - m_ptr) < len ) {
+            m_ec = ENOBUFS;
+
+            return;
+        }
+        std::memcpy(m_ptr, ptr, len);
+        m_ptr += len;
+    }
+    void flush() {}
+    int error() const { return m_ec; }
+
+    char* data() const { return m_beg; }
+    std::size_t size() const { return static_cast<std::size_t>(m_ptr - m_beg); }
+
+private:
+    char *m_beg;
+    char *m_ptr;
+    char *m_end;
+    int m_ec = 0;
+};
+
+// appends to the string, which is grown by doubling, the reserved capacity is used first
+struct string_sink {
+    explicit string_sink(std::string &str)
+        :m_str{str}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( m_str.capacity() - m_str.size() < len ) {
+            m_str.reserve((std::max)(m_str.capacity() * 2, m_str.size() + len));
+        }
+        m_str.append(ptr, len);
+    }
+    void flush() {}
+    int error() const { return 0; }
+
+private:
+    std::string &m_str;
+};
+
+// EIO if the stream is failed
+struct ostream_sink {
+    explicit ostream_sink(std::ostream &os)
+        :m_os{os}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( !m_os.write(ptr, static_cast<std::streamsize>(len)) ) {
+            m_ec = EIO;
+        }
+    }
+    void flush() {
+        if ( !m_os.flush() ) {
+            m_ec = EIO;
+        }
+    }
+    int error() const { return m_ec; }
+
+private:
+    std::ostream &m_os;
+    int m_ec = 0;
+};
+
+namespace details {
+
+// the adjacent fragments are merged, so the runs of the source
+// are passed to the sink by a single write().
+template<typename Sink>
+struct span_writer {
+    explicit span_writer(Sink &sink)
+        :m_sink{sink}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( m_ptr + m_len == ptr ) {
+            m_len += len;
+        } else {
+            flush();
+            m_ptr = ptr;
+            m_len = len;
+        }
+        m_length += len;
+    }
+    // the fragment of the source, the next char can be taken by punct()
+    void write_src(const char *ptr, std::size_t len) {
+        write(ptr, len);
+        m_src = ptr + len;
+    }
+    // the char from the source if it's there, to continue the run
+    void punct(const char *str, const char *pos = nullptr) {
+        if ( pos ) {
+            write_src(pos, 1);
+
+            return;
+        }
+        if ( m_src && *m_src == *str ) {
+            write_src(m_src, 1);
+        } else {
+            write(str, 1);
+            m_src = nullptr;
+        }
+    }
+    void flush() {
+        if ( m_len ) {
+            m_sink.write(m_ptr, m_len);
+            m_len = 0;
+        }
+    }
+
+    std::size_t length() const { return m_length; }
+
+private:
+    Sink &m_sink;
+    const char *m_ptr = nullptr;
+    std::size_t m_len = 0;
+    const char *m_src = nullptr;
+    std::size_t m_length = 0;
+};
+
+// walks through the tokens [toksbeg..toksend] and writes them to the sink.
+// without the indentation the brackets are taken from the source by the tokens positions,
+// the commas and colons when they are there, so the minified source is written
+// by the runs of contiguous bytes.
+// returns the length of the output.
+template<bool WithIndentation, typename Sink>
+std::size_t walk_tokens(const token *toksbeg, const token *toksend, std::size_t indent, Sink &sink) {
+    static const char indent_str[] = "                                                                                ";
+    span_writer<Sink> out{sink};
+    std::size_t indent_scope = 0;
+    const auto put_indent = [&out](std::size_t n) {
+        for ( ; n > sizeof(indent_str) - 1; n -= sizeof(indent_str) - 1 ) {
+            out.write(indent_str, sizeof(indent_str) - 1);
         }
-        __FJ__CONSTEXPR_IF( ParseMode ) {
-            __FJ__CHECK_OVERFLOW(size, FJ_KLEN_TYPE, FJ_EC_KLEN_OVERFLOW);
-            current_token->klen = static_cast<FJ_KLEN_TYPE>(size);
+        out.write(indent_str, n);
+    };
+    const auto put_key = [&out](const token *t) {
+        out.write_src(t->key - 1, t->klen + 2u);
+        if ( WithIndentation ) {
+            out.write(":", 1);
+        } else {
+            out.punct(":");
         }
+    };
 
-        ec = check_and_skip(p, ':');
-        if ( ec != FJ_EC_OK ) {
-            return ec;
+    for ( auto *it = toksbeg; it != toksend + 1; ++it ) {
+        if ( it != toksbeg ) {
+            token_type ctype = it->type;
+            token_type ptype = (it-1)->type;
+            if ( (ctype != FJ_TYPE_ARRAY_END && ctype != FJ_TYPE_OBJECT_END ) &&
+                 (ptype != FJ_TYPE_OBJECT && ptype != FJ_TYPE_ARRAY) )
+            {
+                if ( WithIndentation ) {
+                    out.write(",\n", 2);
+                } else {
+                    out.punct(",");
+                }
+            }
         }
 
-        ch = __FJ__CUR_CHAR(p);
-        if ( ch == '[' || ch == '{' ) {
-            p->toks_cur -= 1;
-            const char *unused_str;
-            std::size_t unused_size;
-            ec = parse_value<ParseMode>(
-                 p
-                ,&unused_str
-                ,&unused_size
-                ,&(current_token->type)
-                ,startobj
-            );
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                startobj->flags = (startobj->flags == 0)
-                    ? startobj->flags
-                    : fj_is_simple_type_macro(current_token->type)
-                ;
+        switch ( it->type ) {
+            case FJ_TYPE_OBJECT:
+            case FJ_TYPE_ARRAY: {
+                if ( it->key ) {
+                    if ( WithIndentation ) {
+                        put_indent(indent_scope);
+                    }
+                    put_key(it);
+                }
+                const bool is_object = it->type == FJ_TYPE_OBJECT;
+                if ( WithIndentation ) {
+                    out.write(is_object ? "{\n" : "[\n", 2);
+                    indent_scope += indent;
+                } else {
+                    out.punct(is_object ? "{" : "[", it->val);
+                }
+                break;
             }
-        } else {
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                current_token->parent = startobj;
-                __FJ__CHECK_OVERFLOW(startobj->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-                ++startobj->childs;
+            case FJ_TYPE_OBJECT_END:
+            case FJ_TYPE_ARRAY_END: {
+                const char *str = it->type == FJ_TYPE_OBJECT_END ? "}" : "]";
+                if ( WithIndentation ) {
+                    indent_scope -= indent;
+                    out.write("\n", 1);
+                    put_indent(indent_scope);
+                    out.write(str, 1);
+                } else {
+                    out.punct(str, it->val);
+                }
+                break;
             }
-
-            ec = parse_value<ParseMode>(
-                 p
-                ,&(current_token->val)
-                ,&size
-                ,&(current_token->type)
-                ,startobj
-            );
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                __FJ__CHECK_OVERFLOW(size, FJ_VLEN_TYPE, FJ_EC_VLEN_OVERFLOW);
-                current_token->vlen = static_cast<FJ_VLEN_TYPE>(size);
+            case FJ_TYPE_NULL:
+            case FJ_TYPE_BOOL:
+            case FJ_TYPE_NUMBER:
+            case FJ_TYPE_STRING: {
+                if ( WithIndentation ) {
+                    put_indent(indent_scope);
+                }
+                if ( it->parent && it->parent->type != FJ_TYPE_ARRAY ) {
+                    put_key(it);
+                }
+                if ( it->type == FJ_TYPE_STRING ) {
+                    out.write_src(it->val - 1, it->vlen + 2u);
+                } else {
+                    out.write_src(it->val, it->vlen);
+                }
+                break;
             }
+            default: break;
         }
+        if ( sink.error() ) {
+            return out.length();
+        }
+    }
+    out.flush();
 
-        if ( ec != FJ_EC_OK ) {
-            return ec;
+    return out.length();
+}
+
+} // ns details
+
+// serializes the tokens pointed by [beg..end] into the sink.
+// returns the length of the output, the errors are reported by sink.error().
+template<typename Sink>
+std::size_t serialize_to(Sink &sink, const token *beg, const token *end, std::size_t indent = 0) {
+    const auto length = indent
+        ? details::walk_tokens<true>(beg, end, indent, sink)
+        : details::walk_tokens<false>(beg, end, indent, sink)
+    ;
+    if ( !sink.error() ) {
+        sink.flush();
+    }
+
+    return length;
+}
+
+template<typename Sink>
+std::size_t serialize_to(Sink &sink, const iterator &beg, const iterator &end, std::size_t indent = 0)
+{ return serialize_to(sink, beg.cur, end.end, indent); }
+
+/*************************************************************************************************/
+// JSON writer
+
+namespace details {
+
+// has the byte which needs the escaping: '"', '\\' or the control char
+inline bool needs_escape8(std::uint64_t v) {
+    static constexpr std::uint64_t ones = 0x0101010101010101ull;
+    static constexpr std::uint64_t highs = 0x8080808080808080ull;
+    const auto quote = v ^ (ones * '"');
+    const auto slash = v ^ (ones * '\\');
+    const auto res = ((v - ones * 0x20) & ~v)
+        | ((quote - ones) & ~quote)
+        | ((slash - ones) & ~slash)
+    ;
+
+    return (res & highs) != 0;
+}
+
+// the shortest escaping: '"', '\\' and the control chars only
+template<typename Out>
+void write_escaped(Out &out, const char *ptr, std::size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    const char *end = ptr + len;
+    const char *run = ptr;
+    for ( const char *it = ptr; it != end; ) {
+        if ( end - it >= 8 && !needs_escape8(load_eight_bytes(it)) ) {
+            it += 8;
+            continue;
         }
 
-        if ( __FJ__CUR_CHAR(p) == ',' ) {
-            p->str_cur++;
-            if ( *(p->str_cur) == '}' ) {
-                return FJ_EC_INVALID;
+        const auto ch = static_cast<unsigned char>(*it);
+        if ( ch >= 0x20 && ch != '"' && ch != '\\' ) {
+            ++it;
+            continue;
+        }
+
+        out.put(run, static_cast<std::size_t>(it - run));
+        char esc[6] = {'\\', 0, '0', '0', 0, 0};
+        std::size_t esclen = 2;
+        switch ( ch ) {
+            case '"': esc[1] = '"'; break;
+            case '\\': esc[1] = '\\'; break;
+            case '\b': esc[1] = 'b'; break;
+            case '\f': esc[1] = 'f'; break;
+            case '\n': esc[1] = 'n'; break;
+            case '\r': esc[1] = 'r'; break;
+            case '\t': esc[1] = 't'; break;
+            default: {
+                esc[1] = 'u';
+                esc[4] = hex[ch >> 4];
+                esc[5] = hex[ch & 0xf];
+                esclen = 6;
             }
         }
+        out.put(esc, esclen);
+        run = ++it;
     }
+    out.put(run, static_cast<std::size_t>(end - run));
+}
 
-    ec = check_and_skip(p, '}');
-    if ( ec != FJ_EC_OK ) {
-        return ec;
+// writes the digits at the end of the `buf`, returns the pointer to the first one
+inline char* format_uint64(char *end, std::uint64_t v) {
+    static const char digits[] =
+        "0001020304050607080910111213141516171819"
+        "2021222324252627282930313233343536373839"
+        "4041424344454647484950515253545556575859"
+        "6061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char *p = end;
+    for ( ; v >= 100; v /= 100 ) {
+        const auto idx = static_cast<std::size_t>(v % 100) * 2;
+        *--p = digits[idx + 1];
+        *--p = digits[idx];
     }
-
-    __FJ__CONSTEXPR_IF( ParseMode ) {
-        if ( p->toks_cur == p->toks_end ) {
-            return FJ_EC_NO_FREE_TOKENS;
-        }
-        auto *endobj = p->toks_cur++;
-        *endobj = token{};
-        endobj->type = FJ_TYPE_OBJECT_END;
-        endobj->parent = startobj;
-        __FJ__CHECK_OVERFLOW(endobj->parent->childs, FJ_CHILDS_TYPE, FJ_EC_CHILDS_OVERFLOW);
-        endobj->parent->childs += 1;
-        startobj->end = endobj;
+    if ( v >= 10 ) {
+        const auto idx = static_cast<std::size_t>(v) * 2;
+        *--p = digits[idx + 1];
+        *--p = digits[idx];
     } else {
-        ++p->toks_cur;
+        *--p = static_cast<char>('0' + v);
     }
 
-    return FJ_EC_OK;
+    return p;
 }
 
-template<bool ParseMode>
-inline error_code parse_value(
-     parser *p
-    ,const char **value
-    ,std::size_t *vlen
-    ,token_type *toktype
-    ,token *parent)
+template<typename T>
+typename std::enable_if<std::is_unsigned<T>::value, char *>::type
+format_int(char *end, T v) { return format_uint64(end, v); }
+
+template<typename T>
+typename std::enable_if<std::is_signed<T>::value, char *>::type
+format_int(char *end, T v) {
+    // the two's complement negation, is valid for the min() too
+    const auto u = static_cast<std::uint64_t>(static_cast<std::int64_t>(v));
+    if ( v >= 0 ) {
+        return format_uint64(end, u);
+    }
+
+    char *p = format_uint64(end, ~u + 1u);
+    *--p = '-';
+
+    return p;
+}
+
+// the 64-bit float f * 2^e used by the Grisu
+struct diy_fp {
+    std::uint64_t f;
+    int e;
+};
+
+// the product rounded to the 64 bits
+inline diy_fp mul(diy_fp l, diy_fp r) {
+    const auto p = mul_64x64(l.f, r.f);
+
+    return {p.hi + (p.lo >> 63), l.e + r.e + 64};
+}
+
+// the normalized 10^k for k in [-300, 324] with the step of 8, for the Grisu.
+// returns the one with the alpha <= c.e + e + 64 <= gamma, where the alpha is -60 and the gamma is -32.
+inline diy_fp cached_pow10(int e, int *k) {
+    struct cached { std::uint64_t f; int e; int k; };
+    static constexpr cached table[] = {
+         {0xab70fe17c79ac6caull, -1060, -300}
+        ,{0xff77b1fcbebcdc4full, -1034, -292}
+        ,{0xbe5691ef416bd60cull, -1007, -284}
+        ,{0x8dd01fad907ffc3cull,  -980, -276}
+        ,{0xd3515c2831559a83ull,  -954, -268}
+        ,{0x9d71ac8fada6c9b5ull,  -927, -260}
+        ,{0xea9c227723ee8bcbull,  -901, -252}
+        ,{0xaecc49914078536dull,  -874, -244}
+        ,{0x823c12795db6ce57ull,  -847, -236}
+        ,{0xc21094364dfb5637ull,  -821, -228}
+        ,{0x9096ea6f3848984full,  -794, -220}
+        ,{0xd77485cb25823ac7ull,  -768, -212}
+        ,{0xa086cfcd97bf97f4ull,  -741, -204}
+        ,{0xef340a98172aace5ull,  -715, -196}
+        ,{0xb23867fb2a35b28eull,  -688, -188}
+        ,{0x84c8d4dfd2c63f3bull,  -661, -180}
+        ,{0xc5dd44271ad3cdbaull,  -635, -172}
+        ,{0x936b9fcebb25c996ull,  -608, -164}
+        ,{0xdbac6c247d62a584ull,  -582, -156}
+        ,{0xa3ab66580d5fdaf6ull,  -555, -148}
+        ,{0xf3e2f893dec3f126ull,  -529, -140}
+        ,{0xb5b5ada8aaff80b8ull,  -502, -132}
+        ,{0x87625f056c7c4a8bull,  -475, -124}
+        ,{0xc9bcff6034c13053ull,  -449, -116}
+        ,{0x964e858c91ba2655ull,  -422, -108}
+        ,{0xdff9772470297ebdull,  -396, -100}
+        ,{0xa6dfbd9fb8e5b88full,  -369,  -92}
+        ,{0xf8a95fcf88747d94ull,  -343,  -84}
+        ,{0xb94470938fa89bcfull,  -316,  -76}
+        ,{0x8a08f0f8bf0f156bull,  -289,  -68}
+        ,{0xcdb02555653131b6ull,  -263,  -60}
+        ,{0x993fe2c6d07b7facull,  -236,  -52}
+        ,{0xe45c10c42a2b3b06ull,  -210,  -44}
+        ,{0xaa242499697392d3ull,  -183,  -36}
+        ,{0xfd87b5f28300ca0eull,  -157,  -28}
+        ,{0xbce5086492111aebull,  -130,  -20}
+        ,{0x8cbccc096f5088ccull,  -103,  -12}
+        ,{0xd1b71758e219652cull,   -77,   -4}
+        ,{0x9c40000000000000ull,   -50,    4}
+        ,{0xe8d4a51000000000ull,   -24,   12}
+        ,{0xad78ebc5ac620000ull,     3,   20}
+        ,{0x813f3978f8940984ull,    30,   28}
+        ,{0xc097ce7bc90715b3ull,    56,   36}
+        ,{0x8f7e32ce7bea5c70ull,    83,   44}
+        ,{0xd5d238a4abe98068ull,   109,   52}
+        ,{0x9f4f2726179a2245ull,   136,   60}
+        ,{0xed63a231d4c4fb27ull,   162,   68}
+        ,{0xb0de65388cc8ada8ull,   189,   76}
+        ,{0x83c7088e1aab65dbull,   216,   84}
+        ,{0xc45d1df942711d9aull,   242,   92}
+        ,{0x924d692ca61be758ull,   269,  100}
+        ,{0xda01ee641a708deaull,   295,  108}
+        ,{0xa26da3999aef774aull,   322,  116}
+        ,{0xf209787bb47d6b85ull,   348,  124}
+        ,{0xb454e4a179dd1877ull,   375,  132}
+        ,{0x865b86925b9bc5c2ull,   402,  140}
+        ,{0xc83553c5c8965d3dull,   428,  148}
+        ,{0x952ab45cfa97a0b3ull,   455,  156}
+        ,{0xde469fbd99a05fe3ull,   481,  164}
+        ,{0xa59bc234db398c25ull,   508,  172}
+        ,{0xf6c69a72a3989f5cull,   534,  180}
+        ,{0xb7dcbf5354e9beceull,   561,  188}
+        ,{0x88fcf317f22241e2ull,   588,  196}
+        ,{0xcc20ce9bd35c78a5ull,   614,  204}
+        ,{0x98165af37b2153dfull,   641,  212}
+        ,{0xe2a0b5dc971f303aull,   667,  220}
+        ,{0xa8d9d1535ce3b396ull,   694,  228}
+        ,{0xfb9b7cd9a4a7443cull,   720,  236}
+        ,{0xbb764c4ca7a44410ull,   747,  244}
+        ,{0x8bab8eefb6409c1aull,   774,  252}
+        ,{0xd01fef10a657842cull,   800,  260}
+        ,{0x9b10a4e5e9913129ull,   827,  268}
+        ,{0xe7109bfba19c0c9dull,   853,  276}
+        ,{0xac2820d9623bf429ull,   880,  284}
+        ,{0x80444b5e7aa7cf85ull,   907,  292}
+        ,{0xbf21e44003acdd2dull,   933,  300}
+        ,{0x8e679c2f5e44ff8full,   960,  308}
+        ,{0xd433179d9c8cb841ull,   986,  316}
+        ,{0x9e19db92b4e31ba9ull,  1013,  324}
+    };
+    static_assert(sizeof(table) == 79 * sizeof(cached), "");
+
+    const int f = -60 - e - 1;
+    const int pk = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);
+    const auto &c = table[(300 + pk + 7) / 8];
+    assert(c.e + e + 64 >= -60 && c.e + e + 64 <= -32);
+    *k = c.k;
+
+    return {c.f, c.e};
+}
+
+// moves the last digit to the w, see the Loitsch's "Printing floating-point numbers quickly
+// and accurately with integers". returns false if the digits can't be proven the shortest and the closest.
+inline bool grisu_round_weed(char *digits, int len, std::uint64_t dist_high_w, std::uint64_t unsafe
+    ,std::uint64_t rest, std::uint64_t ten_kappa, std::uint64_t unit)
 {
-    char ch = __FJ__CUR_CHAR(p);
-    switch ( ch ) {
-        case '{': {
-            auto ec = parse_object<ParseMode>(p, parent);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_OBJECT;
-            }
-            break;
-        }
-        case '[': {
-            auto ec = parse_array<ParseMode>(p, parent);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_ARRAY;
-            }
-            break;
-        }
-        case 'n': {
-            auto ec = expect<ParseMode>(p, "null", value, vlen);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            // on root token
-            if ( p->toks_cur == p->toks_beg ) {
-                ++p->toks_cur;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_NULL;
-            }
-            break;
-        }
-        case 't': {
-            auto ec = expect<ParseMode>(p, "true", value, vlen);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            // on root token
-            if ( p->toks_cur == p->toks_beg ) {
-                ++p->toks_cur;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_BOOL;
-            }
-            break;
-        }
-        case 'f': {
-            auto ec = expect<ParseMode>(p, "false", value, vlen);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            // on root token
-            if ( p->toks_cur == p->toks_beg ) {
-                ++p->toks_cur;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_BOOL;
-            }
-            break;
+    const std::uint64_t small_dist = dist_high_w - unit;
+    const std::uint64_t big_dist = dist_high_w + unit;
+    while ( rest < small_dist && unsafe - rest >= ten_kappa
+        && (rest + ten_kappa < small_dist || small_dist - rest >= rest + ten_kappa - small_dist) )
+    {
+        --digits[len - 1];
+        rest += ten_kappa;
+    }
+    if ( rest < big_dist && unsafe - rest >= ten_kappa
+        && (rest + ten_kappa < big_dist || big_dist - rest > rest + ten_kappa - big_dist) )
+    {
+        return false;
+    }
+
+    return 2 * unit <= rest && rest <= unsafe - 4 * unit;
+}
+
+// the Grisu3: the digits of the scaled w between the scaled boundaries
+inline bool grisu_digits(diy_fp low, diy_fp w, diy_fp high, char *digits, int *len, int *kappa) {
+    std::uint64_t unit = 1;
+    const diy_fp too_low{low.f - unit, low.e};
+    const diy_fp too_high{high.f + unit, high.e};
+    std::uint64_t unsafe = too_high.f - too_low.f;
+    const int shift = -w.e;
+    const std::uint64_t one = 1ull << shift;
+    auto integrals = static_cast<std::uint32_t>(too_high.f >> shift);
+    std::uint64_t fractionals = too_high.f & (one - 1);
+
+    std::uint32_t divisor = 1;
+    for ( *kappa = 1; integrals / divisor >= 10; divisor *= 10, ++*kappa )
+        ;
+    *len = 0;
+    for ( ; *kappa > 0; divisor /= 10 ) {
+        digits[(*len)++] = static_cast<char>('0' + integrals / divisor);
+        integrals %= divisor;
+        --*kappa;
+        const std::uint64_t rest = (static_cast<std::uint64_t>(integrals) << shift) + fractionals;
+        if ( rest < unsafe ) {
+            return grisu_round_weed(digits, *len, too_high.f - w.f, unsafe, rest
+                ,static_cast<std::uint64_t>(divisor) << shift, unit);
         }
-        case '-':
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9': {
-            auto ec = parse_number<ParseMode>(p, value, vlen);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            // on root token
-            if ( p->toks_cur == p->toks_beg ) {
-                ++p->toks_cur;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_NUMBER;
-            }
-            break;
+    }
+    for ( ;; ) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe *= 10;
+        digits[(*len)++] = static_cast<char>('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        --*kappa;
+        if ( fractionals < unsafe ) {
+            return grisu_round_weed(digits, *len, (too_high.f - w.f) * unit, unsafe, fractionals, one, unit);
         }
-        case '"': {
-            auto ec = parse_string<ParseMode>(p, value, vlen);
-            if ( ec != FJ_EC_OK ) {
-                return ec;
-            }
-            // on root token
-            if ( p->toks_cur == p->toks_beg ) {
-                ++p->toks_cur;
-            }
-            __FJ__CONSTEXPR_IF( ParseMode ) {
-                *toktype = FJ_TYPE_STRING;
-            }
-            break;
+    }
+}
+
+// the shortest and the closest digits of the m * 2^e by the exact arithmetic, as the Steele & White /
+// Burger & Dybvig do: the v = r / s, the half-distances to the neighbours are m_plus / s and m_minus / s.
+// used when the Grisu can't decide.
+inline int bigint_digits(std::uint64_t m, int e, bool lower_closer, char *digits, int *point) {
+    const bool even = !(m & 1u);
+    bigint r{m}, s{1}, m_plus{1}, m_minus{1};
+    r.shl(static_cast<std::uint64_t>(1 + lower_closer + (e > 0 ? e : 0)));
+    s.shl(static_cast<std::uint64_t>(1 + lower_closer + (e < 0 ? -e : 0)));
+    m_plus.shl(static_cast<std::uint64_t>(lower_closer + (e > 0 ? e : 0)));
+    m_minus.shl(static_cast<std::uint64_t>(e > 0 ? e : 0));
+
+    // k is either the ceil(log2(v) * log10(2)) or the one greater
+    const int x = e + 63 - clz64(m);
+    int k = x > 0 ? ((x * 78913) >> 18) + 1 : -((-x * 78913) >> 18);
+    if ( k >= 0 ) {
+        s.mul_pow5(static_cast<std::uint64_t>(k));
+        s.shl(static_cast<std::uint64_t>(k));
+    } else {
+        const auto n = static_cast<std::uint64_t>(-k);
+        r.mul_pow5(n);
+        r.shl(n);
+        m_plus.mul_pow5(n);
+        m_plus.shl(n);
+        m_minus.mul_pow5(n);
+        m_minus.shl(n);
+    }
+    bigint high{r};
+    high.add(m_plus);
+    const int cmp = compare(high, s);
+    if ( even ? cmp >= 0 : cmp > 0 ) {
+        s.mul(std::uint32_t{10});
+        ++k;
+    }
+    *point = k;
+
+    for ( int len = 0;; ) {
+        r.mul(std::uint32_t{10});
+        m_plus.mul(std::uint32_t{10});
+        m_minus.mul(std::uint32_t{10});
+        int digit = 0;
+        for ( ; compare(r, s) >= 0; ++digit ) {
+            r.sub(s);
+        }
+        high = r;
+        high.add(m_plus);
+        const int low_cmp = compare(r, m_minus);
+        const int high_cmp = compare(high, s);
+        const bool low_ok = even ? low_cmp <= 0 : low_cmp < 0;
+        const bool high_ok = even ? high_cmp >= 0 : high_cmp > 0;
+        if ( low_ok && high_ok ) {
+            // the closer one, or the even one on the tie
+            bigint twice{r};
+            twice.shl(1);
+            const int half = compare(twice, s);
+            digit += half > 0 || (half == 0 && (digit & 1));
+        } else if ( high_ok ) {
+            ++digit;
+        }
+        digits[len++] = static_cast<char>('0' + digit);
+        if ( low_ok || high_ok ) {
+            return len;
         }
-        default:
-            if ( ch == ((int)-1) ) {
-                return FJ_EC_INCOMPLETE;
-            } else {
-                return FJ_EC_INVALID;
-            }
     }
+}
 
-    return FJ_EC_OK;
+// the shortest digits which are parsed back to the same positive finite T, the closest one to
+// the v of them. returns the number of the digits, the `point` is the position of the decimal point:
+// v = 0.d1d2...dn * 10^point. the `digits` of 20 bytes is enough.
+template<typename T>
+int shortest_digits(T v, char *digits, int *point) {
+    using traits = float_traits<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr bits_type mantissa_mask = (bits_type{1} << traits::mantissa_bits) - 1;
+    bits_type bits;
+    std::memcpy(&bits, &v, sizeof(v));
+    const auto biased = static_cast<int>(bits >> traits::mantissa_bits);
+    std::uint64_t m = bits & mantissa_mask;
+    int e = 1 - traits::bias - traits::mantissa_bits;
+    if ( biased ) {
+        m |= std::uint64_t{1} << traits::mantissa_bits;
+        e += biased - 1;
+    }
+    // the lower neighbour is closer at the powers of two
+    const bool lower_closer = !(bits & mantissa_mask) && biased > 1;
+
+    const int wz = clz64(m);
+    const diy_fp w{m << wz, e - wz};
+    const int hz = clz64(2 * m + 1);
+    const diy_fp high{(2 * m + 1) << hz, e - 1 - hz};
+    const diy_fp low = lower_closer
+        ? diy_fp{(4 * m - 1) << (hz - 1), high.e}
+        : diy_fp{(2 * m - 1) << hz, high.e}
+    ;
+    int k = 0;
+    const diy_fp c = cached_pow10(high.e, &k);
+    int len = 0, kappa = 0;
+    if ( grisu_digits(mul(low, c), mul(w, c), mul(high, c), digits, &len, &kappa) ) {
+        *point = len + kappa - k;
+
+        return len;
+    }
+
+    return bigint_digits(m, e, lower_closer, digits, point);
 }
 
-/*************************************************************************************************/
+// places the digits as Number.prototype.toString() does: without the exponent for 1e-7 <= |v| < 1e21
+inline std::size_t place_digits(char *buf, bool neg, const char *digits, int len, int point) {
+    char *out = buf;
+    if ( neg ) {
+        *out++ = '-';
+    }
+    if ( len <= point && point <= 21 ) {
+        std::memcpy(out, digits, static_cast<std::size_t>(len));
+        out += len;
+        for ( int i = len; i < point; ++i ) {
+            *out++ = '0';
+        }
+    } else if ( 0 < point && point <= 21 ) {
+        std::memcpy(out, digits, static_cast<std::size_t>(point));
+        out += point;
+        *out++ = '.';
+        std::memcpy(out, digits + point, static_cast<std::size_t>(len - point));
+        out += len - point;
+    } else if ( -6 < point && point <= 0 ) {
+        *out++ = '0';
+        *out++ = '.';
+        for ( int i = point; i < 0; ++i ) {
+            *out++ = '0';
+        }
+        std::memcpy(out, digits, static_cast<std::size_t>(len));
+        out += len;
+    } else {
+        *out++ = digits[0];
+        if ( len > 1 ) {
+            *out++ = '.';
+            std::memcpy(out, digits + 1, static_cast<std::size_t>(len - 1));
+            out += len - 1;
+        }
+        *out++ = 'e';
+        *out++ = point > 0 ? '+' : '-';
+        char exp[8];
+        char *end = exp + sizeof(exp);
+        char *p = format_uint64(end, static_cast<std::uint64_t>(point > 0 ? point - 1 : 1 - point));
+        std::memcpy(out, p, static_cast<std::size_t>(end - p));
+        out += end - p;
+    }
 
-inline void init_parser(
-     parser *p
-    ,token *toksbeg
-    ,token *toksend
-    ,const char *strbeg
-    ,const char *strend
-    ,alloc_fnptr alloc_fn
-    ,free_fnptr free_fn
-    ,bool dyn_parser
-    ,bool dyn_tokens)
-{
-    // root token
-    if ( toksbeg ) {
-        toksbeg->type   = FJ_TYPE_INVALID;
-        toksbeg->key    = nullptr;
-        toksbeg->klen   = 0;
-        toksbeg->val    = nullptr;
-        toksbeg->vlen   = 0;
-        toksbeg->parent = nullptr;
-        toksbeg->childs = 0;
-        toksbeg->end    = nullptr;
+    return static_cast<std::size_t>(out - buf);
+}
+
+// the shortest representation which is parsed back to the same finite T, independent of the locale.
+// the `buf` of 32 bytes is enough.
+template<typename T>
+std::size_t format_float(char *buf, T v) {
+    using bits_type = typename float_traits<T>::bits_type;
+    bits_type bits;
+    std::memcpy(&bits, &v, sizeof(v));
+    const bool neg = (bits >> (sizeof(bits) * 8 - 1)) != 0;
+    char digits[20];
+    if ( v == 0 ) {
+        digits[0] = '0';
+
+        return place_digits(buf, neg, digits, 1, 1);
     }
 
-    p->str_beg   = strbeg;
-    p->str_cur   = strbeg;
-    p->str_end   = strend;
-    p->toks_beg  = toksbeg;
-    p->toks_cur  = toksbeg;
-    p->toks_end  = toksend;
-    p->alloc_fn  = alloc_fn;
-    p->free_fn   = free_fn;
-    p->error     = FJ_EC_INVALID;
-    p->dyn_parser= dyn_parser;
-    p->dyn_tokens= dyn_tokens;
-    p->ref_cnt   = 0;
+    int point = 0;
+    const int len = shortest_digits(neg ? -v : v, digits, &point);
+
+    return place_digits(buf, neg, digits, len, point);
 }
 
 } // ns details
 
-/*************************************************************************************************/
+// the streaming writer of JSON into the sink, see serialize_to() for the sinks.
+// the output is collected in the buffer allocated from the arena, which is passed
+// to the sink (and the sink is flushed) when it's full, so the sink is not required
+// to keep the pointers valid.
+// writer<string_sink> w{sink};
+// w.begin_object().key("id").value(1).key("tags").begin_array().value("a").end_array().end_object();
+// w.flush();
+template<typename Sink>
+struct writer {
+    explicit writer(Sink &sink, std::size_t bufsize = 4096)
+        :writer{sink, m_own_arena, bufsize}
+    {}
+    writer(Sink &sink, arena &a, std::size_t bufsize = 4096)
+        :m_sink{sink}
+        ,m_buf{a.alloc(bufsize)}
+        ,m_cap{m_buf ? bufsize : 0u}
+    {}
+    writer(const writer &) = delete;
+    writer& operator= (const writer &) = delete;
+    ~writer() { flush(); }
+
+    writer& begin_object() { separator(); put("{", 1); return open(); }
+    writer& end_object() { return close("}"); }
+    writer& begin_array() { separator(); put("[", 1); return open(); }
+    writer& end_array() { return close("]"); }
+
+    writer& key(string_view k) {
+        assert(m_depth && !m_after_key);
+        if ( !m_first ) {
+            put(",", 1);
+        }
+        m_first = false;
+        put("\"", 1);
+        details::write_escaped(*this, k.data(), k.size());
+        put("\":", 2);
+        m_after_key = true;
 
-// zero-alloc routines
+        return *this;
+    }
+    writer& key(const char *k) { return key(string_view{k, std::strlen(k)}); }
 
-inline parser make_parser(
-     token *toksbeg
-    ,token *toksend
-    ,const char *strbeg
-    ,const char *strend)
-{
-    parser p;
-    details::init_parser(
-         &p
-        ,toksbeg
-        ,toksend
-        ,strbeg
-        ,strend
-        ,nullptr
-        ,nullptr
-        ,false
-        ,false
-    );
+    writer& value(std::nullptr_t) { separator(); put("null", 4); return *this; }
+    writer& value(bool v) { separator(); v ? put("true", 4) : put("false", 5); return *this; }
+    writer& value(string_view v) {
+        separator();
+        put("\"", 1);
+        details::write_escaped(*this, v.data(), v.size());
+        put("\"", 1);
 
-    return p;
-}
+        return *this;
+    }
+    writer& value(const char *v) { return value(string_view{v, std::strlen(v)}); }
+    writer& value(const std::string &v) { return value(string_view{v.data(), v.size()}); }
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, writer&>::type
+    value(T v) {
+        separator();
+        char buf[24];
+        char *end = buf + sizeof(buf);
+        char *p = details::format_int(end, v);
+        put(p, static_cast<std::size_t>(end - p));
+
+        return *this;
+    }
+    // the NaN and the infinities are written as null
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, writer&>::type
+    value(T v) {
+        if ( v != v || v == std::numeric_limits<T>::infinity() || v == -std::numeric_limits<T>::infinity() ) {
+            return value(nullptr);
+        }
+        separator();
+        char buf[32];
+        put(buf, details::format_float(buf, v));
 
-template<std::size_t N>
-inline parser make_parser(
-     token *toksbeg
-    ,token *toksend
-    ,const char (&str)[N])
-{
-    return make_parser(toksbeg, toksend, str, &str[N]);
-}
+        return *this;
+    }
 
-inline parser init_parser(
-     alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    parser p;
-    details::init_parser(
-         &p
-        ,nullptr
-        ,nullptr
-        ,nullptr
-        ,nullptr
-        ,alloc_fn
-        ,free_fn
-        ,false
-        ,false
-    );
+    template<typename T>
+    writer& member(string_view k, const T &v) { key(k); return value(v); }
+    template<typename T>
+    writer& member(const char *k, const T &v) { key(k); return value(v); }
+
+    // the value from the parsed document, without the copying for the large ones
+    writer& raw(const iterator &it) { return raw_json(it.raw()); }
+    // the already serialized JSON
+    writer& raw_json(string_view json) {
+        separator();
+        if ( json.size() < m_cap / 4 ) {
+            put(json.data(), json.size());
+        } else {
+            if ( m_len ) {
+                m_sink.write(m_buf, m_len);
+            }
+            m_sink.write(json.data(), json.size());
+            m_sink.flush();
+            m_len = 0;
+            m_total += json.size();
+        }
 
-    return p;
-}
+        return *this;
+    }
 
-/*************************************************************************************************/
-// dyn-alloc routines
+    void flush() {
+        if ( m_len ) {
+            m_sink.write(m_buf, m_len);
+            m_len = 0;
+        }
+        m_sink.flush();
+    }
+    int error() const { return m_sink.error(); }
+    // the number of bytes written
+    std::size_t size() const { return m_total; }
+    std::size_t depth() const { return m_depth; }
+
+    // for details::write_escaped()
+    void put(const char *ptr, std::size_t len) {
+        if ( !len ) {
+            return;
+        }
+        m_total += len;
+        if ( m_cap - m_len < len ) {
+            flush();
+            if ( len >= m_cap ) {
+                m_sink.write(ptr, len);
+                m_sink.flush();
+
+                return;
+            }
+        }
+        std::memcpy(m_buf + m_len, ptr, len);
+        m_len += len;
+    }
 
-inline parser* alloc_parser(
-     token *toksbeg
-    ,token *toksend
-    ,const char *strbeg
-    ,const char *strend
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    auto *p = static_cast<parser *>(alloc_fn(sizeof(parser)));
-    if ( p ) {
-        details::init_parser(
-             p
-            ,toksbeg
-            ,toksend
-            ,strbeg
-            ,strend
-            ,alloc_fn
-            ,free_fn
-            ,true
-            ,false
-        );
+private:
+    void separator() {
+        if ( !m_first && !m_after_key && m_depth ) {
+            put(",", 1);
+        }
+        m_first = false;
+        m_after_key = false;
     }
+    writer& open() {
+        ++m_depth;
+        m_first = true;
 
-    return p;
-}
+        return *this;
+    }
+    writer& close(const char *str) {
+        assert(m_depth && !m_after_key);
+        --m_depth;
+        m_first = false;
+        put(str, 1);
 
-template<std::size_t N>
-inline parser* alloc_parser(
-     token *toksbeg
-    ,token *toksend
-    ,const char (&str)[N]
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    return alloc_parser(toksbeg, toksend, str, &str[N], alloc_fn, free_fn);
-}
+        return *this;
+    }
 
-inline std::size_t num_tokens(error_code *ecptr, const char *beg, const char *end) {
-    static token fake;
-    auto p = make_parser(&fake, &fake, beg, end);
+    arena m_own_arena;
+    Sink &m_sink;
+    char *m_buf;
+    std::size_t m_cap;
+    std::size_t m_len = 0;
+    std::size_t m_total = 0;
+    std::size_t m_depth = 0;
+    bool m_first = true;
+    bool m_after_key = false;
+};
 
-    std::size_t vlen;
-    token_type type;
-    error_code ec = details::parse_value<false>(
-         &p
-        ,&(p.toks_beg->val)
-        ,&vlen
-        ,&type
-        ,nullptr
-    );
-    (void)type;
+/*************************************************************************************************/
+// canonical JSON
 
-    if ( !ec && p.str_cur+1 != p.str_end ) {
-        p.str_cur = details::fj_skip_ws(p.str_cur);
-        if ( p.str_cur != p.str_end ) {
-            if ( ecptr ) { *ecptr = FJ_EC_INVALID; }
+namespace details {
 
-            return 0;
+// the number which is out of the double range, in the form of format_float(): the significant digits
+// without the leading and the trailing zeros, one of them before the point, the signed exponent.
+inline void normalize_number(const char *ptr, std::size_t len, std::string &res) {
+    const char *p = ptr;
+    const char *end = ptr + len;
+    res.clear();
+    if ( p != end && *p == '-' ) {
+        res.push_back('-');
+        ++p;
+    }
+    const std::size_t beg = res.size();
+    const char *int_beg = p;
+    for ( ; p != end && fj_is_digit_macro(*p); ++p ) {
+        res.push_back(*p);
+    }
+    // the exponent of the first digit
+    auto exp = static_cast<std::int64_t>(p - int_beg) - 1;
+    if ( p != end && *p == '.' ) {
+        for ( ++p; p != end && fj_is_digit_macro(*p); ++p ) {
+            res.push_back(*p);
         }
     }
+    std::size_t first = beg;
+    for ( ; first != res.size() && res[first] == '0'; ++first )
+        ;
+    if ( first == res.size() ) {
+        res.assign(1, '0');
 
-    std::size_t toknum = p.toks_cur - p.toks_beg;
+        return;
+    }
+    exp -= static_cast<std::int64_t>(first - beg);
+    res.erase(beg, first - beg);
+    while ( res.back() == '0' ) {
+        res.pop_back();
+    }
+    if ( res.size() - beg > 1 ) {
+        res.insert(beg + 1, 1, '.');
+    }
 
-    return toknum;
+    bool eneg = false;
+    if ( p != end && (*p == 'e' || *p == 'E') ) {
+        ++p;
+        eneg = p != end && *p == '-';
+        p += static_cast<std::size_t>(p != end && (*p == '-' || *p == '+'));
+        for ( ; end - p > 1 && *p == '0'; ++p )
+            ;
+    }
+    // the exponents of up to 18 digits are added in the 64 bits,
+    // the longer ones are adjusted by the digits
+    const auto elen = static_cast<std::size_t>(end - p);
+    res.push_back('e');
+    if ( elen <= 18 ) {
+        std::int64_t e = 0;
+        for ( ; p != end; ++p ) {
+            e = e * 10 + (*p - '0');
+        }
+        exp += eneg ? -e : e;
+        res.push_back(exp < 0 ? '-' : '+');
+        char buf[24];
+        char *bend = buf + sizeof(buf);
+        char *b = format_uint64(bend, static_cast<std::uint64_t>(exp < 0 ? -exp : exp));
+        res.append(b, bend);
+    } else {
+        // the |exponent| >= 10^18 is greater than the adjustment, so keeps the sign
+        res.push_back(eneg ? '-' : '+');
+        const std::size_t ebeg = res.size();
+        res.append(p, end);
+        std::int64_t carry = eneg ? -exp : exp;
+        for ( std::size_t i = res.size(); i-- > ebeg && carry; ) {
+            const std::int64_t v = (res[i] - '0') + carry;
+            carry = v >= 0 ? v / 10 : -((9 - v) / 10);
+            res[i] = static_cast<char>('0' + (v - carry * 10));
+        }
+        if ( carry ) {
+            char buf[24];
+            char *bend = buf + sizeof(buf);
+            char *b = format_uint64(bend, static_cast<std::uint64_t>(carry));
+            res.insert(res.begin() + static_cast<std::ptrdiff_t>(ebeg), b, bend);
+        }
+        std::size_t nz = ebeg;
+        for ( ; res[nz] == '0'; ++nz )
+            ;
+        res.erase(ebeg, nz - ebeg);
+    }
 }
 
-inline parser make_parser(
-     const char *strbeg
-    ,const char *strend
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    parser p;
-    details::init_parser(
-         &p
-        ,nullptr
-        ,nullptr
-        ,nullptr
-        ,nullptr
-        ,alloc_fn
-        ,free_fn
-        ,false
-        ,true
-    );
+// the keys of the objects are sorted by the bytes of the decoded keys, the members
+// are ordered through the index buffer shared by all the levels, the values are not copied.
+template<typename Writer>
+struct canonical_walker {
+    struct member {
+        string_view key; // decoded
+        const token *tok;
+    };
 
-    if ( strend - strbeg == 1 && *strbeg == '\0' ) {
-        return p;
+    explicit canonical_walker(Writer &w)
+        :out{w}
+    {}
+
+    Writer &out;
+    std::vector<member> index;
+    arena keys; // the decoded keys with the escapes
+    std::string buf;
+
+    void write(const token *t) {
+        switch ( t->type ) {
+            case FJ_TYPE_STRING: {
+                out.value(unescape_to(make_iterator(const_cast<token *>(t)), buf));
+                break;
+            }
+            case FJ_TYPE_NUMBER: {
+                write_number(make_iterator(const_cast<token *>(t)));
+                break;
+            }
+            case FJ_TYPE_BOOL:
+            case FJ_TYPE_NULL: {
+                out.raw_json({t->val, t->vlen});
+                break;
+            }
+            case FJ_TYPE_ARRAY: {
+                out.begin_array();
+                const token *end = end_token(t);
+                for ( const token *it = t + 1; it != end; it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1 ) {
+                    write(it);
+                }
+                out.end_array();
+                break;
+            }
+            case FJ_TYPE_OBJECT: {
+                write_object(t);
+                break;
+            }
+            default: break;
+        }
+    }
+
+private:
+    // one form per value: the integers up to 2^64, as written or as the integral doubles,
+    // are written by the digits, without the sign of zero. the other numbers are written
+    // as ECMAScript does (RFC 8785), see format_float().
+    // the numbers out of the double range are normalized by the text, see normalize_number().
+    void write_number(const iterator &it) {
+        std::int64_t i{};
+        std::uint64_t u{};
+        double d{};
+        if ( it.try_to(i) == FJ_EC_OK ) {
+            out.value(i);
+        } else if ( it.try_to(u) == FJ_EC_OK ) {
+            out.value(u);
+        } else if ( it.try_to(d) != FJ_EC_OK ) {
+            const auto v = it.value();
+            normalize_number(v.data(), v.size(), buf);
+            out.raw_json({buf.data(), buf.size()});
+        } else if ( d == 0.0 ) {
+            out.value(std::int64_t{0});
+        } else if ( d >= -9223372036854775808.0 && d < 0.0
+            && static_cast<double>(static_cast<std::int64_t>(d)) == d )
+        {
+            out.value(static_cast<std::int64_t>(d));
+        } else if ( d > 0.0 && d < 18446744073709551616.0
+            && static_cast<double>(static_cast<std::uint64_t>(d)) == d )
+        {
+            out.value(static_cast<std::uint64_t>(d));
+        } else {
+            char num[32];
+            out.raw_json({num, format_float(num, d)});
+        }
     }
 
-    error_code ec{};
-    auto toknum = num_tokens(&ec, strbeg, strend);
-    if ( ec ) {
-        p.error = ec;
-        return p;
+    void write_object(const token *obj) {
+        // the slice of the index for this object, the nested ones are pushed after it
+        const std::size_t beg = index.size();
+        const token *end = end_token(obj);
+        for ( const token *it = obj + 1; it != end; it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1 ) {
+            string_view key{it->key, it->klen};
+            if ( it->flags & FJ_FLAG_KEY_ESCAPED ) {
+                char *dst = keys.alloc(it->klen ? it->klen : 1u);
+                key = {dst, unescape(it->key, it->klen, dst, it->klen)};
+            }
+            index.push_back({key, it});
+        }
+        std::sort(index.begin() + static_cast<std::ptrdiff_t>(beg), index.end(), [](const member &l, const member &r) {
+            const std::size_t len = l.key.size() < r.key.size() ? l.key.size() : r.key.size();
+            const int res = std::memcmp(l.key.data(), r.key.data(), len);
+            if ( res != 0 ) {
+                return res < 0;
+            }
+
+            // the duplicated keys are kept in the order of the source
+            return l.key.size() != r.key.size() ? l.key.size() < r.key.size() : l.tok < r.tok;
+        });
+
+        out.begin_object();
+        const std::size_t num = index.size() - beg;
+        for ( std::size_t i = 0; i < num; ++i ) {
+            // the index can be reallocated by the nested objects
+            const member m = index[beg + i];
+            out.key(m.key);
+            write(m.tok);
+        }
+        out.end_object();
+        index.resize(beg);
     }
+};
 
-    auto in_bytes = sizeof(token) * toknum;
-    auto *toksbeg = static_cast<token *>(alloc_fn(in_bytes));
-    auto *toksend = toksbeg + toknum;
+} // ns details
 
-    details::init_parser(
-         &p
-        ,toksbeg
-        ,toksend
-        ,strbeg
-        ,strend
-        ,alloc_fn
-        ,free_fn
-        ,false
-        ,true
-    );
+// writes the value in the canonical form, so the equal documents are written by the same bytes:
+// the keys of objects are sorted by the bytes of their UTF-8 representation, the strings
+// are written with the minimal escaping, the numbers are normalized, no whitespaces.
+// the members with the duplicated keys are kept in the order of the source.
+// returns the length of the output, the errors are reported by sink.error().
+template<typename Sink>
+std::size_t canonical_to(Sink &sink, const iterator &it) {
+    writer<Sink> out{sink};
+    if ( it.cur ) {
+        details::canonical_walker<writer<Sink>> w{out};
+        w.write(it.cur);
+    }
+    out.flush();
 
-    return p;
+    return out.size();
 }
 
-template<std::size_t N>
-inline parser make_parser(
-     const char (&str)[N]
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    return make_parser(str, &str[N], alloc_fn, free_fn);
+inline std::string to_canonical(const iterator &it) {
+    std::string res;
+    string_sink sink{res};
+    canonical_to(sink, it);
+
+    return res;
 }
 
-inline parser* alloc_parser(
-     const char *strbeg
-    ,const char *strend
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    auto *p = static_cast<parser *>(alloc_fn(sizeof(parser)));
-    if ( p ) {
-        details::init_parser(
-             p
-            ,nullptr
-            ,nullptr
-            ,nullptr
-            ,nullptr
-            ,alloc_fn
-            ,free_fn
-            ,true
-            ,true
-        );
-    } else {
-        return nullptr;
+/*************************************************************************************************/
+// mutable overlay
+
+namespace details {
+struct patcher;
+} // ns details
+
+// the edits over the parsed document: the tokens and the source are not changed,
+// the edits are merged while the document is serialized, the unchanged values
+// are copied from the source as is.
+// the values are the JSON texts, they are copied into the overlay.
+// overlay ov{iter_begin(parser)};
+// ov.set(iter_at("price", parser), string_view{"10"});
+// ov.erase(iter_at("tmp", parser));
+// ov.insert(iter_begin(parser), string_view{"new"}, string_view{R"({"a":1})"});
+// ov.serialize_to(sink);
+struct overlay {
+    explicit overlay(const iterator &root)
+        :m_root{root}
+    {}
+    overlay(const overlay &) = delete;
+    overlay& operator= (const overlay &) = delete;
+    ~overlay() { free_trees(); }
+
+    const iterator& root() const { return m_root; }
+    std::size_t edits() const { return m_edits.size(); }
+    bool empty() const { return m_edits.empty(); }
+    // drops the edits and starts over the new document
+    void reset(const iterator &root) {
+        m_root = root;
+        m_edits.clear();
+        m_sorted = true;
+        m_seq = 0;
+        free_trees();
+        m_arena.clear();
     }
 
-    if ( strend - strbeg == 1 && *strbeg == '\0' ) {
-        return p;
+    // replaces the value, the key is kept
+    bool set(const iterator &it, string_view json) {
+        if ( !contains(it) ) {
+            return false;
+        }
+
+        return put_edit(it.cur, edit_kind::replace, {static_cast<const char *>(nullptr), std::size_t{0}}, json);
     }
+    bool set(const pointer &ptr, string_view json) { return set(ptr.resolve(m_root), json); }
 
-    error_code ec{};
-    auto toknum = num_tokens(&ec, strbeg, strend);
-    if ( ec ) {
-        p->error = ec;
-        return p;
+    // removes the member of an object or the element of an array
+    bool erase(const iterator &it) {
+        if ( !contains(it) || it.cur == m_root.cur ) {
+            return false;
+        }
+
+        return put_edit(it.cur, edit_kind::erase, {static_cast<const char *>(nullptr), std::size_t{0}}, {});
     }
-    auto in_bytes = sizeof(token) * toknum;
-    auto *toksbeg = static_cast<token *>(alloc_fn(in_bytes));
-    auto *toksend = toksbeg + toknum;
+    bool erase(const pointer &ptr) { return erase(ptr.resolve(m_root)); }
 
-    if ( p ) {
-        details::init_parser(
-             p
-            ,toksbeg
-            ,toksend
-            ,strbeg
-            ,strend
-            ,alloc_fn
-            ,free_fn
-            ,true
-            ,true
+    // sets the member of the object: replaces the existing one or adds to the end.
+    // the `key` is not escaped.
+    bool insert(const iterator &obj, string_view key, string_view json) {
+        if ( !contains(obj) || !obj.is_object() ) {
+            return false;
+        }
+
+        const token *end = details::end_token(obj.cur);
+        iterator beg{obj.cur, obj.cur + 1, const_cast<token *>(end)};
+        iterator last{const_cast<token *>(end), const_cast<token *>(end), const_cast<token *>(end)};
+        auto found = details::iter_find(key.data(), key.size(), beg, last);
+        if ( found.cur && found.cur != end && found.cur->parent == obj.cur ) {
+            // the erased member is added again to the end
+            auto *e = find_edit(found.cur);
+            if ( !e || e->kind != edit_kind::erase ) {
+                return set(found, json);
+            }
+        }
+
+        return put_edit(end, edit_kind::append, key, json);
+    }
+    bool insert(const pointer &ptr, string_view key, string_view json)
+    { return insert(ptr.resolve(m_root), key, json); }
+
+    // adds the element to the end of the array
+    bool append(const iterator &arr, string_view json) {
+        if ( !contains(arr) || !arr.is_array() ) {
+            return false;
+        }
+
+        return put_edit(
+             details::end_token(arr.cur)
+            ,edit_kind::append
+            ,{static_cast<const char *>(nullptr), std::size_t{0}}
+            ,json
         );
     }
+    bool append(const pointer &ptr, string_view json) { return append(ptr.resolve(m_root), json); }
 
-    return p;
-}
+    // adds the element to the array before the `it`, the elements added before
+    // the same one are written in the order of adding
+    bool insert_before(const iterator &it, string_view json) {
+        if ( !contains(it) || it.cur == m_root.cur || it.cur->parent->type != FJ_TYPE_ARRAY ) {
+            return false;
+        }
 
-template<std::size_t N>
-inline parser* alloc_parser(
-     const char (&str)[N]
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    return alloc_parser(str, &str[N], alloc_fn, free_fn);
-}
+        return put_edit(it.cur, edit_kind::before, {static_cast<const char *>(nullptr), std::size_t{0}}, json);
+    }
+    bool insert_before(const pointer &ptr, string_view json) { return insert_before(ptr.resolve(m_root), json); }
+
+    // the unchanged values are written as they are in the source, with the whitespaces
+    template<typename Sink>
+    std::size_t serialize_to(Sink &sink) const {
+        sort_edits();
+        details::span_writer<Sink> out{sink};
+        write_node(out, {m_root.cur, find_edit(m_root.cur)});
+        out.flush();
+        if ( !sink.error() ) {
+            sink.flush();
+        }
 
-inline void free_parser(parser *p) {
-    if ( p->dyn_tokens && p->toks_beg ) {
-        p->free_fn(p->toks_beg);
+        return out.length();
     }
+    std::string to_string() const {
+        std::string res;
+        string_sink sink{res};
+        serialize_to(sink);
 
-    p->toks_beg = nullptr;
-    p->toks_cur = nullptr;
-    p->toks_end = nullptr;
-    p->error = FJ_EC_INVALID;
+        return res;
+    }
 
-    if ( p->dyn_parser ) {
-        p->free_fn(p);
+private:
+    friend struct details::patcher;
+
+    enum class edit_kind: std::uint8_t { replace, erase, append, before };
+    struct edit {
+        const token *at; // the END token for the appends
+        std::size_t seq; // the order of the edits at the same token
+        edit_kind kind;
+        const char *key; // escaped with the quotes and colon, for the appends to the objects
+        std::size_t klen;
+        const char *text;
+        std::size_t tlen;
+        const token *tree; // the parsed text, when the later edits are inside it
+    };
+    // the value in the edited document: the token of the source or of the parsed text
+    // of an edit, and the edit which replaces or adds the value, if any
+    struct node {
+        const token *tok;
+        edit *e;
+    };
+
+    static bool is_value_edit(edit_kind k) { return k == edit_kind::replace || k == edit_kind::erase; }
+    static const token* last_token(const token *t) {
+        return fj_is_simple_type_macro(t->type) ? t : details::end_token(t);
+    }
+    bool contains(const iterator &it) const {
+        return it.cur && m_root.cur && it.cur >= m_root.cur && it.cur <= last_token(m_root.cur)
+            && it.cur->type != FJ_TYPE_OBJECT_END && it.cur->type != FJ_TYPE_ARRAY_END;
     }
-}
 
-/*************************************************************************************************/
-// parsing
+    const char* copy(const char *ptr, std::size_t len) {
+        char *dst = m_arena.alloc(len ? len : 1u);
+        if ( dst && len ) {
+            std::memcpy(dst, ptr, len);
+        }
 
-inline std::size_t parse(parser *p) {
-    if ( !p->toks_beg ) {
-        return 0;
+        return dst;
     }
 
-    std::size_t vlen = 0;
-    token_type type;
-    p->error = details::parse_value<true>(
-         p
-        ,&(p->toks_beg->val)
-        ,&vlen
-        ,&type
-        ,nullptr
-    );
-    p->toks_beg->type = type;
-    assert(vlen <= std::numeric_limits<FJ_VLEN_TYPE>::max());
-    p->toks_beg->vlen = static_cast<FJ_VLEN_TYPE>(vlen);
-    p->toks_beg->end = p->toks_cur;
-    p->toks_end = p->toks_cur;
+    bool put_edit(const token *at, edit_kind kind, string_view key, string_view json) {
+        const char *text = copy(json.data(), json.size());
+        if ( !text ) {
+            return false;
+        }
 
-    return p->toks_cur - p->toks_beg;
-}
+        const char *k = nullptr;
+        std::size_t klen = 0;
+        if ( key.data() ) {
+            struct out_t {
+                std::string str;
+                void put(const char *ptr, std::size_t len) { str.append(ptr, len); }
+            } out;
+            out.put("\"", 1);
+            details::write_escaped(out, key.data(), key.size());
+            out.put("\":", 2);
+            k = copy(out.str.data(), out.str.size());
+            klen = out.str.size();
+            if ( !k ) {
+                return false;
+            }
+        }
 
-// returns the num of tokens
-inline std::size_t parse(token *tokbeg, token *tokend, const char *strbeg, const char *strend) {
-    auto p = make_parser(tokbeg, tokend, strbeg, strend);
+        if ( is_value_edit(kind) || k ) {
+            for ( auto &it: m_edits ) {
+                // the member added earlier is replaced too
+                const bool same = is_value_edit(kind)
+                    ? it.at == at && is_value_edit(it.kind)
+                    : it.at == at && it.kind == kind && it.klen == klen && std::memcmp(it.key, k, klen) == 0
+                ;
+                if ( same ) {
+                    it.kind = kind;
+                    it.text = text;
+                    it.tlen = json.size();
 
-    return parse(&p);
-}
+                    return true;
+                }
+            }
+        }
+        m_edits.push_back({at, m_seq++, kind, k, klen, text, json.size(), nullptr});
+        m_sorted = false;
 
-// returns the dyn-allocated parser
-inline parser* parse(
-     const char *strbeg
-    ,const char *strend
-    ,alloc_fnptr alloc_fn = &malloc
-    ,free_fnptr free_fn = &free)
-{
-    auto *p = alloc_parser(strbeg, strend, alloc_fn, free_fn);
-    parse(p);
+        return true;
+    }
 
-    return p;
-}
+    void sort_edits() const {
+        if ( m_sorted ) {
+            return;
+        }
+        std::sort(m_edits.begin(), m_edits.end(), [](const edit &l, const edit &r) {
+            return l.at != r.at ? l.at < r.at : l.seq < r.seq;
+        });
+        m_sorted = true;
+    }
 
-/*************************************************************************************************/
-// parser state
+    // the first edit at or after the `t`
+    std::vector<edit>::iterator lower(const token *t) const {
+        return std::lower_bound(m_edits.begin(), m_edits.end(), t, [](const edit &e, const token *p) {
+            return e.at < p;
+        });
+    }
+    edit* find_edit(const token *t) const {
+        if ( !m_sorted ) {
+            for ( auto &it: m_edits ) {
+                if ( it.at == t && is_value_edit(it.kind) ) {
+                    return &it;
+                }
+            }
 
-inline bool is_valid(const parser *p) {
-    return p && p->error == FJ_EC_OK;
-}
+            return nullptr;
+        }
 
-inline error_code get_error(const parser *p) {
-    return p->error;
-}
+        for ( auto it = lower(t); it != m_edits.end() && it->at == t; ++it ) {
+            if ( is_value_edit(it->kind) ) {
+                return &*it;
+            }
+        }
 
-inline const char* get_error_message(const parser *p) {
-    return error_string(p->error);
-}
+        return nullptr;
+    }
+    bool has_edits(const token *beg, const token *last) const {
+        auto it = lower(beg);
 
-inline std::size_t num_tokens(const parser *p) {
-    return p->toks_end - p->toks_beg;
-}
+        return it != m_edits.end() && it->at <= last;
+    }
 
-inline std::size_t num_childs(const parser *p) {
-    return (!fj_is_simple_type_macro(p->toks_beg->type))
-       ? p->toks_beg->childs - 1
-       : static_cast<std::size_t>(p->toks_beg->type != FJ_TYPE_INVALID)
-    ;
-}
+    template<typename Out>
+    void write_container(Out &out, const token *c) const {
+        const bool is_object = c->type == FJ_TYPE_OBJECT;
+        out.write(is_object ? "{" : "[", 1);
+
+        bool first = true;
+        const token *end = details::end_token(c);
+        for ( const token *t = c + 1; t != end; t = fj_is_simple_type_macro(t->type) ? t + 1 : t->end + 1 ) {
+            for ( auto it = lower(t); it != m_edits.end() && it->at == t; ++it ) {
+                if ( it->kind == edit_kind::before ) {
+                    if ( !first ) {
+                        out.write(",", 1);
+                    }
+                    first = false;
+                    write_edit(out, *it);
+                }
+            }
+            auto *e = find_edit(t);
+            if ( e && e->kind == edit_kind::erase ) {
+                continue;
+            }
+            if ( !first ) {
+                out.write(",", 1);
+            }
+            first = false;
+            if ( is_object ) {
+                out.write(t->key - 1, t->klen + 2u);
+                out.write(":", 1);
+            }
+            write_node(out, {t, e});
+        }
 
-inline bool is_empty(const parser *p) {
-    return p == nullptr || p->toks_beg == p->toks_end;
-}
+        for ( auto it = lower(end); it != m_edits.end() && it->at == end; ++it ) {
+            if ( !first ) {
+                out.write(",", 1);
+            }
+            first = false;
+            if ( is_object ) {
+                out.write(it->key, it->klen);
+            }
+            write_edit(out, *it);
+        }
 
-inline bool is_array(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_ARRAY; }
+        out.write(is_object ? "}" : "]", 1);
+    }
+    // the text of the edit, or its tree with the later edits inside
+    template<typename Out>
+    void write_edit(Out &out, const edit &e) const {
+        if ( e.tree && !fj_is_simple_type_macro(e.tree->type) && has_edits(e.tree, last_token(e.tree)) ) {
+            write_container(out, e.tree);
+        } else {
+            out.write(e.text, e.tlen);
+        }
+    }
+    template<typename Out>
+    void write_node(Out &out, const node &n) const {
+        if ( n.e ) {
+            write_edit(out, *n.e);
+        } else if ( fj_is_simple_type_macro(n.tok->type) || !has_edits(n.tok, last_token(n.tok)) ) {
+            const auto raw = details::make_iterator(const_cast<token *>(n.tok)).raw();
+            out.write(raw.data(), raw.size());
+        } else {
+            write_container(out, n.tok);
+        }
+    }
 
-inline bool is_object(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_OBJECT; }
+    /*********************************************************************************************/
+    // the edited document: the values are looked up through the edits, the array indexes
+    // are mapped through the inserted and the erased elements. the values added or replaced
+    // by the edits are parsed when the lookup goes inside them.
 
-inline bool is_null(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_NULL; }
+    // the tokens of the value, nullptr if the text is not valid
+    const token* tokens_of(const node &n) {
+        if ( !n.e ) {
+            return n.tok;
+        }
+        if ( !n.e->tree ) {
+            parser *p = alloc_parser(n.e->text, n.e->text + n.e->tlen);
+            if ( !p ) {
+                return nullptr;
+            }
+            m_trees.push_back(p);
+            parse(p);
+            if ( !is_valid(p) ) {
+                return nullptr;
+            }
+            n.e->tree = iter_begin(p).cur;
+        }
 
-inline bool is_bool(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_BOOL; }
+        return n.e->tree;
+    }
 
-inline bool is_number(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_NUMBER; }
+    // the member of the object by the decoded key: the one of the source, if it's not erased,
+    // or the one added to the end
+    bool find_member(const token *obj, string_view key, node &out) const {
+        token *end = details::end_token(obj);
+        const auto found = details::iter_find(
+             key.data()
+            ,key.size()
+            ,iterator{const_cast<token *>(obj), const_cast<token *>(obj) + 1, end}
+            ,iterator{end, end, end}
+        );
+        if ( found.cur && found.cur != end && found.cur->parent == obj ) {
+            auto *e = find_edit(found.cur);
+            if ( !e || e->kind == edit_kind::replace ) {
+                out = {found.cur, e};
+
+                return true;
+            }
+        }
+        for ( auto it = lower(end); it != m_edits.end() && it->at == end; ++it ) {
+            const char *k = it->key + 1;
+            const std::size_t klen = it->klen - 3; // without the quotes and colon
+            if ( (klen == key.size() && std::memcmp(k, key.data(), klen) == 0)
+                || details::unescaped_equal(k, klen, key.data(), key.size()) )
+            {
+                out = {end, &*it};
+
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // the element of the array by the index in the edited one,
+    // `size` is the number of the elements in the edited one
+    bool find_element(const token *arr, std::size_t idx, node &out, std::size_t &size) const {
+        token *end = details::end_token(arr);
+        if ( !has_edits(arr + 1, end) ) {
+            size = details::make_iterator(const_cast<token *>(arr)).members();
+            if ( idx >= size ) {
+                return false;
+            }
+            out = {details::iter_find(idx, iterator{const_cast<token *>(arr), const_cast<token *>(arr) + 1, end}
+                ,iterator{end, end, end}).cur, nullptr};
 
-inline bool is_string(const parser *p)
-{ return p->toks_beg->type == FJ_TYPE_STRING; }
+            return true;
+        }
 
-inline bool is_simple_type(const parser *p)
-{ return fj_is_simple_type_macro(p->toks_beg->type); }
+        size = 0;
+        bool found = false;
+        const auto take = [&](const token *t, edit *e) {
+            if ( size++ == idx ) {
+                out = {t, e};
+                found = true;
+            }
+        };
+        for ( const token *t = arr + 1; t != end; t = fj_is_simple_type_macro(t->type) ? t + 1 : t->end + 1 ) {
+            edit *value = nullptr;
+            for ( auto it = lower(t); it != m_edits.end() && it->at == t; ++it ) {
+                if ( it->kind == edit_kind::before ) {
+                    take(t, &*it);
+                } else {
+                    value = &*it;
+                }
+            }
+            if ( !value || value->kind == edit_kind::replace ) {
+                take(t, value);
+            }
+        }
+        for ( auto it = lower(end); it != m_edits.end() && it->at == end; ++it ) {
+            take(end, &*it);
+        }
 
-/*************************************************************************************************/
-// iterators
+        return found;
+    }
 
-struct iterator {
-    token *beg;
-    token *cur;
-    token *end;
+    // the value by the first `num` segments of the pointer in the edited document
+    bool resolve(const pointer &ptr, std::size_t num, node &out) {
+        sort_edits();
+        node cur{m_root.cur, find_edit(m_root.cur)};
+        for ( std::size_t i = 0; i < num; ++i ) {
+            const token *c = tokens_of(cur);
+            if ( !c ) {
+                return false;
+            }
+            std::size_t size = 0;
+            const bool found = c->type == FJ_TYPE_OBJECT
+                ? find_member(c, ptr.segment(i), cur)
+                : c->type == FJ_TYPE_ARRAY && ptr.index(i) != pointer::npos
+                    && find_element(c, ptr.index(i), cur, size)
+            ;
+            if ( !found ) {
+                return false;
+            }
+        }
+        out = cur;
 
-    string_view key() const { return {cur->key, cur->klen}; }
-    string_view value() const { return {cur->val, cur->vlen}; }
-    std::size_t childs() const { return cur->childs; }
-    const token* parent() const { return cur->parent; }
-//    const token* end() const { return cur->end; }
+        return true;
+    }
 
-    token_type type() const { return cur->type; }
-    const char* type_name() const { return flatjson::type_name(type()); }
-    bool is_valid() const { return cur && type() != FJ_TYPE_INVALID; }
-    bool is_array() const { return type() == FJ_TYPE_ARRAY; }
-    bool is_object() const { return type() == FJ_TYPE_OBJECT; }
-    bool is_null() const { return type() == FJ_TYPE_NULL; }
-    bool is_bool() const { return type() == FJ_TYPE_BOOL; }
-    bool is_number() const { return type() == FJ_TYPE_NUMBER; }
-    bool is_string() const { return type() == FJ_TYPE_STRING; }
-    bool is_simple_type() const { return fj_is_simple_type_macro(type()); }
+    // the edits of the values which are not in the source: the added ones are changed
+    // in place, erased by dropping the edit, the insertions before them are ordered by the `seq`
+    bool set_node(const node &n, string_view json) {
+        if ( !n.e ) {
+            return put_edit(n.tok, edit_kind::replace, {static_cast<const char *>(nullptr), std::size_t{0}}, json);
+        }
+        const char *text = copy(json.data(), json.size());
+        if ( !text ) {
+            return false;
+        }
+        n.e->text = text;
+        n.e->tlen = json.size();
+        n.e->tree = nullptr;
 
-    string_view to_string_view() const { return value(); }
-    std::string to_string() const { auto s = to_string_view(); return {s.data(), s.size()}; }
+        return true;
+    }
+    bool erase_node(const node &n) {
+        if ( !n.e || n.e->kind == edit_kind::replace ) {
+            return put_edit(n.tok, edit_kind::erase, {static_cast<const char *>(nullptr), std::size_t{0}}, {});
+        }
+        m_edits.erase(m_edits.begin() + (n.e - m_edits.data()));
 
-    template<typename T>
-    T to() const { auto s = to_string_view(); return details::conv_to(s.data(), s.size(), T{}); }
-    bool to_bool() const { return to<bool>(); }
-    std::uint32_t to_uint() const { return to<std::uint32_t>(); }
-    std::int32_t to_int() const { return to<std::int32_t>(); }
-    std::uint64_t to_uint64() const { return to<std::uint64_t>(); }
-    std::int64_t to_int64() const { return to<std::int64_t>(); }
-    double to_double() const { return to<double>(); }
-    float to_float() const { return to<float>(); }
+        return true;
+    }
+    bool insert_before_node(const node &n, string_view json) {
+        if ( !n.e || n.e->kind == edit_kind::replace ) {
+            return put_edit(n.tok, edit_kind::before, {static_cast<const char *>(nullptr), std::size_t{0}}, json);
+        }
+        const char *text = copy(json.data(), json.size());
+        if ( !text ) {
+            return false;
+        }
+        const edit e = *n.e;
+        for ( auto &it: m_edits ) {
+            if ( it.at == e.at && it.seq >= e.seq ) {
+                ++it.seq;
+            }
+        }
+        ++m_seq;
+        m_edits.push_back({e.at, e.seq, e.kind, nullptr, 0, text, json.size(), nullptr});
+        m_sorted = false;
 
-    std::size_t members() const {
-        return (!is_simple_type())
-           ? childs() - 1
-           : static_cast<std::size_t>(type() != FJ_TYPE_INVALID)
-        ;
+        return true;
     }
-};
 
-namespace details {
+    void free_trees() {
+        for ( auto *p: m_trees ) {
+            free_parser(p);
+        }
+        m_trees.clear();
+    }
 
-// dump using iterator
-inline void dump_tokens(std::FILE *stream, const char *caption, const iterator &it, std::size_t indent = 3) {
-    std::fprintf(stream, "%s:\n", caption);
-    dump_tokens_impl(stream, it.beg, it.cur, it.end, indent);
-}
+    iterator m_root;
+    mutable std::vector<edit> m_edits;
+    mutable bool m_sorted = true;
+    std::size_t m_seq = 0;
+    std::vector<parser *> m_trees; // the parsed texts of the edits
+    arena m_arena;
+};
 
-} // ns details
+/*************************************************************************************************/
+// JSON Patch (RFC 6902) and JSON Merge Patch (RFC 7386)
 
-inline iterator iter_begin(const parser *p) {
-    assert(p && p->toks_beg);
-    return {p->toks_beg, p->toks_beg, p->toks_end-1};
-}
+namespace details {
 
-inline iterator iter_end(const parser *p) {
-    assert(p && p->toks_beg);
-    return {p->toks_end-1, p->toks_end-1, p->toks_end-1};
-}
+inline const token* next_member(const token *t)
+{ return fj_is_simple_type_macro(t->type) ? t + 1 : t->end + 1; }
 
-inline iterator iter_begin(const iterator &it) {
-    if ( !it.is_simple_type() ) {
-        return {it.cur, it.cur, it.cur->end};
+inline string_view raw_of(const token *t)
+{ return make_iterator(const_cast<token *>(t)).raw(); }
+
+// the keys are compared decoded
+inline bool same_key(const token *l, const token *r) {
+    if ( !((l->flags | r->flags) & FJ_FLAG_KEY_ESCAPED) ) {
+        return l->khash == r->khash && l->klen == r->klen && std::memcmp(l->key, r->key, l->klen) == 0;
     }
 
-    return {it.cur, it.cur, it.cur->parent->end};
+    char lbuf[256], rbuf[256];
+    std::string lheap, rheap;
+
+    return unescape_key(l->key, l->klen, lbuf, lheap) == unescape_key(r->key, r->klen, rbuf, rheap);
 }
 
-inline iterator iter_end(const iterator &it) {
-    if ( !it.is_simple_type() ) {
-        return {it.cur->end, it.cur->end, it.cur->end};
+// the numbers are compared by the values, the strings decoded,
+// the members of the objects in any order.
+inline bool json_equal(const token *l, const token *r) {
+    if ( l->type != r->type ) {
+        return false;
     }
 
-    return {it.end, it.end, it.end};
-}
+    switch ( l->type ) {
+        case FJ_TYPE_STRING: {
+            if ( !((l->flags | r->flags) & FJ_FLAG_VALUE_ESCAPED) ) {
+                return string_view{l->val, l->vlen} == string_view{r->val, r->vlen};
+            }
+            std::string lstr, rstr;
 
-inline bool iter_equal(const iterator &l, const iterator &r)
-{ return l.cur == r.cur; }
+            return unescape_to(make_iterator(const_cast<token *>(l)), lstr)
+                == unescape_to(make_iterator(const_cast<token *>(r)), rstr);
+        }
+        case FJ_TYPE_NUMBER: {
+            if ( string_view{l->val, l->vlen} == string_view{r->val, r->vlen} ) {
+                return true;
+            }
+            const auto lit = make_iterator(const_cast<token *>(l));
+            const auto rit = make_iterator(const_cast<token *>(r));
+            std::int64_t li{}, ri{};
+            if ( lit.try_to(li) == FJ_EC_OK && rit.try_to(ri) == FJ_EC_OK ) {
+                return li == ri;
+            }
+            double ld{}, rd{};
 
-inline bool iter_not_equal(const iterator &l, const iterator &r)
-{ return !iter_equal(l, r); }
+            return lit.try_to(ld) == FJ_EC_OK && rit.try_to(rd) == FJ_EC_OK && ld == rd;
+        }
+        case FJ_TYPE_BOOL:
+        case FJ_TYPE_NULL: {
+            return string_view{l->val, l->vlen} == string_view{r->val, r->vlen};
+        }
+        case FJ_TYPE_ARRAY: {
+            if ( l->childs != r->childs ) {
+                return false;
+            }
+            const token *lend = end_token(l);
+            for ( const token *lt = l + 1, *rt = r + 1; lt != lend; lt = next_member(lt), rt = next_member(rt) ) {
+                if ( !json_equal(lt, rt) ) {
+                    return false;
+                }
+            }
 
-inline std::size_t iter_members(const iterator &it) {
-    if ( it.is_simple_type() ) {
-        return 0;
-    }
+            return true;
+        }
+        case FJ_TYPE_OBJECT: {
+            if ( l->childs != r->childs ) {
+                return false;
+            }
+            const token *lend = end_token(l);
+            const token *rend = end_token(r);
+            for ( const token *lt = l + 1; lt != lend; lt = next_member(lt) ) {
+                const token *rt = r + 1;
+                for ( ; rt != rend && !same_key(lt, rt); rt = next_member(rt) )
+                    ;
+                if ( rt == rend || !json_equal(lt, rt) ) {
+                    return false;
+                }
+            }
 
-    return it.cur->childs - 1;
+            return true;
+        }
+        default: return false;
+    }
 }
 
-inline iterator iter_next(const iterator &it) {
-    assert(it.cur != it.end);
+// writes the `patch` merged into the `target`, the `target` is nullptr when absent.
+// the runs of the unchanged members of the target are written by a single fragment
+// of the source, with the commas and the whitespaces.
+template<typename Out>
+void write_merged(Out &out, const token *target, const token *patch) {
+    if ( patch->type != FJ_TYPE_OBJECT ) {
+        const auto raw = raw_of(patch);
+        out.write(raw.data(), raw.size());
 
-    auto next = it.cur + 1;
-    if ( next != it.end && next->parent == it.beg ) {
-        return {it.beg, next, it.end};
+        return;
     }
 
-    for ( ; next != it.end && next->parent != it.beg; ++next )
-        ;
+    bool first = true;
+    const auto write_key = [&out, &first](const token *t) {
+        if ( !first ) {
+            out.write(",", 1);
+        }
+        first = false;
+        out.write(t->key - 1, t->klen + 2u);
+        out.write(":", 1);
+    };
 
-    return {it.beg, next, it.end};
-}
+    out.write("{", 1);
+    const token *pend = end_token(patch);
+    // the members of the patch which are found in the target
+    std::vector<bool> found;
+    if ( target && target->type == FJ_TYPE_OBJECT ) {
+        found.resize(patch->childs);
+        const char *run = nullptr;
+        const char *run_end = nullptr;
+        const auto flush_run = [&out, &run, &run_end]() {
+            if ( run ) {
+                out.write(run, static_cast<std::size_t>(run_end - run));
+                run = nullptr;
+            }
+        };
 
-inline std::size_t iter_distance(const iterator &from, const iterator &to) {
-    assert(from.cur->parent == to.cur->parent);
+        const token *tend = end_token(target);
+        for ( const token *t = target + 1; t != tend; t = next_member(t) ) {
+            std::size_t idx = 0;
+            const token *p = patch + 1;
+            for ( ; p != pend && !same_key(t, p); p = next_member(p), ++idx )
+                ;
+            if ( p == pend ) {
+                const auto raw = raw_of(t);
+                if ( !run ) {
+                    if ( !first ) {
+                        out.write(",", 1);
+                    }
+                    first = false;
+                    run = t->key - 1;
+                }
+                run_end = raw.data() + raw.size();
 
-    if ( from.cur->parent->flags == 1 ) {
-        return to.cur - from.cur;
-    }
+                continue;
+            }
 
-    std::size_t cnt{};
-    iterator it{from};
-    for ( ; iter_not_equal(it, to); it = iter_next(it), ++cnt )
-    {}
+            flush_run();
+            found[idx] = true;
+            if ( p->type != FJ_TYPE_NULL ) {
+                write_key(t);
+                write_merged(out, t, p);
+            }
+        }
+        flush_run();
+    }
 
-    return cnt;
+    std::size_t idx = 0;
+    for ( const token *p = patch + 1; p != pend; p = next_member(p), ++idx ) {
+        if ( p->type != FJ_TYPE_NULL && (found.empty() || !found[idx]) ) {
+            write_key(p);
+            write_merged(out, nullptr, p);
+        }
+    }
+    out.write("}", 1);
 }
 
-namespace details {
+// applies the operations one by one to the overlay. the paths are resolved in the
+// document edited by the earlier operations, through the edits of the overlay:
+// the array indexes are shifted by the inserted and the erased elements, the added
+// values are parsed when an operation goes inside them.
+struct patcher {
+    explicit patcher(const iterator &root)
+        :m_ov{root}
+    {}
+    patcher(const patcher &) = delete;
+    patcher& operator= (const patcher &) = delete;
 
-// find by key name
-inline iterator iter_find(const char *key, std::size_t klen, const iterator &beg, const iterator &end) {
-    if ( !beg.cur ) {
-        return end;
-    }
-    if ( beg.cur && beg.cur->parent && beg.cur->parent->type != FJ_TYPE_OBJECT ) {
-        return end;
-    }
+    const overlay& result() const { return m_ov; }
 
-    iterator it{beg};
-    while ( iter_not_equal(it, end) ) {
-        if ( it.type() == FJ_TYPE_OBJECT_END ) {
-            return end;
+    error_code apply(const iterator &op) {
+        if ( !op.is_object() ) {
+            return FJ_EC_INVALID;
         }
-        const auto sv = it.key();
-        if ( sv.size() == klen && sv == string_view{key, klen} ) {
-            break;
+
+        const token *name = nullptr, *path = nullptr, *from = nullptr, *value = nullptr;
+        const token *end = end_token(op.cur);
+        for ( const token *t = op.cur + 1; t != end; t = next_member(t) ) {
+            const auto is_key = [t](const char *key, std::size_t len) {
+                return (t->klen == len && std::memcmp(t->key, key, len) == 0)
+                    || ((t->flags & FJ_FLAG_KEY_ESCAPED) && unescaped_equal(t->key, t->klen, key, len));
+            };
+            if ( is_key("op", 2) ) {
+                name = t;
+            } else if ( is_key("path", 4) ) {
+                path = t;
+            } else if ( is_key("from", 4) ) {
+                from = t;
+            } else if ( is_key("value", 5) ) {
+                value = t;
+            }
+        }
+        if ( !name || !path || name->type != FJ_TYPE_STRING || path->type != FJ_TYPE_STRING ) {
+            return FJ_EC_INVALID;
         }
 
-        it = it.is_simple_type()
-            ? iterator{it.beg, it.cur + 1, it.end}
-            : iterator{it.beg, it.cur->end + 1, it.end}
-        ;
-    }
+        std::string buf;
+        auto str = unescape_to(make_iterator(const_cast<token *>(path)), buf);
+        const std::string pstr{str.data(), str.size()};
+        const pointer ptr{pstr.data(), pstr.size()};
+        if ( !ptr.is_valid() ) {
+            return FJ_EC_INVALID;
+        }
 
-    const auto type = it.type();
-    switch ( type ) {
-        case FJ_TYPE_STRING:
-        case FJ_TYPE_NUMBER:
-        case FJ_TYPE_BOOL:
-        case FJ_TYPE_NULL: {
-            return {it.beg, it.cur, it.cur + 1};
+        const string_view op_name{name->val, name->vlen};
+        if ( op_name == string_view{"add", 3} || op_name == string_view{"replace", 7}
+            || op_name == string_view{"test", 4} )
+        {
+            if ( !value ) {
+                return FJ_EC_INVALID;
+            }
+            const auto text = raw_of(value);
+            if ( op_name == string_view{"add", 3} ) {
+                return add(ptr, text);
+            }
+            overlay::node n{};
+            if ( !m_ov.resolve(ptr, ptr.size(), n) ) {
+                return FJ_EC_NOT_FOUND;
+            }
+            if ( op_name == string_view{"test", 4} ) {
+                return equal(n, value) ? FJ_EC_OK : FJ_EC_TEST_FAILED;
+            }
+
+            return m_ov.set_node(n, text) ? FJ_EC_OK : FJ_EC_INVALID;
         }
-        case FJ_TYPE_OBJECT:
-        case FJ_TYPE_ARRAY: {
-            return {it.cur, it.cur, it.cur->end};
+        if ( op_name == string_view{"remove", 6} ) {
+            return remove(ptr);
         }
-        default: {
-            if ( iter_equal(it, end) && it.type() == FJ_TYPE_OBJECT_END ) {
-                return end;
+        if ( op_name == string_view{"move", 4} || op_name == string_view{"copy", 4} ) {
+            if ( !from || from->type != FJ_TYPE_STRING ) {
+                return FJ_EC_INVALID;
+            }
+            str = unescape_to(make_iterator(const_cast<token *>(from)), buf);
+            const std::string fstr{str.data(), str.size()};
+            const pointer src{fstr.data(), fstr.size()};
+            if ( !src.is_valid() ) {
+                return FJ_EC_INVALID;
+            }
+            overlay::node n{};
+            if ( !m_ov.resolve(src, src.size(), n) ) {
+                return FJ_EC_NOT_FOUND;
+            }
+            // copied, because the value can be erased by the move
+            std::string text;
+            text_of(n, text);
+            if ( op_name == string_view{"move", 4} ) {
+                if ( pstr == fstr ) {
+                    return FJ_EC_OK;
+                }
+                // into itself
+                if ( pstr.size() > fstr.size() && pstr.compare(0, fstr.size(), fstr) == 0
+                    && pstr[fstr.size()] == '/' )
+                {
+                    return FJ_EC_INVALID;
+                }
+                const auto ec = remove(src);
+                if ( ec ) {
+                    return ec;
+                }
             }
-        }
-    }
-
-    assert(!"unreachable!");
 
-    return end;
-}
+            return add(ptr, {text.data(), text.size()});
+        }
 
-} // ns details
+        return FJ_EC_INVALID;
+    }
 
-// at by key name, from the parser
-inline iterator iter_at(const char *key, std::size_t klen, const parser *p) {
-    assert(p && p->toks_beg);
+private:
+    // the value as the edits are applied, without the whitespaces of the edited containers
+    void text_of(const overlay::node &n, std::string &res) const {
+        res.clear();
+        string_sink sink{res};
+        span_writer<string_sink> out{sink};
+        m_ov.write_node(out, n);
+        out.flush();
+    }
 
-    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
-    iterator beg = {
-         p->toks_beg
-        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
-        ,p->toks_end
-    };
-    iterator end = iter_end(p);
+    bool equal(const overlay::node &n, const token *value) {
+        const token *t = m_ov.tokens_of(n);
+        if ( !t ) {
+            return false;
+        }
+        if ( fj_is_simple_type_macro(t->type) || !m_ov.has_edits(t, end_token(t)) ) {
+            return json_equal(t, value);
+        }
 
-    return details::iter_find(key, klen, beg, end);
-}
+        // edited inside: the value is parsed as the edits are applied
+        std::string text;
+        text_of(n, text);
+        parser *p = alloc_parser(text.data(), text.data() + text.size());
+        if ( !p ) {
+            return false;
+        }
+        parse(p);
+        const bool res = is_valid(p) && json_equal(iter_begin(p).cur, value);
+        free_parser(p);
 
-template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
-iterator iter_at(T key, const parser *p) {
-    assert(p && p->toks_beg);
+        return res;
+    }
 
-    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
-    iterator beg = {
-         p->toks_beg
-        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
-        ,p->toks_end
-    };
-    iterator end = iter_end(p);
+    error_code add(const pointer &ptr, string_view text) {
+        if ( !ptr.size() ) {
+            return m_ov.set_node({m_ov.root().cur, m_ov.find_edit(m_ov.root().cur)}, text)
+                ? FJ_EC_OK
+                : FJ_EC_INVALID
+            ;
+        }
 
-    return details::iter_find(key, std::strlen(key), beg, end);
-}
+        const std::size_t last = ptr.size() - 1;
+        overlay::node n{};
+        if ( !m_ov.resolve(ptr, last, n) ) {
+            return FJ_EC_NOT_FOUND;
+        }
+        const token *parent = m_ov.tokens_of(n);
+        if ( !parent ) {
+            return FJ_EC_INVALID;
+        }
 
-template<std::size_t N>
-iterator iter_at(const char (&key)[N], const parser *p) {
-    assert(p && p->toks_beg);
+        const auto key = ptr.segment(last);
+        if ( parent->type == FJ_TYPE_OBJECT ) {
+            overlay::node member{};
+            if ( m_ov.find_member(parent, key, member) ) {
+                return m_ov.set_node(member, text) ? FJ_EC_OK : FJ_EC_INVALID;
+            }
 
-    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
-    iterator beg = {
-         p->toks_beg
-        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
-        ,p->toks_end
-    };
-    iterator end = iter_end(p);
+            return m_ov.put_edit(end_token(parent), overlay::edit_kind::append, key, text)
+                ? FJ_EC_OK
+                : FJ_EC_INVALID
+            ;
+        }
+        if ( parent->type != FJ_TYPE_ARRAY ) {
+            return FJ_EC_NOT_FOUND;
+        }
+        const std::size_t idx = ptr.index(last);
+        overlay::node elem{};
+        std::size_t size = 0;
+        const bool found = idx != pointer::npos && m_ov.find_element(parent, idx, elem, size);
+        if ( key == string_view{"-", 1} || (!found && idx == size) ) {
+            return m_ov.put_edit(end_token(parent), overlay::edit_kind::append
+                ,{static_cast<const char *>(nullptr), std::size_t{0}}, text)
+                ? FJ_EC_OK
+                : FJ_EC_INVALID
+            ;
+        }
+        if ( !found ) {
+            return FJ_EC_INVALID;
+        }
 
-    return details::iter_find(key, N-1, beg, end);
-}
+        return m_ov.insert_before_node(elem, text) ? FJ_EC_OK : FJ_EC_INVALID;
+    }
 
-// at by key name, from the iterators
-inline iterator iter_at(const char *key, std::size_t klen, const iterator &it) {
-    assert(it.cur != it.end);
+    error_code remove(const pointer &ptr) {
+        if ( !ptr.size() ) {
+            return FJ_EC_INVALID;
+        }
+        overlay::node n{};
+        if ( !m_ov.resolve(ptr, ptr.size(), n) ) {
+            return FJ_EC_NOT_FOUND;
+        }
 
-    iterator beg = {
-         it.beg
-        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
-        ,it.end
-    };
-    auto end = iter_end(it);
+        return m_ov.erase_node(n) ? FJ_EC_OK : FJ_EC_INVALID;
+    }
 
-    return details::iter_find(key, klen, beg, end);
-}
+    overlay m_ov;
+};
 
-template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
-iterator iter_at(T key, const iterator &it) {
-    assert(it.cur != it.end);
+} // ns details
 
-    iterator beg = {
-         it.beg
-        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
-        ,it.end
-    };
-    auto end = iter_end(it);
+// writes the `target` merged with the `patch` (RFC 7386) into the sink in a single pass:
+// the members are taken from the source, the objects are merged recursively,
+// the nulls of the patch remove the members. the absent `target` is treated as null.
+// returns the length of the output, the errors are reported by sink.error().
+template<typename Sink>
+std::size_t merge_patch(const iterator &target, const iterator &patch, Sink &sink) {
+    details::span_writer<Sink> out{sink};
+    if ( patch.cur ) {
+        details::write_merged(out, target.cur, patch.cur);
+    }
+    out.flush();
+    if ( !sink.error() ) {
+        sink.flush();
+    }
 
-    return details::iter_find(key, std::strlen(key), beg, end);
+    return out.length();
 }
 
-template<std::size_t N>
-iterator iter_at(const char (&key)[N], const iterator &it) {
-    assert(it.cur != it.end);
+// applies the JSON Patch (RFC 6902) to the `target` and writes the result into the sink.
+// the operations are applied in order, nothing is written if one of them fails:
+// FJ_EC_INVALID for the malformed operation, FJ_EC_NOT_FOUND for the missing path,
+// FJ_EC_TEST_FAILED for the failed "test".
+// the edits are kept aside of the document, see overlay, and the result is written
+// in a single pass over the source.
+template<typename Sink>
+error_code apply_patch(const iterator &target, const iterator &patch, Sink &sink) {
+    if ( !target.cur || !patch.is_array() ) {
+        return FJ_EC_INVALID;
+    }
 
-    iterator beg = {
-         it.beg
-        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
-        ,it.end
-    };
-    auto end = iter_end(it);
+    details::patcher p{target};
+    const token *end = details::end_token(patch.cur);
+    for ( const token *t = patch.cur + 1; t != end; t = details::next_member(t) ) {
+        auto ec = p.apply(details::make_iterator(const_cast<token *>(t)));
+        if ( ec ) {
+            return ec;
+        }
+    }
+    p.result().serialize_to(sink);
 
-    return details::iter_find(key, N-1, beg, end);
+    return FJ_EC_OK;
 }
 
+/*************************************************************************************************/
+
 namespace details {
 
-// find by index
-inline iterator iter_find(std::size_t idx, const iterator &beg, const iterator &end) {
-    if ( !beg.cur ) {
-        return end;
-    }
-    if ( beg.cur && beg.cur->parent->type != FJ_TYPE_ARRAY ) {
-        return end;
-    }
-    if ( idx >= beg.cur->parent->childs ) {
-        return end;
+inline std::size_t walk_through_keys(
+     iterator it
+    ,const iterator &end
+    ,void *userdata
+    ,void(*cb)(void *userdata, const char *ptr, std::size_t len))
+{
+    std::size_t cnt{};
+
+    if ( !it.is_object() ) {
+        return 0;
     }
-    if ( beg.cur->parent->flags == 1 ) {
-        return {beg.beg, beg.cur + idx, beg.end};
-    } else {
-        iterator it{beg};
-        for ( ; iter_not_equal(it, end) && idx; --idx ) {
-            if ( it.type() == FJ_TYPE_ARRAY_END ) {
-                return end;
-            }
 
-            it = it.is_simple_type()
-                ? iterator{it.beg, it.cur + 1, it.end}
-                : iterator{it.beg, it.cur->end + 1, it.end}
-            ;
+    it.cur += 1;
+    for ( ; iter_not_equal(it, end); it = iter_next(it) ) {
+        if ( cb ) {
+            auto key = it.key();
+            cb(userdata, key.data(), key.size());
         }
 
-        const auto type = it.type();
-        switch ( type ) {
-            case FJ_TYPE_STRING:
-            case FJ_TYPE_NUMBER:
-            case FJ_TYPE_BOOL:
-            case FJ_TYPE_NULL: {
-                return {it.beg, it.cur, it.cur + 1};
-            }
-            case FJ_TYPE_OBJECT:
-            case FJ_TYPE_ARRAY: {
-                return {it.cur, it.cur, it.cur->end};
-            }
-            default: {
-                if ( iter_equal(it, end) && it.type() == FJ_TYPE_ARRAY_END ) {
-                    return end;
-                }
-            }
-        }
+        ++cnt;
     }
-    assert(!"unreachable!");
 
-    return end;
+    return cnt;
 }
 
 } // ns details
 
-// at by index, from a parser
-inline iterator iter_at(std::size_t idx, const parser *p) {
-    assert(p && p->toks_beg);
+inline std::vector<string_view> get_keys(const iterator &it, const iterator &end) {
+    auto num = details::walk_through_keys(it, end, nullptr, nullptr);
+    std::vector<string_view> res;
+    res.reserve(num);
 
-    bool is_simple = fj_is_simple_type_macro(p->toks_beg->type);
-    iterator beg = {
-         p->toks_beg
-        ,p->toks_beg + static_cast<std::size_t>(!is_simple)
-        ,p->toks_end
+    static const auto get_fj_keys_cb = [](void *userdata, const char *ptr, std::size_t len) {
+        auto *vec = static_cast<std::vector<string_view> *>(userdata);
+        vec->push_back(string_view{ptr, len});
     };
-    iterator end = iter_end(p);
-
-    return details::iter_find(idx, beg, end);
-}
-
-// at by index, from a iterator
-inline iterator iter_at(std::size_t idx, const iterator &it) {
-    assert(it.cur != it.end);
 
-    iterator beg = {
-         it.beg
-        ,it.cur + static_cast<std::size_t>(!it.is_simple_type())
-        ,it.end
-    };
-    iterator end = iter_end(it);
+    details::walk_through_keys(it, end, &res, get_fj_keys_cb);
 
-    return details::iter_find(idx, beg, end);
+    return res;
 }
 
 /*************************************************************************************************/
+// compile-time schemas
 
 namespace details {
 
-#define __FJ_IO_CALL_CB_WITH_CHECK_1(ptr0, size0) \
-    callback(userdata, ptr0, size0, nullptr, 0, nullptr, 0, nullptr, 0, 1, size0, ec); \
-    if ( *ec ) { return length; }
-
-#define __FJ_IO_CALL_CB_WITH_CHECK_2(ptr0, size0, ptr1, size1) \
-    callback(userdata, ptr0, size0, ptr1, size1, nullptr, 0, nullptr, 0, 2, size0 + size1, ec); \
-    if ( *ec ) { return length; }
-
-#define __FJ_IO_CALL_CB_WITH_CHECK_3(ptr0, size0, ptr1, size1, ptr2, size2) \
-    callback(userdata, ptr0, size0, ptr1, size1, ptr2, size2, nullptr, 0, 3, size0 + size1 + size2, ec); \
-    if ( *ec ) { return length; }
-
-#define __FJ_IO_CALL_CB_WITH_CHECK_4(ptr0, size0, ptr1, size1, ptr2, size2, ptr3, size3) \
-    callback(userdata, ptr0, size0, ptr1, size1, ptr2, size2, ptr3, size3, 4, size0 + size1 + size2 + size3, ec); \
-    if ( *ec ) { return length; }
-
-template<
-     bool CalcLength
-    ,bool WithIndentation
->
-std::size_t walk_through_tokens(
-     const token *toksbeg
-    ,const token *toksend
-    ,std::size_t indent
-    ,void *userdata
-    ,void(*callback)(
-         void *userdata
-        ,const void *ptr0
-        ,std::size_t size0
-        ,const void *ptr1
-        ,std::size_t size1
-        ,const void *ptr2
-        ,std::size_t size2
-        ,const void *ptr3
-        ,std::size_t size3
-        ,std::size_t num
-        ,std::size_t total_bytes
-        ,int *ec
-    )
-    ,int *ec)
-{
-    static const char indent_str[] = "                                                                                ";
-    std::size_t indent_scope = 0;
-    std::size_t length = 0;
-    for ( auto *it = toksbeg; it != toksend + 1; ++it ) {
-        if ( it != toksbeg ) {
-            token_type ctype = it->type;
-            token_type ptype = (it-1)->type;
-            if ( (ctype != FJ_TYPE_ARRAY_END && ctype != FJ_TYPE_OBJECT_END ) &&
-                 (ptype != FJ_TYPE_OBJECT && ptype != FJ_TYPE_ARRAY) )
-            {
-                if ( !CalcLength ) {
-                    if ( WithIndentation ) {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1(",\n", 2);
-                    } else {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1(",", 1);
-                    }
-                }
-                length += 1;
-                if ( WithIndentation ) {
-                    length += 1;
-                }
-            }
-        }
+template<std::size_t... I>
+struct index_seq {};
 
-        switch ( it->type ) {
-            case FJ_TYPE_OBJECT: {
-                if ( it->key ) {
-                    if ( !CalcLength ) {
-                        if ( WithIndentation ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_1(indent_str, indent_scope);
-                        }
-                        __FJ_IO_CALL_CB_WITH_CHECK_3("\"", 1, it->key, it->klen, "\":", 2);
-                    }
-                    if ( WithIndentation ) {
-                        length += indent_scope;
-                    }
-                    length += 1 + it->klen + 2;
-                }
-                if ( !CalcLength ) {
-                    if ( WithIndentation ) {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("{\n", 2);
-                    } else {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("{", 1);
-                    }
-                }
-                length += 1;
-                if ( WithIndentation ) {
-                    length += 1;
-                    indent_scope += indent;
-                }
-                break;
-            }
-            case FJ_TYPE_OBJECT_END: {
-                if ( !CalcLength ) {
-                    if ( WithIndentation ) {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("\n", 1);
-                        __FJ_IO_CALL_CB_WITH_CHECK_1(indent_str, indent_scope - indent);
-                    }
-                    __FJ_IO_CALL_CB_WITH_CHECK_1("}", 1);
-                }
-                length += 1; // for '}'
-                if ( WithIndentation ) {
-                    length += 1; // for '\n'
-                    indent_scope -= indent;
-                    length += indent_scope;
-                }
-                break;
-            }
-            case FJ_TYPE_ARRAY: {
-                if ( it->key ) {
-                    if ( !CalcLength ) {
-                        if ( WithIndentation ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_1(indent_str, indent_scope);
-                        }
-                        __FJ_IO_CALL_CB_WITH_CHECK_3("\"", 1, it->key, it->klen, "\":", 2);
-                    }
-                    length += 1;
-                    length += it->klen;
-                    length += 2;
-                    if ( WithIndentation ) {
-                        length += indent_scope;
-                    }
-                }
-                if ( !CalcLength ) {
-                    if ( WithIndentation ) {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("[\n", 2);
-                    } else {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("[", 1);
-                    }
-                }
-                length += 1;
-                if ( WithIndentation ) {
-                    length += 1;
-                    indent_scope += indent;
-                }
-                break;
-            }
-            case FJ_TYPE_ARRAY_END: {
-                if ( !CalcLength ) {
-                    if ( WithIndentation ) {
-                        __FJ_IO_CALL_CB_WITH_CHECK_3("\n", 1, indent_str, indent_scope - indent, "]", 1);
-                    } else {
-                        __FJ_IO_CALL_CB_WITH_CHECK_1("]", 1);
-                    }
-                }
-                length += 1; // for ']'
-                if ( WithIndentation ) {
-                    length += 1; // for '\n'
-                    indent_scope -= indent;
-                    length += indent_scope;
-                }
-                break;
-            }
-            case FJ_TYPE_NULL:
-            case FJ_TYPE_BOOL:
-            case FJ_TYPE_NUMBER:
-            case FJ_TYPE_STRING: {
-                if ( it->parent->type != FJ_TYPE_ARRAY ) {
-                    if ( !CalcLength ) {
-                        if ( WithIndentation ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_4(indent_str, indent_scope, "\"", 1, it->key, it->klen, "\":", 2);
-                        } else {
-                            __FJ_IO_CALL_CB_WITH_CHECK_3("\"", 1, it->key, it->klen, "\":", 2);
-                        }
-                    }
-                    length += 1 + it->klen + 2;
-                    if ( WithIndentation ) {
-                        length += indent_scope;
-                    }
-                } else if ( it->parent->type == FJ_TYPE_ARRAY ) {
-                    if ( !CalcLength ) {
-                        if ( WithIndentation ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_1(indent_str, indent_scope);
-                        }
-                    }
-                    if ( WithIndentation ) {
-                        length += indent_scope;
-                    }
-                }
-                switch ( it->type ) {
-                    case FJ_TYPE_NULL:
-                    case FJ_TYPE_BOOL:
-                    case FJ_TYPE_NUMBER: {
-                        if ( !CalcLength ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_1(it->val, it->vlen);
-                        }
-                        length += it->vlen;
-                        break;
-                    }
-                    case FJ_TYPE_STRING: {
-                        if ( !CalcLength ) {
-                            __FJ_IO_CALL_CB_WITH_CHECK_3("\"", 1, it->val, it->vlen, "\"", 1);
-                        }
-                        length += 1;
-                        length += it->vlen;
-                        length += 1;
-                        break;
-                    }
-                    default: break;
-                }
+template<typename, typename>
+struct concat_index_seq;
+
+template<std::size_t... I1, std::size_t... I2>
+struct concat_index_seq<index_seq<I1...>, index_seq<I2...>> {
+    using type = index_seq<I1..., (sizeof...(I1) + I2)...>;
+};
+
+template<std::size_t N>
+struct make_index_seq: concat_index_seq<
+     typename make_index_seq<N / 2>::type
+    ,typename make_index_seq<N - N / 2>::type
+> {};
+
+template<>
+struct make_index_seq<0> { using type = index_seq<>; };
+
+template<>
+struct make_index_seq<1> { using type = index_seq<0>; };
+
+// the same as key_hash()
+constexpr std::uint32_t ct_key_hash(const char *key, std::size_t klen, std::uint32_t h = 2166136261u) {
+    return klen == 0
+        ? h
+        : ct_key_hash(key + 1, klen - 1, (h ^ static_cast<std::uint8_t>(*key)) * 16777619u)
+    ;
+}
+
+constexpr bool ct_equal(const char *l, const char *r, std::size_t len) {
+    return len == 0 ? true : *l != *r ? false : ct_equal(l + 1, r + 1, len - 1);
+}
+
+// at least eight slots per key to find a seed quickly
+constexpr std::size_t schema_bits(std::size_t keys, std::size_t bits = 3) {
+    return (static_cast<std::size_t>(1u) << bits) >= keys * 8 ? bits : schema_bits(keys, bits + 1);
+}
+
+constexpr std::uint32_t schema_slot(std::uint32_t h, std::uint32_t seed, std::size_t bits) {
+    return ((h ^ (seed * 0x85ebca6bu)) * 0x9e3779b1u) >> (32 - bits);
+}
 
-                break;
+constexpr bool schema_slot_is_unique(
+     const std::uint32_t *hashes
+    ,std::size_t idx
+    ,std::uint32_t seed
+    ,std::size_t bits
+    ,std::size_t other = 0)
+{
+    return other == idx
+        ? true
+        : schema_slot(hashes[idx], seed, bits) == schema_slot(hashes[other], seed, bits)
+            ? false
+            : schema_slot_is_unique(hashes, idx, seed, bits, other + 1)
+    ;
+}
+
+constexpr bool schema_is_perfect(
+     const std::uint32_t *hashes
+    ,std::size_t keys
+    ,std::uint32_t seed
+    ,std::size_t bits
+    ,std::size_t idx = 0)
+{
+    return idx == keys
+        ? true
+        : !schema_slot_is_unique(hashes, idx, seed, bits)
+            ? false
+            : schema_is_perfect(hashes, keys, seed, bits, idx + 1)
+    ;
+}
+
+// the seeds are tried by blocks of 64 to keep the recursion depth low
+constexpr std::uint32_t schema_seed_in_block(
+     const std::uint32_t *hashes
+    ,std::size_t keys
+    ,std::size_t bits
+    ,std::uint32_t seed
+    ,std::size_t left = 63)
+{
+    return schema_is_perfect(hashes, keys, seed, bits)
+        ? seed
+        : left == 0
+            ? 0xffffffffu
+            : schema_seed_in_block(hashes, keys, bits, seed + 1, left - 1)
+    ;
+}
+
+constexpr std::uint32_t schema_seed_from(
+     const std::uint32_t *hashes
+    ,std::size_t keys
+    ,std::size_t bits
+    ,std::uint32_t block = 0)
+{
+    return block == 256
+        ? 0xffffffffu
+        : schema_seed_in_block(hashes, keys, bits, block * 64) != 0xffffffffu
+            ? schema_seed_in_block(hashes, keys, bits, block * 64)
+            : schema_seed_from(hashes, keys, bits, block + 1)
+    ;
+}
+
+// is not constexpr, so the compilation fails when the keys are duplicated.
+// at runtime the schema is not valid, see schema::is_valid().
+inline std::uint32_t schema_has_duplicated_keys() { return 0xffffffffu; }
+
+constexpr std::uint32_t schema_seed(const std::uint32_t *hashes, std::size_t keys, std::size_t bits) {
+    return schema_seed_from(hashes, keys, bits) != 0xffffffffu
+        ? schema_seed_from(hashes, keys, bits)
+        : schema_has_duplicated_keys()
+    ;
+}
+
+constexpr std::uint8_t schema_slot_owner(
+     const std::uint32_t *hashes
+    ,std::size_t keys
+    ,std::uint32_t seed
+    ,std::size_t bits
+    ,std::size_t slot
+    ,std::size_t idx = 0)
+{
+    return idx == keys
+        ? 0xffu
+        : schema_slot(hashes[idx], seed, bits) == slot
+            ? static_cast<std::uint8_t>(idx)
+            : schema_slot_owner(hashes, keys, seed, bits, slot, idx + 1)
+    ;
+}
+
+constexpr std::size_t schema_index(
+     const char *const *keys
+    ,const std::size_t *lens
+    ,std::size_t num
+    ,const char *key
+    ,std::size_t klen
+    ,std::size_t idx = 0)
+{
+    return idx == num
+        ? num
+        : (lens[idx] == klen && ct_equal(keys[idx], key, klen))
+            ? idx
+            : schema_index(keys, lens, num, key, klen, idx + 1)
+    ;
+}
+
+template<std::size_t N>
+struct schema_keys {
+    const char *keys[N];
+    std::size_t lens[N];
+    std::uint32_t hashes[N];
+};
+
+} // ns details
+
+// the set of keys known at compile time, with the perfect hash over them.
+// constexpr auto s = make_schema("id", "name", "price");
+// iterator fields[s.size()];
+// s.bind(obj, fields);
+// auto price = fields[s.index("price")];
+template<std::size_t N, std::size_t Bits = details::schema_bits(N)>
+struct schema {
+    static_assert(N > 0 && N < 0xff, "the number of keys should be in range [1..254]");
+
+    constexpr explicit schema(const details::schema_keys<N> &k)
+        :schema{
+             k
+            ,details::schema_seed(k.hashes, N, Bits)
+            ,typename details::make_index_seq<N>::type{}
+            ,typename details::make_index_seq<(std::size_t{1} << Bits)>::type{}
+        }
+    {}
+
+    static constexpr std::size_t size() { return N; }
+    // false if the keys are duplicated, then nothing is found.
+    // is always true for the schemas evaluated at compile time, they are not compiled otherwise.
+    constexpr bool is_valid() const { return m_seed != 0xffffffffu; }
+
+    // returns size() for unknown key
+    template<std::size_t L>
+    constexpr std::size_t index(const char (&key)[L]) const
+    { return is_valid() ? details::schema_index(m_keys, m_lens, N, key, L - 1) : N; }
+    std::size_t index(const char *key, std::size_t klen) const {
+        if ( !is_valid() ) {
+            return N;
+        }
+        const auto h = details::key_hash(key, klen);
+        const auto idx = m_slots[details::schema_slot(h, m_seed, Bits)];
+        if ( idx == 0xffu || m_hashes[idx] != h || m_lens[idx] != klen
+            || std::memcmp(m_keys[idx], key, klen) != 0 )
+        {
+            return N;
+        }
+
+        return idx;
+    }
+    // the index of the member's key, the escaped keys are decoded as iter_find() does
+    std::size_t index(const token *member) const {
+        if ( !(member->flags & FJ_FLAG_KEY_ESCAPED) ) {
+            return index(member->key, member->klen);
+        }
+
+        char buf[256];
+        std::string heap;
+        const auto key = details::unescape_key(member->key, member->klen, buf, heap);
+
+        return index(key.data(), key.size());
+    }
+
+    string_view key(std::size_t idx) const { return {m_keys[idx], m_lens[idx]}; }
+
+    // fills the 'out' by the members of the object in a single pass.
+    // the missing keys are left as not valid iterators.
+    // returns the number of found keys.
+    std::size_t bind(const iterator &obj, iterator (&out)[N]) const {
+        for ( auto &it: out ) {
+            it = iterator{};
+        }
+        if ( !obj.cur || !obj.is_object() ) {
+            return 0;
+        }
+
+        std::size_t found = 0;
+        const token *end = details::end_token(obj.cur);
+        for ( auto *it = obj.cur + 1; it != end && found != N; ) {
+            auto *next = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1;
+            const auto idx = index(it);
+            if ( idx != N && !out[idx].cur ) {
+                out[idx] = fj_is_simple_type_macro(it->type)
+                    ? iterator{obj.beg, it, it + 1}
+                    : iterator{it, it, it->end}
+                ;
+                ++found;
             }
-            default: break;
+            it = next;
         }
+
+        return found;
     }
 
-    return length;
-}
+private:
+    template<std::size_t... K, std::size_t... S>
+    constexpr schema(
+         const details::schema_keys<N> &k
+        ,std::uint32_t seed
+        ,details::index_seq<K...>
+        ,details::index_seq<S...>
+    )
+        :m_keys{k.keys[K]...}
+        ,m_lens{k.lens[K]...}
+        ,m_hashes{k.hashes[K]...}
+        ,m_seed{seed}
+        ,m_slots{details::schema_slot_owner(k.hashes, N, seed, Bits, S)...}
+    {}
 
-#undef __FJ_IO_CALL_CB_WITH_CHECK_1
-#undef __FJ_IO_CALL_CB_WITH_CHECK_2
-#undef __FJ_IO_CALL_CB_WITH_CHECK_3
-#undef __FJ_IO_CALL_CB_WITH_CHECK_4
+    const char *m_keys[N];
+    std::size_t m_lens[N];
+    std::uint32_t m_hashes[N];
+    std::uint32_t m_seed;
+    std::uint8_t m_slots[std::size_t{1} << Bits];
+};
 
-} // ns details
+template<std::size_t... L>
+constexpr schema<sizeof...(L)> make_schema(const char (&...keys)[L]) {
+    return schema<sizeof...(L)>{
+        details::schema_keys<sizeof...(L)>{
+             {keys...}
+            ,{(L - 1)...}
+            ,{details::ct_key_hash(keys, L - 1)...}
+        }
+    };
+}
 
 /*************************************************************************************************/
+// struct binding
+
+// the types are bound by the FJ_BIND_STRUCT()/FJ_BIND_ENUM() at namespace scope
+// of the type, the functions are found by ADL through the tag.
+// struct point { int x; int y; std::vector<int> tags; };
+// FJ_BIND_STRUCT(point, x, y, tags)
+// point pt{};
+// auto ec = bind_to(iter_begin(parser), pt);
+template<typename T>
+struct bind_tag {};
+
+// the enums without FJ_BIND_ENUM() are bound by the underlying integer
+template<typename E>
+error_code fj_bind_enum(bind_tag<E>, const iterator &it, E &out) {
+    typename std::underlying_type<E>::type v;
+    const auto ec = it.try_to(v);
+    if ( ec == FJ_EC_OK ) {
+        out = static_cast<E>(v);
+    }
 
-namespace details {
+    return ec;
+}
 
-inline std::size_t walk_through_keys(
-     iterator it
-    ,const iterator &end
-    ,void *userdata
-    ,void(*cb)(void *userdata, const char *ptr, std::size_t len))
-{
-    std::size_t cnt{};
+// the bool and the numbers, the same as try_to()
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, error_code>::type
+bind_to(const iterator &it, T &out) { return it.try_to(out); }
 
-    if ( !it.is_object() ) {
-        return 0;
+// the escapes are decoded
+inline error_code bind_to(const iterator &it, std::string &out) {
+    if ( !it.cur || !it.is_string() ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
+    if ( it.is_value_escaped() ) {
+        unescape_to(it, out);
+    } else {
+        const auto str = it.value();
+        out.assign(str.data(), str.size());
     }
 
-    it.cur += 1;
-    for ( ; iter_not_equal(it, end); it = iter_next(it) ) {
-        if ( cb ) {
-            auto key = it.key();
-            cb(userdata, key.data(), key.size());
-        }
+    return FJ_EC_OK;
+}
 
-        ++cnt;
+template<typename T>
+typename std::enable_if<std::is_enum<T>::value, error_code>::type
+bind_to(const iterator &it, T &out) {
+    if ( !it.cur ) {
+        return FJ_EC_NOT_CONVERTIBLE;
     }
 
-    return cnt;
+    return fj_bind_enum(bind_tag<T>{}, it, out);
 }
 
-} // ns details
+// the structs bound by FJ_BIND_STRUCT()
+template<typename T>
+typename std::enable_if<std::is_class<T>::value, error_code>::type
+bind_to(const iterator &it, T &out) {
+    if ( !it.cur || !it.is_object() ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
 
-inline std::vector<string_view> get_keys(const iterator &it, const iterator &end) {
-    auto num = details::walk_through_keys(it, end, nullptr, nullptr);
-    std::vector<string_view> res;
-    res.reserve(num);
+    return fj_bind_struct(bind_tag<T>{}, it, out);
+}
 
-    static const auto get_fj_keys_cb = [](void *userdata, const char *ptr, std::size_t len) {
-        auto *vec = static_cast<std::vector<string_view> *>(userdata);
-        vec->push_back(string_view{ptr, len});
-    };
+// the `out` is resized to the number of the elements
+template<typename T, typename A>
+error_code bind_to(const iterator &it, std::vector<T, A> &out) {
+    if ( !it.cur || !it.is_array() ) {
+        return FJ_EC_NOT_CONVERTIBLE;
+    }
 
-    details::walk_through_keys(it, end, &res, get_fj_keys_cb);
+    out.resize(it.cur->childs - 1u);
+    std::size_t idx = 0;
+    const token *end = details::end_token(it.cur);
+    for ( auto *t = it.cur + 1; t != end; t = fj_is_simple_type_macro(t->type) ? t + 1 : t->end + 1 ) {
+        const auto ec = bind_to(details::make_iterator(t), out[idx++]);
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+    }
 
-    return res;
+    return FJ_EC_OK;
+}
+
+#if __cplusplus >= 201703L
+// the NULL resets the `out`
+template<typename T>
+error_code bind_to(const iterator &it, std::optional<T> &out) {
+    if ( it.cur && it.is_null() ) {
+        out.reset();
+
+        return FJ_EC_OK;
+    }
+
+    T v{};
+    const auto ec = bind_to(it, v);
+    if ( ec == FJ_EC_OK ) {
+        out = std::move(v);
+    }
+
+    return ec;
+}
+#endif // __cplusplus >= 201703L
+
+namespace details {
+
+// the members are dispatched in a single pass by the perfect hash of the schema.
+// the unknown keys are skipped, the missing members are left unchanged.
+template<typename Schema, typename F>
+error_code bind_members(const iterator &obj, const Schema &s, F f) {
+    const token *end = end_token(obj.cur);
+    for ( auto *it = obj.cur + 1; it != end; it = fj_is_simple_type_macro(it->type) ? it + 1 : it->end + 1 ) {
+        const auto idx = s.index(it);
+        if ( idx == s.size() ) {
+            continue;
+        }
+
+        const auto ec = f(idx, make_iterator(it));
+        if ( ec != FJ_EC_OK ) {
+            return ec;
+        }
+    }
+
+    return FJ_EC_OK;
 }
 
+} // ns details
+
+// up to 32 members
+#define __FJ__BIND_EXPAND(x) x
+#define __FJ__BIND_COMMA() ,
+#define __FJ__BIND_NOSEP()
+#define __FJ__BIND_NARGS(...) __FJ__BIND_EXPAND(__FJ__BIND_NARGS_IMPL(__VA_ARGS__ \
+    ,32,31,30,29,28,27,26,25,24,23,22,21,20,19,18,17,16,15,14,13,12,11,10,9,8,7,6,5,4,3,2,1))
+#define __FJ__BIND_NARGS_IMPL( \
+     _1, _2, _3, _4, _5, _6, _7, _8, _9,_10,_11,_12,_13,_14,_15,_16 \
+    ,_17,_18,_19,_20,_21,_22,_23,_24,_25,_26,_27,_28,_29,_30,_31,_32,N,...) N
+#define __FJ__BIND_CAT(a, b) __FJ__BIND_CAT_IMPL(a, b)
+#define __FJ__BIND_CAT_IMPL(a, b) a##b
+#define __FJ__BIND_FOR_EACH(m, sep, d, ...) \
+    __FJ__BIND_EXPAND(__FJ__BIND_CAT(__FJ__BIND_FE_, __FJ__BIND_NARGS(__VA_ARGS__))(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_1(m, sep, d, x) m(d, x)
+#define __FJ__BIND_FE_2(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_1(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_3(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_2(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_4(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_3(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_5(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_4(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_6(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_5(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_7(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_6(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_8(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_7(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_9(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_8(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_10(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_9(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_11(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_10(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_12(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_11(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_13(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_12(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_14(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_13(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_15(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_14(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_16(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_15(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_17(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_16(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_18(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_17(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_19(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_18(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_20(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_19(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_21(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_20(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_22(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_21(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_23(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_22(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_24(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_23(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_25(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_24(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_26(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_25(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_27(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_26(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_28(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_27(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_29(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_28(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_30(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_29(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_31(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_30(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_FE_32(m, sep, d, x, ...) m(d, x) sep() __FJ__BIND_EXPAND(__FJ__BIND_FE_31(m, sep, d, __VA_ARGS__))
+#define __FJ__BIND_KEY(d, x) #x
+#define __FJ__BIND_MEMBER_CASE(d, x) \
+    case d.index(#x): return ::flatjson::bind_to(it, out.x);
+#define __FJ__BIND_ENUM_CASE(d, x) \
+    case d.index(#x): out = fj_enum_type::x; return ::flatjson::FJ_EC_OK;
+
+// binds the JSON object to the listed members of the struct
+#define FJ_BIND_STRUCT(type, ...) \
+    inline ::flatjson::error_code fj_bind_struct( \
+        ::flatjson::bind_tag<type>, const ::flatjson::iterator &obj, type &out) \
+    { \
+        static constexpr auto fj_schema = ::flatjson::make_schema( \
+            __FJ__BIND_FOR_EACH(__FJ__BIND_KEY, __FJ__BIND_COMMA, ~, __VA_ARGS__)); \
+        return ::flatjson::details::bind_members(obj, fj_schema, \
+            [&out](std::size_t idx, const ::flatjson::iterator &it) -> ::flatjson::error_code { \
+                switch ( idx ) { \
+                    __FJ__BIND_FOR_EACH(__FJ__BIND_MEMBER_CASE, __FJ__BIND_NOSEP, fj_schema, __VA_ARGS__) \
+                } \
+                return ::flatjson::FJ_EC_OK; \
+            }); \
+    }
+
+// binds the JSON string to the listed values of the enum by their names
+#define FJ_BIND_ENUM(type, ...) \
+    inline ::flatjson::error_code fj_bind_enum( \
+        ::flatjson::bind_tag<type>, const ::flatjson::iterator &it, type &out) \
+    { \
+        using fj_enum_type = type; \
+        static constexpr auto fj_schema = ::flatjson::make_schema( \
+            __FJ__BIND_FOR_EACH(__FJ__BIND_KEY, __FJ__BIND_COMMA, ~, __VA_ARGS__)); \
+        if ( !it.is_string() ) { \
+            return ::flatjson::FJ_EC_NOT_CONVERTIBLE; \
+        } \
+        const auto str = it.value(); \
+        switch ( fj_schema.index(str.data(), str.size()) ) { \
+            __FJ__BIND_FOR_EACH(__FJ__BIND_ENUM_CASE, __FJ__BIND_NOSEP, fj_schema, __VA_ARGS__) \
+        } \
+        return ::flatjson::FJ_EC_NOT_CONVERTIBLE; \
+    }
+
 /*************************************************************************************************/
 /*************************************************************************************************/
 /*************************************************************************************************/
@@ -2084,7 +7614,7 @@ inline compare_result compare_impl(
     ,compare_mode cmpmode = compare_mode::markup_only)
 {
     const bool in_array = left_beg.parent()->type == FJ_TYPE_ARRAY;
-    const bool only_simple = left_beg.parent()->flags;
+    const bool only_simple = left_beg.parent()->flags & FJ_FLAG_SIMPLE_CHILDS;
     if ( in_array && only_simple ) {
         using comparator_fnptr = compare_result(*)(const token *l, const token *r);
         static const comparator_fnptr cmparr[3] = {
@@ -2216,6 +7746,342 @@ inline compare_result compare(
     ;
 }
 
+/*************************************************************************************************/
+// structural diff
+
+namespace details {
+
+inline std::uint64_t hash_mix(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+// the hash which is the same for the values equal by json_equal():
+// the strings are decoded, the numbers are hashed by the values, the members of the objects
+// are combined regardless of the order.
+inline std::uint64_t value_hash(const token *t) {
+    std::uint64_t h = hash_mix(t->type);
+    switch ( t->type ) {
+        case FJ_TYPE_STRING: {
+            std::string buf;
+            const auto str = unescape_to(make_iterator(const_cast<token *>(t)), buf);
+
+            return hash_mix(h ^ key_hash(str.data(), str.size()));
+        }
+        case FJ_TYPE_NUMBER: {
+            double v{};
+            if ( make_iterator(const_cast<token *>(t)).try_to(v) != FJ_EC_OK ) {
+                return hash_mix(h ^ key_hash(t->val, t->vlen));
+            }
+            // the -0.0 is equal to 0.0
+            v = v == 0.0 ? 0.0 : v;
+            std::uint64_t bits{};
+            std::memcpy(&bits, &v, sizeof(bits));
+
+            return hash_mix(h ^ bits);
+        }
+        case FJ_TYPE_BOOL:
+        case FJ_TYPE_NULL: {
+            return hash_mix(h ^ key_hash(t->val, t->vlen));
+        }
+        case FJ_TYPE_ARRAY: {
+            const token *end = end_token(t);
+            for ( const token *it = t + 1; it != end; it = next_member(it) ) {
+                h = hash_mix(h * 31u + value_hash(it));
+            }
+
+            return h;
+        }
+        case FJ_TYPE_OBJECT: {
+            char buf[256];
+            std::string heap;
+            std::uint64_t sum = 0;
+            const token *end = end_token(t);
+            for ( const token *it = t + 1; it != end; it = next_member(it) ) {
+                const auto key = unescape_key(it->key, it->klen, buf, heap);
+                sum += hash_mix(key_hash(key.data(), key.size()) ^ (value_hash(it) * 0x9e3779b97f4a7c15ull));
+            }
+
+            return hash_mix(h ^ sum);
+        }
+        default: return h;
+    }
+}
+
+// emits the differences as the JSON Patch operations into the writer.
+// the path is the JSON Pointer of the current values, extended by the segments on the way down.
+template<typename Writer>
+struct differ {
+    Writer &out;
+    std::string path;
+    std::size_t lcs_limit;
+
+    void diff(const token *l, const token *r) {
+        const auto lraw = raw_of(l);
+        const auto rraw = raw_of(r);
+        if ( lraw == rraw ) {
+            return;
+        }
+        if ( l->type != r->type || fj_is_simple_type_macro(l->type) ) {
+            if ( !json_equal(l, r) ) {
+                op("replace", r);
+            }
+
+            return;
+        }
+
+        if ( l->type == FJ_TYPE_OBJECT ) {
+            diff_objects(l, r);
+        } else {
+            diff_arrays(l, r);
+        }
+    }
+
+private:
+    // the key is not escaped, or the array index
+    void push(string_view seg) {
+        path.push_back('/');
+        for ( std::size_t i = 0; i < seg.size(); ++i ) {
+            const char ch = seg.data()[i];
+            if ( ch == '~' ) {
+                path.append("~0", 2);
+            } else if ( ch == '/' ) {
+                path.append("~1", 2);
+            } else {
+                path.push_back(ch);
+            }
+        }
+    }
+    void push(std::size_t idx) {
+        char buf[24];
+        char *end = buf + sizeof(buf);
+        char *p = format_uint64(end, idx);
+        push({p, static_cast<std::size_t>(end - p)});
+    }
+    void push_key(const token *t) {
+        char buf[256];
+        std::string heap;
+        push(unescape_key(t->key, t->klen, buf, heap));
+    }
+
+    // the `value` is nullptr for "remove"
+    void op(const char *name, const token *value) {
+        out.begin_object();
+        out.member("op", name);
+        out.member("path", string_view{path.data(), path.size()});
+        if ( value ) {
+            out.key("value");
+            out.raw(make_iterator(const_cast<token *>(value)));
+        }
+        out.end_object();
+    }
+
+    // the members are matched by the hashes of the decoded keys
+    void diff_objects(const token *l, const token *r) {
+        struct member {
+            std::uint32_t hash;
+            const token *tok;
+            bool used;
+        };
+        std::vector<member> rmembers;
+        rmembers.reserve(r->childs);
+        char buf[256];
+        std::string heap;
+        const token *rend = end_token(r);
+        for ( const token *t = r + 1; t != rend; t = next_member(t) ) {
+            const auto key = unescape_key(t->key, t->klen, buf, heap);
+            rmembers.push_back({key_hash(key.data(), key.size()), t, false});
+        }
+        std::sort(rmembers.begin(), rmembers.end(), [](const member &a, const member &b) {
+            return a.hash < b.hash;
+        });
+
+        const std::size_t len = path.size();
+        const token *lend = end_token(l);
+        for ( const token *t = l + 1; t != lend; t = next_member(t) ) {
+            const auto key = unescape_key(t->key, t->klen, buf, heap);
+            const auto h = key_hash(key.data(), key.size());
+            auto it = std::lower_bound(rmembers.begin(), rmembers.end(), h, [](const member &m, std::uint32_t v) {
+                return m.hash < v;
+            });
+            for ( ; it != rmembers.end() && it->hash == h && (it->used || !same_key(t, it->tok)); ++it )
+                ;
+
+            push(key);
+            if ( it == rmembers.end() || it->hash != h ) {
+                op("remove", nullptr);
+            } else {
+                it->used = true;
+                diff(t, it->tok);
+            }
+            path.resize(len);
+        }
+
+        // the added members in the order of the right side
+        for ( const token *t = r + 1; t != rend; t = next_member(t) ) {
+            const auto key = unescape_key(t->key, t->klen, buf, heap);
+            const auto h = key_hash(key.data(), key.size());
+            auto it = std::lower_bound(rmembers.begin(), rmembers.end(), h, [](const member &m, std::uint32_t v) {
+                return m.hash < v;
+            });
+            for ( ; it->tok != t; ++it )
+                ;
+            if ( !it->used ) {
+                push(key);
+                op("add", t);
+                path.resize(len);
+            }
+        }
+    }
+
+    void diff_arrays(const token *l, const token *r) {
+        std::vector<const token *> lelems, relems;
+        lelems.reserve(l->childs);
+        relems.reserve(r->childs);
+        const token *lend = end_token(l);
+        for ( const token *t = l + 1; t != lend; t = next_member(t) ) {
+            lelems.push_back(t);
+        }
+        const token *rend = end_token(r);
+        for ( const token *t = r + 1; t != rend; t = next_member(t) ) {
+            relems.push_back(t);
+        }
+
+        // the common prefix and suffix
+        std::size_t pre = 0;
+        while ( pre < lelems.size() && pre < relems.size() && raw_of(lelems[pre]) == raw_of(relems[pre]) ) {
+            ++pre;
+        }
+        std::size_t suf = 0;
+        while ( suf < lelems.size() - pre && suf < relems.size() - pre
+            && raw_of(lelems[lelems.size() - 1 - suf]) == raw_of(relems[relems.size() - 1 - suf]) )
+        {
+            ++suf;
+        }
+
+        const std::size_t n = lelems.size() - pre - suf;
+        const std::size_t m = relems.size() - pre - suf;
+        if ( n && m && n <= lcs_limit && m <= lcs_limit ) {
+            diff_lcs(lelems.data() + pre, n, relems.data() + pre, m, pre);
+        } else {
+            diff_positional(lelems.data() + pre, n, relems.data() + pre, m, pre);
+        }
+    }
+
+    // the elements are compared by the positions, the rest is removed from the end or appended
+    void diff_positional(const token **l, std::size_t n, const token **r, std::size_t m, std::size_t idx) {
+        const std::size_t len = path.size();
+        const std::size_t common = n < m ? n : m;
+        for ( std::size_t i = 0; i < common; ++i ) {
+            push(idx + i);
+            diff(l[i], r[i]);
+            path.resize(len);
+        }
+        for ( std::size_t i = n; i > common; --i ) {
+            push(idx + i - 1);
+            op("remove", nullptr);
+            path.resize(len);
+        }
+        for ( std::size_t i = common; i < m; ++i ) {
+            push(idx + i);
+            op("add", r[i]);
+            path.resize(len);
+        }
+    }
+
+    // the longest common subsequence is kept, the runs between the kept elements
+    // are diffed pairwise, then the rest of the run is removed or added.
+    void diff_lcs(const token **l, std::size_t n, const token **r, std::size_t m, std::size_t idx) {
+        std::vector<std::uint64_t> lhash(n), rhash(m);
+        for ( std::size_t i = 0; i < n; ++i ) {
+            lhash[i] = value_hash(l[i]);
+        }
+        for ( std::size_t j = 0; j < m; ++j ) {
+            rhash[j] = value_hash(r[j]);
+        }
+        const auto eq = [&](std::size_t i, std::size_t j) {
+            return lhash[i] == rhash[j] && json_equal(l[i], r[j]);
+        };
+
+        // the lengths of the LCS of the suffixes
+        const std::size_t w = m + 1;
+        std::vector<std::uint32_t> lcs((n + 1) * w);
+        for ( std::size_t i = n; i-- > 0; ) {
+            for ( std::size_t j = m; j-- > 0; ) {
+                lcs[i * w + j] = eq(i, j)
+                    ? lcs[(i + 1) * w + j + 1] + 1
+                    : std::max(lcs[(i + 1) * w + j], lcs[i * w + j + 1])
+                ;
+            }
+        }
+
+        const std::size_t len = path.size();
+        std::size_t i = 0, j = 0;
+        while ( i < n || j < m ) {
+            if ( i < n && j < m && eq(i, j) ) {
+                ++i;
+                ++j;
+                ++idx;
+
+                continue;
+            }
+
+            const std::size_t di = i, dj = j;
+            while ( (i < n || j < m) && !(i < n && j < m && eq(i, j)) ) {
+                if ( j == m || (i < n && lcs[(i + 1) * w + j] >= lcs[i * w + j + 1]) ) {
+                    ++i;
+                } else {
+                    ++j;
+                }
+            }
+
+            const std::size_t removed = i - di, added = j - dj;
+            const std::size_t pairs = removed < added ? removed : added;
+            for ( std::size_t k = 0; k < pairs; ++k, ++idx ) {
+                push(idx);
+                diff(l[di + k], r[dj + k]);
+                path.resize(len);
+            }
+            for ( std::size_t k = pairs; k < removed; ++k ) {
+                push(idx);
+                op("remove", nullptr);
+                path.resize(len);
+            }
+            for ( std::size_t k = pairs; k < added; ++k, ++idx ) {
+                push(idx);
+                op("add", r[dj + k]);
+                path.resize(len);
+            }
+        }
+    }
+};
+
+} // ns details
+
+// writes the differences between `from` and `to` into the sink as the JSON Patch (RFC 6902)
+// which turns `from` into `to`: [{"op":"replace","path":"/a","value":2},...].
+// the members of objects are matched by the hashes of the keys, the changed ones are diffed
+// recursively. the arrays up to `lcs_limit` changed elements are diffed by the longest common
+// subsequence of the elements, the larger ones by the positions.
+// the values are copied from the source of `to`.
+// returns the length of the output, the errors are reported by sink.error().
+template<typename Sink>
+std::size_t diff(const iterator &from, const iterator &to, Sink &sink, std::size_t lcs_limit = FJ_DIFF_LCS_LIMIT) {
+    writer<Sink> out{sink};
+    out.begin_array();
+    if ( from.cur && to.cur ) {
+        details::differ<writer<Sink>> d{out, {}, lcs_limit};
+        d.diff(from.cur, to.cur);
+    }
+    out.end_array();
+    out.flush();
+
+    return out.size();
+}
+
 /*************************************************************************************************/
 /*************************************************************************************************/
 /*************************************************************************************************/
@@ -2502,11 +8368,27 @@ public:
     bool is_number() const { return m_beg.is_number(); }
     bool is_string() const { return m_beg.is_string(); }
     bool is_simple_type() const { return m_beg.is_simple_type(); }
+    std::uint8_t number_kind() const { return m_beg.number_kind(); }
+    bool is_integer() const { return m_beg.is_integer(); }
 
     string_view to_string_view() const { return m_beg.to_string_view(); }
     std::string to_string() const { return m_beg.to_string(); }
+    // the source bytes of the value, see iterator::raw()
+    string_view raw_json() const { return m_beg.raw(); }
+    // see flatjson::canonical_to()
+    std::string to_canonical() const { return flatjson::to_canonical(m_beg); }
     template<typename T>
     T to() const { return m_beg.template to<T>(); }
+    template<typename T>
+    error_code try_to(T &out) const { return m_beg.try_to(out); }
+    // see flatjson::bind_to() and FJ_BIND_STRUCT()
+    template<typename T>
+    error_code bind_to(T &out) const { return flatjson::bind_to(m_beg, out); }
+    // for arrays, see flatjson::extract_array()
+    template<typename T>
+    std::size_t extract_array(T *out, std::size_t n) const { return flatjson::extract_array(m_beg, out, n); }
+    template<typename T>
+    std::size_t extract_array(std::vector<T> &out) const { return flatjson::extract_array(m_beg, out); }
     bool to_bool() const { return m_beg.to_bool(); }
     std::uint32_t to_uint() const { return m_beg.to_uint(); }
     std::int32_t to_int() const { return m_beg.to_int(); }
@@ -2515,12 +8397,20 @@ public:
     double to_double() const { return m_beg.to_double(); }
     float to_float() const { return m_beg.to_float(); }
 
+    // the lookups use the indexes built by build_indexes() and do not change the document,
+    // so the concurrent lookups are safe
+    bool build_indexes(std::size_t threshold = FJ_INDEX_THRESHOLD) const
+    { return flatjson::build_indexes(m_parser.get(), threshold); }
+
     template<std::size_t N>
     bool contains(const char (&key)[N]) const { return contains(key, N-1); }
     template<typename T, typename = typename enable_if_const_char_ptr<T>::type>
     bool contains(T key) const { return contains(key, std::strlen(key)); }
-    bool contains(const char *key, std::size_t len) const
-    { auto it = iter_at(key, len, m_beg); return iter_not_equal(it, m_end); }
+    bool contains(const char *key, std::size_t len) const {
+        auto it = iter_at(key, len, m_beg);
+
+        return iter_not_equal(it, m_end);
+    }
 
     // for objects
     template<std::size_t N>
@@ -2545,6 +8435,16 @@ public:
         return {m_parser, it, iter_end(it)};
     }
 
+    // by JSON Pointer
+    fjson at(const pointer &ptr) const {
+        auto it = ptr.resolve(m_beg);
+        if ( !it.is_valid() ) {
+            return {m_parser, m_end, m_end};
+        }
+
+        return {m_parser, it, iter_end(it)};
+    }
+
     // get a fjson object at iterator position
     fjson at(const const_iterator &it) const
     { return {m_parser, iter_begin(it.m_it), iter_end(it.m_it)}; }
@@ -2683,6 +8583,9 @@ inline fjson pparse(
 #undef FJ_KLEN_TYPE
 #undef FJ_VLEN_TYPE
 #undef FJ_CHILDS_TYPE
+#undef FJ_INDEX_THRESHOLD
+#undef FJ_DIFF_LCS_LIMIT
+#undef FJ_EXTRACT_ARRAY_MT_CHUNK
 #undef __FJ__CUR_CHAR
 
 /*************************************************************************************************/
@@ -26,12 +26,19 @@
 #   include <sys/uio.h>
 #   include <fcntl.h>
 #   include <unistd.h>
+#   include <climits>
+#   include <cerrno>
 #elif defined(WIN32)
 #   include <windows.h>
 #else
 #   error "UNKNOWN PLATFORM!"
 #endif // OS detection
 
+// the number of io_vector's collected by serialize(file_handle, ...) before the write
+#ifndef FJ_IOV_BATCH_SIZE
+#   define FJ_IOV_BATCH_SIZE 1024
+#endif // FJ_IOV_BATCH_SIZE
+
 namespace flatjson {
 
 /*************************************************************************************************/
@@ -76,6 +83,9 @@ inline std::size_t file_write(
     ,std::size_t total_bytes
     ,int *ec = nullptr
 );
+// writes all of the vectors, is continued after the partial writes.
+// the vectors pointed by `iovector` are changed.
+inline bool file_write_all(file_handle fd, io_vector *iovector, std::size_t num, int *ec = nullptr);
 inline bool file_close(file_handle fd, int *ec = nullptr);
 inline const void* mmap_for_read(file_handle fd, std::size_t size, int *ec = nullptr);
 inline const void* mmap_for_read(file_handle *fd, const char_type *fname, int *ec = nullptr);
@@ -190,6 +200,39 @@ std::size_t file_write(
     return wr;
 }
 
+bool file_write_all(file_handle fd, io_vector *iovector, std::size_t num, int *ec) {
+    for ( ; num && !iovector->iov_len; ++iovector, --num )
+        ;
+    while ( num ) {
+        const auto cnt = (std::min)(num, static_cast<std::size_t>(IOV_MAX));
+        auto wr = ::writev(fd, iovector, static_cast<int>(cnt));
+        if ( wr == -1 ) {
+            if ( errno == EINTR ) {
+                continue;
+            }
+            if ( ec ) { *ec = errno; }
+
+            return false;
+        }
+        if ( wr == 0 ) {
+            if ( ec ) { *ec = EIO; }
+
+            return false;
+        }
+
+        auto left = static_cast<std::size_t>(wr);
+        for ( ; num && left >= iovector->iov_len; ++iovector, --num ) {
+            left -= iovector->iov_len;
+        }
+        if ( left ) {
+            iovector->iov_base = static_cast<char *>(iovector->iov_base) + left;
+            iovector->iov_len -= left;
+        }
+    }
+
+    return true;
+}
+
 bool file_close(file_handle fd, int *ec) {
     bool ok = ::close(fd) == 0;
     if ( !ok ) {
@@ -453,6 +496,18 @@ std::size_t file_write(
     return total_bytes;
 }
 
+bool file_write_all(file_handle fd, io_vector *iovector, std::size_t num, int *ec) {
+    int lec{};
+    file_write(fd, iovector, num, 0, &lec);
+    if ( lec ) {
+        if ( ec ) { *ec = lec; }
+
+        return false;
+    }
+
+    return true;
+}
+
 bool file_close(file_handle fd, int *ec) {
     if ( !::CloseHandle(fd) ) {
         int lec = ::GetLastError();
@@ -579,61 +634,79 @@ bool munmap_file_fd(const void *addr, file_handle fd, int *ec) {
 #endif // OS detection
 
 /*************************************************************************************************/
+// sinks for the files, see serialize_to()
 
-inline std::size_t serialize(
-     file_handle fd
-    ,const iterator &beg
-    ,const iterator &end
-    ,std::size_t indent = 0
-    ,int *ec = nullptr)
-{
-    static const auto cb = []
-    (    void *userdata
-        ,const void *ptr0
-        ,std::size_t size0
-        ,const void *ptr1
-        ,std::size_t size1
-        ,const void *ptr2
-        ,std::size_t size2
-        ,const void *ptr3
-        ,std::size_t size3
-        ,std::size_t num
-        ,std::size_t total_bytes
-        ,int *ec)
-    {
-        auto *fd = static_cast<file_handle *>(userdata);
-        const io_vector iovector[4] = {
-             {const_cast<void *>(ptr0), size0}
-            ,{const_cast<void *>(ptr1), size1}
-            ,{const_cast<void *>(ptr2), size2}
-            ,{const_cast<void *>(ptr3), size3}
-        };
-        file_write(*fd, iovector, num, total_bytes, ec);
-    };
+namespace details {
 
-    int lec{};
-    std::size_t wr{};
-    if ( indent ) {
-        wr = details::walk_through_tokens<false, true>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,&fd
-            ,cb
-            ,&lec
-        );
-    } else {
-        wr = details::walk_through_tokens<false, false>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,&fd
-            ,cb
-            ,&lec
-        );
+#if defined(__linux__) || defined(__APPLE__)
+static constexpr std::size_t iov_batch_size =
+    FJ_IOV_BATCH_SIZE < IOV_MAX ? FJ_IOV_BATCH_SIZE : IOV_MAX;
+#else
+static constexpr std::size_t iov_batch_size = FJ_IOV_BATCH_SIZE;
+#endif // OS detection
+
+} // ns details
+
+// the fragments are collected without the copying
+// and written by a single syscall for up to FJ_IOV_BATCH_SIZE of them.
+struct fd_sink {
+    explicit fd_sink(file_handle fd)
+        :m_fd{fd}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( !len || m_ec ) {
+            return;
+        }
+        __FJ_INIT_IO_VECTOR(m_vec[m_num], const_cast<char *>(ptr), len);
+        if ( ++m_num == details::iov_batch_size ) {
+            flush();
+        }
     }
-    if ( lec && ec ) {
-        *ec = lec;
+    void flush() {
+        if ( m_num ) {
+            file_write_all(m_fd, m_vec, m_num, &m_ec);
+            m_num = 0;
+        }
+    }
+    int error() const { return m_ec; }
+
+private:
+    file_handle m_fd;
+    std::size_t m_num = 0;
+    int m_ec = 0;
+    io_vector m_vec[details::iov_batch_size];
+};
+
+struct file_sink {
+    explicit file_sink(std::FILE *stream)
+        :m_stream{stream}
+    {}
+
+    void write(const char *ptr, std::size_t len) {
+        if ( std::fwrite(ptr, 1, len, m_stream) != len ) {
+            m_ec = errno ? errno : EIO;
+        }
+    }
+    void flush() {
+        if ( std::fflush(m_stream) != 0 ) {
+            m_ec = errno ? errno : EIO;
+        }
+    }
+    int error() const { return m_ec; }
+
+private:
+    std::FILE *m_stream;
+    int m_ec = 0;
+};
+
+namespace details {
+
+template<typename Sink>
+std::size_t serialize_with_ec(Sink &sink, const token *beg, const token *end, std::size_t indent, int *ec) {
+    const auto wr = serialize_to(sink, beg, end, indent);
+    if ( sink.error() ) {
+        if ( ec ) { *ec = sink.error(); }
 
         return 0;
     }
@@ -641,73 +714,30 @@ inline std::size_t serialize(
     return wr;
 }
 
+} // ns details
+
 inline std::size_t serialize(
-     std::FILE *stream
+     file_handle fd
     ,const iterator &beg
     ,const iterator &end
     ,std::size_t indent = 0
     ,int *ec = nullptr)
 {
-    static const auto cb = []
-    (    void *userdata
-        ,const void *ptr0
-        ,std::size_t size0
-        ,const void *ptr1
-        ,std::size_t size1
-        ,const void *ptr2
-        ,std::size_t size2
-        ,const void *ptr3
-        ,std::size_t size3
-        ,std::size_t num
-        ,std::size_t /*total_bytes*/
-        ,int *ec)
-    {
-        auto *stream = static_cast<std::FILE*>(userdata);
-        const io_vector iovector[4] = {
-             {const_cast<void *>(ptr0), size0}
-            ,{const_cast<void *>(ptr1), size1}
-            ,{const_cast<void *>(ptr2), size2}
-            ,{const_cast<void *>(ptr3), size3}
-        };
-        const auto *vec = static_cast<const io_vector *>(iovector);
-        for ( auto *iovend = vec + num; vec != iovend; ++vec ) {
-            auto wr = std::fwrite(__FJ_IO_VECTOR_PTR(vec), 1, __FJ_IO_VECTOR_SIZE(vec), stream);
-            if ( wr != __FJ_IO_VECTOR_SIZE(vec) ) {
-                *ec = errno;
+    fd_sink sink{fd};
 
-                break;
-            }
-        }
-    };
-
-    int lec{};
-    std::size_t wr{};
-    if ( indent ) {
-        wr = details::walk_through_tokens<false, true>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,stream
-            ,cb
-            ,&lec
-        );
-    } else {
-        wr = details::walk_through_tokens<false, false>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,stream
-            ,cb
-            ,&lec
-        );
-    }
-    if ( lec && ec ) {
-        *ec = lec;
+    return details::serialize_with_ec(sink, beg.cur, end.end, indent, ec);
+}
 
-        return 0;
-    }
+inline std::size_t serialize(
+     std::FILE *stream
+    ,const iterator &beg
+    ,const iterator &end
+    ,std::size_t indent = 0
+    ,int *ec = nullptr)
+{
+    file_sink sink{stream};
 
-    return wr;
+    return details::serialize_with_ec(sink, beg.cur, end.end, indent, ec);
 }
 
 inline std::size_t serialize(
@@ -717,81 +747,9 @@ inline std::size_t serialize(
     ,std::size_t indent = 0
     ,int *ec = nullptr)
 {
-    static const auto cb = []
-    (    void *userdata
-        ,const void *ptr0
-        ,std::size_t size0
-        ,const void *ptr1
-        ,std::size_t size1
-        ,const void *ptr2
-        ,std::size_t size2
-        ,const void *ptr3
-        ,std::size_t size3
-        ,std::size_t num
-        ,std::size_t /*total_bytes*/
-        ,int *ec)
-    {
-        const io_vector iovector[4] = {
-             {const_cast<void *>(ptr0), size0}
-            ,{const_cast<void *>(ptr1), size1}
-            ,{const_cast<void *>(ptr2), size2}
-            ,{const_cast<void *>(ptr3), size3}
-        };
-        auto *stream = static_cast<std::ostream *>(userdata);
-        const auto *vec = static_cast<const io_vector *>(iovector);
-        for ( auto *iovend = vec + num; vec != iovend; ++vec ) {
-            auto ppos = stream->tellp();
-            if ( ppos == -1 ) {
-                *ec = errno;
-
-                return;
-            }
-
-            auto wr = stream->write(
-                 static_cast<const char *>(__FJ_IO_VECTOR_PTR(vec))
-                ,__FJ_IO_VECTOR_SIZE(vec)
-            ).tellp();
-            if ( wr == -1 ) {
-                *ec = errno;
-
-                return;
-            }
-            if ( static_cast<std::size_t>(wr - ppos) != __FJ_IO_VECTOR_SIZE(vec) ) {
-                *ec = errno;
-
-                return;
-            }
-        }
-    };
+    ostream_sink sink{stream};
 
-    int lec{};
-    std::size_t wr{};
-    if ( indent ) {
-        wr = details::walk_through_tokens<false, true>(
-             beg
-            ,end
-            ,indent
-            ,&stream
-            ,cb
-            ,&lec
-        );
-    } else {
-        wr = details::walk_through_tokens<false, false>(
-             beg
-            ,end
-            ,indent
-            ,&stream
-            ,cb
-            ,&lec
-        );
-    }
-    if ( lec && ec ) {
-        *ec = lec;
-
-        return 0;
-    }
-
-    return wr;
+    return details::serialize_with_ec(sink, beg, end, indent, ec);
 }
 
 inline std::size_t serialize(
@@ -812,69 +770,9 @@ inline std::size_t serialize(
     ,std::size_t indent = 0
     ,int *ec = nullptr)
 {
-    struct tokens_to_buf_userdata {
-        char *ptr;
-        const char *end;
-    };
-    tokens_to_buf_userdata userdata{buf, buf + bufsize};
-
-    static const auto cb = []
-    (    void *userdata
-        ,const void *ptr0
-        ,std::size_t size0
-        ,const void *ptr1
-        ,std::size_t size1
-        ,const void *ptr2
-        ,std::size_t size2
-        ,const void *ptr3
-        ,std::size_t size3
-        ,std::size_t num
-        ,std::size_t /*total_bytes*/
-        ,int */*ec*/)
-    {
-        const io_vector iovector[4] = {
-             {const_cast<void *>(ptr0), size0}
-            ,{const_cast<void *>(ptr1), size1}
-            ,{const_cast<void *>(ptr2), size2}
-            ,{const_cast<void *>(ptr3), size3}
-        };
-
-        auto *puserdata = static_cast<tokens_to_buf_userdata *>(userdata);
-        const auto *vec = static_cast<const io_vector *>(iovector);
-        for ( auto *iovend = vec + num; vec != iovend; ++vec ) {
-            std::memcpy(puserdata->ptr, __FJ_IO_VECTOR_PTR(vec), __FJ_IO_VECTOR_SIZE(vec));
-            puserdata->ptr += __FJ_IO_VECTOR_SIZE(vec);
-        }
-    };
-
-    int lec{};
-    std::size_t wr{};
-    if ( indent ) {
-        wr = details::walk_through_tokens<false, true>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,&userdata
-            ,cb
-            ,&lec
-        );
-    } else {
-        wr = details::walk_through_tokens<false, false>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,&userdata
-            ,cb
-            ,&lec
-        );
-    }
-    if ( lec && ec ) {
-        *ec = lec;
+    buffer_sink sink{buf, bufsize};
 
-        return 0;
-    }
-
-    return wr;
+    return details::serialize_with_ec(sink, beg.cur, end.end, indent, ec);
 }
 
 inline std::size_t length_for_string(
@@ -883,34 +781,9 @@ inline std::size_t length_for_string(
     ,std::size_t indent = 0
     ,int *ec = nullptr)
 {
-    int lec{};
-    std::size_t wr{};
-    if ( indent ) {
-        wr = details::walk_through_tokens<true, true>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,nullptr
-            ,nullptr
-            ,&lec
-        );
-    } else {
-        wr = details::walk_through_tokens<true, false>(
-             beg.cur
-            ,end.end
-            ,indent
-            ,nullptr
-            ,nullptr
-            ,&lec
-        );
-    }
-    if ( lec && ec ) {
-        *ec = lec;
+    length_sink sink;
 
-        return 0;
-    }
-
-    return wr;
+    return details::serialize_with_ec(sink, beg.cur, end.end, indent, ec);
 }
 
 inline std::string to_string(
@@ -919,11 +792,15 @@ inline std::string to_string(
     ,std::size_t indent = 0
     ,int *ec = nullptr)
 {
+    // a single pass, the string is grown by the amortized reservations.
+    // the initial capacity is a guess by the number of the tokens.
     std::string res;
-    auto length = length_for_string(beg, end, indent);
-    res.resize(length);
+    if ( beg.cur && end.end ) {
+        res.reserve(static_cast<std::size_t>(end.end - beg.cur + 1) * (8u + indent));
+    }
 
-    serialize(beg, end, &(res[0]), res.size(), indent, ec);
+    string_sink sink{res};
+    details::serialize_with_ec(sink, beg.cur, end.end, indent, ec);
     if ( ec && *ec ) {
         return std::string{};
     }
@@ -964,13 +841,18 @@ inline bool pack_state_iterate(
         ,std::uint32_t end_off
     ))
 {
-    const auto *prev = parser->toks_beg;
+    // the first token is relative to the start of the string
+    const token *prev = nullptr;
     const char *prev_key = nullptr;
     const char *prev_val = nullptr;
+    // the END tokens are using the key field for the lookup index
+    static const auto key_of = [](const token *t) -> const char * {
+        return (t->type == FJ_TYPE_OBJECT_END || t->type == FJ_TYPE_ARRAY_END) ? nullptr : t->key;
+    };
     for ( const auto *it = parser->toks_beg; it != parser->toks_cur; prev = it++ ) {
-        prev_key = ((prev && prev->key) ? prev->key : prev_key);
+        prev_key = ((prev && key_of(prev)) ? key_of(prev) : prev_key);
         prev_val = ((prev && prev->val) ? prev->val : prev_val);
-        auto offset_key = it->key
+        auto offset_key = key_of(it)
             ? static_cast<std::uint32_t>(
                 it->key - ((prev_key && it->key) ? prev_key : parser->str_beg))
             : 0u
@@ -1226,11 +1108,32 @@ inline bool unpack_state(parser *parser, char *ptr, std::size_t size) {
         it->type   = static_cast<token_type>(type);
         it->key    = (key_off ? (prev_key ? prev_key + key_off : parser->str_beg + key_off): nullptr);
         it->klen   = static_cast<decltype(it->klen)>(key_len);
-        it->val    = (val_off ? (prev_val ? prev_val + val_off : parser->str_beg + val_off): nullptr);
+        it->khash  = it->key ? details::key_hash8(details::key_hash(it->key, key_len)) : 0;
+        // the first token is relative to the start of the string, the next ones to the previous value
+        it->val    = (it == parser->toks_beg
+            ? (it->type != FJ_TYPE_INVALID ? parser->str_beg + val_off : nullptr)
+            : (val_off ? prev_val + val_off : nullptr)
+        );
         it->vlen   = static_cast<decltype(it->vlen)>(val_len);
         it->parent = (parent_off ? it - parent_off : nullptr);
         it->childs = static_cast<decltype(it->childs)>(childs);
         it->end    = (end_off ? it + end_off : nullptr);
+
+        // the flags are not packed, so are recomputed as the parser does
+        const bool is_container = it->type == FJ_TYPE_OBJECT || it->type == FJ_TYPE_ARRAY;
+        it->flags = is_container ? FJ_FLAG_SIMPLE_CHILDS : 0;
+        if ( it->key && details::has_escapes(it->key, it->klen) ) {
+            it->flags |= FJ_FLAG_KEY_ESCAPED;
+        }
+        if ( it->type == FJ_TYPE_STRING && details::has_escapes(it->val, it->vlen) ) {
+            it->flags |= FJ_FLAG_VALUE_ESCAPED;
+        }
+        if ( it->type == FJ_TYPE_NUMBER ) {
+            it->flags |= details::number_flags(it->val, it->vlen);
+        }
+        if ( is_container && it->parent ) {
+            it->parent->flags &= ~FJ_FLAG_SIMPLE_CHILDS;
+        }
     }
     parser->error = FJ_EC_OK;
 
@@ -1241,4 +1144,6 @@ inline bool unpack_state(parser *parser, char *ptr, std::size_t size) {
 
 } // ns flatjson
 
+#undef FJ_IOV_BATCH_SIZE
+
 #endif // __FLATJSON__IO_HPP
@@ -20,6 +20,7 @@
 #include <functional>
 
 #include <cassert>
+#include <clocale>
 
 /*************************************************************************************************/
 
@@ -235,6 +236,34 @@ test_result test_conformance() {
 
 /*************************************************************************************************/
 
+namespace bound {
+
+enum class color { red, green, blue };
+FJ_BIND_ENUM(color, red, green, blue)
+
+enum level { low = 1, high = 2 };
+
+struct point {
+    int x;
+    int y;
+};
+FJ_BIND_STRUCT(point, x, y)
+
+struct shape {
+    std::string name;
+    color fill;
+    level lvl;
+    std::vector<point> points;
+    std::vector<double> weights;
+    std::vector<std::vector<int>> grid;
+    bool closed;
+};
+FJ_BIND_STRUCT(shape, name, fill, lvl, points, weights, grid, closed)
+
+} // ns bound
+
+/*************************************************************************************************/
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable:4127)
@@ -705,9 +734,9 @@ int main() {
         assert(myallocator.allocations() == 1);
         auto total_allocated = myallocator.total_alloc();
         if ( sizeof(void *) == 4 ) {
-            assert(total_allocated == 44);
+            assert(total_allocated == 48);
         } else {
-            assert(total_allocated == 80);
+            assert(total_allocated == 88);
         }
 
         assert(is_valid(parser));
@@ -847,9 +876,9 @@ int main() {
         assert(myallocator.allocations() == 2);
         auto total_allocated = myallocator.total_alloc();
         if ( sizeof(void *) == 4 ) {
-            assert(total_allocated == 212);
+            assert(total_allocated == 216);
         } else {
-            assert(total_allocated == 360);
+            assert(total_allocated == 368);
         }
 
         assert(is_valid(parser));
@@ -2604,6 +2633,1586 @@ R"({
         free_parser(&parser);
     };
 
+    test += FJ_TEST(test for the lookup index of a wide OBJECT) {
+        using namespace flatjson;
+
+        std::string str = "{";
+        for ( auto idx = 0u; idx < 100; ++idx ) {
+            str += idx ? ",\"k" : "\"k";
+            str += std::to_string(idx);
+            str += "\":";
+            if ( idx % 10 == 0 ) {
+                str += "{\"v\":";
+                str += std::to_string(idx);
+                str += "}";
+            } else {
+                str += std::to_string(idx);
+            }
+        }
+        str += "}";
+
+        auto *parser = alloc_parser(str.c_str(), str.c_str() + str.size(), &my_alloc, &my_free);
+        parse(parser);
+        assert(is_valid(parser));
+
+        auto beg = iter_begin(parser);
+        assert(!has_index(beg));
+        assert(iter_members(beg) == 100);
+
+        // the lookups do not build the index
+        auto k0 = iter_at("k0", parser);
+        assert(!has_index(beg));
+        assert(build_indexes(parser));
+        assert(has_index(beg));
+        assert(iter_equal(iter_at("k0", parser), k0));
+        assert(k0.is_object());
+        assert(iter_at("v", k0).to_uint() == 0);
+        assert(!has_index(k0));
+
+        for ( auto idx = 0u; idx < 100; ++idx ) {
+            auto key = std::string{"k"} + std::to_string(idx);
+            auto it = iter_at(key.c_str(), parser);
+            assert(it.is_valid());
+            if ( idx % 10 == 0 ) {
+                assert(it.is_object());
+                assert(iter_at("v", it).to_uint() == idx);
+            } else {
+                assert(it.is_number());
+                assert(it.to_uint() == idx);
+            }
+        }
+        assert(iter_equal(iter_at("k100", parser), iter_end(parser)));
+        assert(iter_equal(iter_at("k", parser), iter_end(parser)));
+
+        iterator ldiff, rdiff;
+        assert(compare(&ldiff, &rdiff, parser, parser, compare_mode::full) == compare_result::equal);
+
+        free_parser(parser);
+        assert(myallocator.allocations() == 0);
+
+        fjson json{str.c_str(), str.c_str() + str.size()};
+        assert(json.is_valid());
+        assert(json.contains("k99"));
+        assert(!has_index(*json.begin()));
+        assert(json.build_indexes());
+        assert(has_index(*json.begin()));
+        assert(json.contains("k99"));
+        assert(json["k42"].to_uint() == 42);
+        assert(json["k50"]["v"].to_uint() == 50);
+    };
+
+    test += FJ_TEST(test for the key hashes computed while parsing) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"ab":0, "ba":1, "c":{"ab":2, "":3}, "d":[{"ba":4}]})";
+        auto *parser = alloc_parser(str);
+        auto toknum = parse(parser);
+        assert(is_valid(parser));
+        assert(toknum == 13);
+
+        for ( const auto *it = parser->toks_beg; it != parser->toks_end; ++it ) {
+            if ( it->parent && it->parent->type == FJ_TYPE_OBJECT && it->klen ) {
+                assert(it->khash == details::key_hash8(details::key_hash(it->key, it->klen)));
+            }
+        }
+
+        assert(iter_at("ab", parser).to_uint() == 0);
+        assert(iter_at("ba", parser).to_uint() == 1);
+        auto c = iter_at("c", parser);
+        assert(iter_at("ab", c).to_uint() == 2);
+        assert(iter_at("", c).to_uint() == 3);
+        assert(iter_equal(iter_at("ba", c), iter_end(c)));
+        auto d0 = iter_at(0, iter_at("d", parser));
+        assert(iter_at("ba", d0).to_uint() == 4);
+
+        // the hashes should survive the pack/unpack
+        auto size = packed_state_size(parser);
+        std::vector<char> packed(size);
+        assert(pack_state(packed.data(), size, parser) == size);
+        auto parser2 = init_parser();
+        assert(unpack_state(&parser2, packed.data(), size));
+        assert(iter_at("ba", &parser2).to_uint() == 1);
+        assert(iter_at("ab", iter_at("c", &parser2)).to_uint() == 2);
+
+        free_parser(&parser2);
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for the compile-time schema) {
+        using namespace flatjson;
+
+        static constexpr auto s = make_schema("id", "name", "price", "tags", "extra");
+        static_assert(s.size() == 5, "");
+        static_assert(s.index("id") == 0, "");
+        static_assert(s.index("price") == 2, "");
+        static_assert(s.index("extra") == 4, "");
+        static_assert(s.index("unknown") == s.size(), "");
+        assert(s.key(1) == "name");
+        assert(s.index("tags", 4) == 3);
+        assert(s.index("tag", 3) == s.size());
+
+        static const char str[] = R"({"name":"x", "other":1, "tags":{"a":[1,2]}, "price":3.5, "id":7, "id":8})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        iterator fields[s.size()];
+        assert(s.bind(iter_begin(parser), fields) == 4);
+        assert(fields[s.index("id")].to_uint() == 7);
+        assert(fields[s.index("name")].to_string() == "x");
+        assert(fields[s.index("price")].to_double() == 3.5);
+        assert(!fields[s.index("extra")].is_valid());
+        auto tags = fields[s.index("tags")];
+        assert(tags.is_object());
+        assert(iter_at("a", tags).members() == 2);
+        assert(iter_equal(tags, iter_at("tags", parser)));
+
+        // only OBJECTs can be bound
+        assert(s.bind(iter_at(1, iter_at("a", tags)), fields) == 0);
+        assert(!fields[0].is_valid());
+
+        // the escaped keys are decoded
+        static const char esc[] = R"({"na\u006de":"y", "\u0069d":9, "price\n":1})";
+        auto *eparser = alloc_parser(esc);
+        parse(eparser);
+        assert(is_valid(eparser));
+        assert(s.bind(iter_begin(eparser), fields) == 2);
+        assert(fields[s.index("name")].to_string() == "y");
+        assert(fields[s.index("id")].to_uint() == 9);
+        assert(!fields[s.index("price")].is_valid());
+        free_parser(eparser);
+
+        // the duplicated keys: not compiled as constexpr, not valid at runtime
+        static_assert(s.is_valid(), "");
+        const auto dup = make_schema("id", "name", "id");
+        assert(!dup.is_valid());
+        assert(dup.index("name", 4) == dup.size());
+        assert(dup.index("name") == dup.size());
+        iterator dfields[dup.size()];
+        assert(dup.bind(iter_begin(parser), dfields) == 0);
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for the lookup index of a wide ARRAY) {
+        using namespace flatjson;
+
+        std::string str = "[";
+        for ( auto idx = 0u; idx < 100; ++idx ) {
+            str += idx ? "," : "";
+            if ( idx % 3 == 0 ) {
+                str += "{\"v\":";
+                str += std::to_string(idx);
+                str += "}";
+            } else if ( idx % 3 == 1 ) {
+                str += "[";
+                str += std::to_string(idx);
+                str += ",0]";
+            } else {
+                str += std::to_string(idx);
+            }
+        }
+        str += "]";
+
+        auto *parser = alloc_parser(str.c_str(), str.c_str() + str.size(), &my_alloc, &my_free);
+        parse(parser);
+        assert(is_valid(parser));
+
+        auto beg = iter_begin(parser);
+        assert(!has_index(beg));
+        assert(iter_members(beg) == 100);
+
+        auto it = iter_at(98, parser);
+        assert(!has_index(beg));
+        assert(build_indexes(parser));
+        assert(has_index(beg));
+        assert(it.to_uint() == 98);
+        assert(iter_equal(iter_at(98, parser), it));
+
+        // the same elements as by sequential iteration
+        auto seq = iter_next(iter_begin(beg));
+        for ( auto idx = 0u; idx < 100; ++idx, seq = iter_next(seq) ) {
+            auto it = iter_at(idx, parser);
+            assert(iter_equal(it, seq));
+            if ( idx % 3 == 0 ) {
+                assert(iter_at("v", it).to_uint() == idx);
+            } else if ( idx % 3 == 1 ) {
+                assert(iter_at(0, it).to_uint() == idx);
+            } else {
+                assert(it.to_uint() == idx);
+            }
+        }
+        assert(iter_equal(iter_at(100, parser), iter_end(parser)));
+        assert(iter_equal(iter_at(1000, parser), iter_end(parser)));
+
+        // the arrays of simple types do not need the index
+        auto nested = iter_at(1, parser);
+        assert(build_index(parser, nested));
+        assert(!has_index(nested));
+        assert(iter_at(1, nested).to_uint() == 0);
+        assert(iter_equal(iter_at(2, nested), iter_end(nested)));
+
+        free_parser(parser);
+        assert(myallocator.allocations() == 0);
+
+        fjson json{str.c_str(), str.c_str() + str.size()};
+        assert(json.is_valid());
+        assert(json[98].to_uint() == 98);
+        assert(json[97][0].to_uint() == 97);
+        assert(json[96]["v"].to_uint() == 96);
+    };
+
+    test += FJ_TEST(test for iter_next over the members with big subtrees) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a":[1,[2,[3]],{"x":4}], "b":5, "c":{"y":{"z":[6,7]}}, "d":[]})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        static const char *keys[] = {"a", "b", "c", "d"};
+        auto beg = iter_begin(parser);
+        auto it = iter_next(beg);
+        auto idx = 0u;
+        for ( ; iter_not_equal(it, iter_end(parser)); it = iter_next(it), ++idx ) {
+            assert(it.key() == keys[idx]);
+            assert(iter_equal(it, iter_at(keys[idx], parser)));
+            assert(iter_distance(iter_next(beg), it) == idx);
+        }
+        assert(idx == 4);
+
+        // the iteration inside of the nested container
+        auto a = iter_at("a", parser);
+        auto a0 = iter_next(a);
+        assert(a0.to_uint() == 1);
+        auto a1 = iter_next(a0);
+        assert(a1.is_array() && a1.cur->childs == 3);
+        auto a2 = iter_next(a1);
+        assert(a2.is_object());
+        assert(iter_equal(iter_next(a2), iter_end(a)));
+        assert(iter_distance(a0, a2) == 2);
+
+        fjson json{str};
+        idx = 0;
+        for ( auto it = ++json.begin(); it != json.end(); ++it, ++idx ) {
+            assert(it->key() == keys[idx]);
+        }
+        assert(idx == 4);
+        assert(json.keys_num() == 4);
+        assert(json["c"].keys_num() == 1);
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for JSON Pointer) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a":{"b":[10,{"c":"x"},[20,21]]}, "m~n":1, "a/b":2, "":3, "7":4, "e":[]})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        pointer p0{"/a/b/1/c"};
+        assert(p0.is_valid());
+        assert(p0.size() == 4);
+        assert(p0.segment(2) == "1");
+        assert(iter_at(p0, parser).to_string() == "x");
+
+        assert(iter_at(pointer{"/a/b/0"}, parser).to_uint() == 10);
+        assert(iter_at(pointer{"/a/b/2/1"}, parser).to_uint() == 21);
+        assert(iter_at(pointer{"/m~0n"}, parser).to_uint() == 1);
+        assert(iter_at(pointer{"/a~1b"}, parser).to_uint() == 2);
+        assert(iter_at(pointer{"/"}, parser).to_uint() == 3);
+        assert(iter_at(pointer{"/7"}, parser).to_uint() == 4);
+        assert(iter_at(pointer{""}, parser).is_object());
+
+        auto b = iter_at(pointer{"/a/b"}, parser);
+        assert(b.is_array());
+        assert(iter_at(pointer{"/2/0"}, b).to_uint() == 20);
+
+        // not found
+        assert(!iter_at(pointer{"/a/b/3"}, parser).is_valid());
+        assert(!iter_at(pointer{"/a/b/-"}, parser).is_valid());
+        assert(!iter_at(pointer{"/a/b/01"}, parser).is_valid());
+        assert(!iter_at(pointer{"/a/x"}, parser).is_valid());
+        assert(!iter_at(pointer{"/a/b/0/c"}, parser).is_valid());
+        assert(!iter_at(pointer{"/e/0"}, parser).is_valid());
+        assert(!iter_at(pointer{"/z"}, parser).is_valid());
+
+        // syntax errors
+        assert(!pointer{"a"}.is_valid());
+        assert(!pointer{"/a~2"}.is_valid());
+        assert(!pointer{"/a~"}.is_valid());
+        assert(!iter_at(pointer{"/a~"}, parser).is_valid());
+
+        free_parser(parser);
+
+        fjson json{str};
+        static const pointer p1{"/a/b/2/0"};
+        assert(json.at(p1).to_uint() == 20);
+        assert(json["a"].at(pointer{"/b/1/c"}).to_string() == "x");
+        assert(json["a"].at(pointer{"/b/5"}).type() == FJ_TYPE_OBJECT_END);
+    };
+
+    test += FJ_TEST(test for JSONPath) {
+        using namespace flatjson;
+
+        static const char str[] = R"({
+            "store":{
+                "book":[
+                     {"category":"reference", "author":"Nigel Rees", "title":"Sayings", "price":8.95}
+                    ,{"category":"fiction", "author":"Evelyn Waugh", "title":"Sword", "price":12.99}
+                    ,{"category":"fiction", "author":"Herman Melville", "title":"Moby Dick", "isbn":"0-553", "price":8.99}
+                    ,{"category":"fiction", "author":"J. R. R. Tolkien", "title":"The Lord", "isbn":"0-395", "price":22.99}
+                ]
+                ,"bicycle":{"color":"red", "price":19.95}
+            }
+            ,"flags":[true, false, null, 1]
+        })";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        const auto values = [parser](const char *path) {
+            jsonpath jp{path};
+            assert(jp.is_valid());
+            std::string res;
+            for ( const auto &it: jp.select(parser) ) {
+                res += res.empty() ? "" : ",";
+                res += it.is_simple_type() ? it.to_string() : std::string{it.type_name()};
+            }
+            return res;
+        };
+
+        assert(values("$.store.book[*].author") == "Nigel Rees,Evelyn Waugh,Herman Melville,J. R. R. Tolkien");
+        assert(values("$..author") == "Nigel Rees,Evelyn Waugh,Herman Melville,J. R. R. Tolkien");
+        assert(values("$.store.*") == "ARRAY,OBJECT");
+        assert(values("$.store..price") == "8.95,12.99,8.99,22.99,19.95");
+        assert(values("$..book[2].title") == "Moby Dick");
+        assert(values("$..book[-1].title") == "The Lord");
+        assert(values("$..book[:2].price") == "8.95,12.99");
+        assert(values("$..book[1:].price") == "12.99,8.99,22.99");
+        assert(values("$..book[::2].price") == "8.95,8.99");
+        assert(values("$..book[::-1].price") == "22.99,8.99,12.99,8.95");
+        assert(values("$..book[-2:-1].price") == "8.99");
+        assert(values("$..book[?(@.isbn)].title") == "Moby Dick,The Lord");
+        assert(values("$..book[?(@.price < 10)].title") == "Sayings,Moby Dick");
+        assert(values("$..book[?(@.price >= 12.99)].price") == "12.99,22.99");
+        assert(values("$..book[?(@.category == 'reference')].author") == "Nigel Rees");
+        assert(values("$..book[?(@.category != 'fiction')].author") == "Nigel Rees");
+        assert(values("$.store['bicycle'].color") == "red");
+        assert(values("$.flags[?(@ == true)]") == "true");
+        assert(values("$.flags[?(@ == null)]") == "null");
+        assert(values("$.flags[?(@ > 0)]") == "1");
+        assert(values("$.flags[4]") == "");
+        assert(values("$.nothing..price") == "");
+        assert(values("$") == "OBJECT");
+
+        // the results are usual iterators
+        jsonpath jp{"$.store.bicycle"};
+        std::vector<iterator> res;
+        assert(jp.select(parser, res) == 1);
+        assert(iter_equal(res[0], iter_at("bicycle", iter_at("store", parser))));
+        assert(iter_at("color", res[0]).to_string() == "red");
+
+        assert(!jsonpath{""}.is_valid());
+        assert(!jsonpath{"store"}.is_valid());
+        assert(!jsonpath{"$.store["}.is_valid());
+        assert(!jsonpath{"$..book[?(@.price <)]"}.is_valid());
+        assert(!jsonpath{"$..book[?(@.price ~ 1)]"}.is_valid());
+        assert(!jsonpath{"$.a."}.is_valid());
+        assert(jsonpath{"$.a"}.select(parser).empty());
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for the multi-path extractor) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"id":7, "skip":{"a":[1,2,3]}, "user":{"name":"x", "tags":["a","b"]}, "items":[{"price":1.5}, {"price":2.5}], "m~n":9})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        extractor ex{"/id", "/user/name", "/items/1/price", "/user/tags/0", "/missing", "/items/5", "/m~0n"};
+        assert(ex.is_valid());
+        assert(ex.size() == 7);
+        assert(ex.add("/user") == 7);
+        assert(ex.add("") == 8);
+        assert(ex.add("/id") == 9);
+
+        iterator out[10];
+        assert(ex.extract(parser, out) == 8);
+        assert(out[0].to_uint() == 7);
+        assert(out[1].to_string() == "x");
+        assert(out[2].to_double() == 2.5);
+        assert(out[3].to_string() == "a");
+        assert(!out[4].is_valid());
+        assert(!out[5].is_valid());
+        assert(out[6].to_uint() == 9);
+        assert(out[7].is_object());
+        assert(iter_equal(out[7], iter_at("user", parser)));
+        assert(iter_equal(out[8], iter_begin(parser)));
+        assert(out[9].to_uint() == 7);
+
+        // the same as the pointers resolve
+        assert(iter_equal(out[2], iter_at(pointer{"/items/1/price"}, parser)));
+        assert(iter_equal(out[3], iter_at(pointer{"/user/tags/0"}, parser)));
+
+        std::vector<iterator> vec;
+        assert(ex.extract(iter_at("user", parser), vec) == 1);
+        assert(vec.size() == 10);
+        assert(vec[8].is_object());
+
+        extractor bad{"/id", "id"};
+        assert(!bad.is_valid());
+        assert(bad.extract(parser, vec) == 1);
+        assert(vec[0].to_uint() == 7);
+        assert(!vec[1].is_valid());
+
+        // the duplicated keys: the first one wins, the other paths are still found
+        {
+            fjson dup{R"({"a":1,"a":2,"b":3,"c":{"x":1},"c":{"y":2}})"};
+            extractor ex2{"/a", "/b", "/c/y"};
+            std::vector<iterator> res;
+            assert(ex2.extract(*dup.begin(), res) == 2);
+            assert(res[0].to_uint() == 1);
+            assert(res[1].to_uint() == 3);
+            assert(!res[2].is_valid());
+            assert(!pointer{"/c/y"}.resolve(*dup.begin()).is_valid());
+        }
+
+        // the escaped keys are decoded, as the pointers do
+        {
+            fjson esc{R"({"na\u006de":{"\u0078":1}, "a\/b":2})"};
+            extractor ex3{"/name/x", "/a~1b"};
+            std::vector<iterator> res;
+            assert(ex3.extract(*esc.begin(), res) == 2);
+            assert(res[0].to_uint() == 1);
+            assert(res[1].to_uint() == 2);
+            assert(iter_equal(res[0], pointer{"/name/x"}.resolve(*esc.begin())));
+        }
+
+        // more trie nodes than the flags on the stack
+        {
+            std::string json = "{";
+            extractor wide;
+            for ( auto idx = 0u; idx < 100; ++idx ) {
+                std::string key = "k";
+                key += std::to_string(idx);
+                json += idx ? "," : "";
+                json += "\"";
+                json += key;
+                json += "\":";
+                json += std::to_string(idx);
+                std::string path = "/";
+                path += key;
+                wide.add(path.c_str());
+            }
+            json += "}";
+            fjson doc{json.data(), json.data() + json.size()};
+            std::vector<iterator> res;
+            assert(wide.extract(*doc.begin(), res) == 100);
+            assert(res[99].to_uint() == 99);
+        }
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for the floating point conversion) {
+        using namespace flatjson;
+
+        static const char *strs[] = {
+             "0", "-0", "0.1", "-12.5E-3", "1e+5", "3.14159265358979323846"
+            ,"9007199254740993", "123456789012345678901234567890"
+            ,"2.2250738585072011e-308", "4.9406564584124654e-324", "1.7976931348623157e308"
+            ,"1.00000000000000011102230246251565404236316680908203125"
+            ,"1e400", "-1e400", "1e-400", "3.4028236e38", "7e-46", "1.4e-45"
+        };
+        for ( const auto *str: strs ) {
+            const auto d = details::conv_to(str, std::strlen(str), double{});
+            const auto e = std::strtod(str, nullptr);
+            assert(std::memcmp(&d, &e, sizeof(d)) == 0);
+            const auto f = details::conv_to(str, std::strlen(str), float{});
+            const auto g = std::strtof(str, nullptr);
+            assert(std::memcmp(&f, &g, sizeof(f)) == 0);
+        }
+
+        // longer than any stack buffer
+        std::string str = "0.";
+        str.append(400, '0');
+        str += "15";
+        assert(details::conv_to(str.data(), str.size(), double{}) == std::strtod(str.c_str(), nullptr));
+
+        static const char json[] = R"([0.1, -2.5e-3, 1e22, 1e23, 5e-324])";
+        fjson arr{json};
+        assert(arr[0].to_double() == 0.1);
+        assert(arr[1].to_double() == -2.5e-3);
+        assert(arr[2].to_double() == 1e22);
+        assert(arr[3].to_double() == 1e23);
+        assert(arr[4].to_double() == 5e-324);
+        assert(arr[0].to_float() == 0.1f);
+
+        // the slow path: the halfway points, decided by the digits far after the 19th one
+        static const char *halfway[] = {
+             "9007199254740993", "9007199254740993.0000000000000000000001", "9007199254740992.9999999999999999999999"
+            ,"2.4703282292062327e-324", "2.4703282292062328e-324", "1.7976931348623158e308", "1.7976931348623159e308"
+            ,"2.225073858507201136057409796709131975934819546351645648e-308", "3.4028235677973366e38"
+        };
+        for ( const auto *num: halfway ) {
+            const std::size_t len = std::strlen(num);
+            const auto d = details::parse_float_slow<double>(num, len);
+            const auto e = std::strtod(num, nullptr);
+            assert(std::memcmp(&d, &e, sizeof(d)) == 0);
+            const auto f = details::parse_float_slow<float>(num, len);
+            const auto g = std::strtof(num, nullptr);
+            assert(std::memcmp(&f, &g, sizeof(f)) == 0);
+        }
+        std::string exact = "1.00000000000000011102230246251565404236316680908203125";
+        assert(details::conv_to(exact.data(), exact.size(), double{}) == 1.0);
+        exact.append(700, '0');
+        exact += "1";
+        assert(details::conv_to(exact.data(), exact.size(), double{}) == 1.0000000000000002);
+
+        // the hex integers are rounded to nearest even
+        static const char *hexs[] = {"-0x1F", "-0x20000000000001", "-0x20000000000003", "-0x20000000000001000000001"};
+        static const double hexd[] = {-31.0, -9007199254740992.0, -9007199254740996.0, -618970019642690274888515584.0};
+        for ( auto idx = 0u; idx < 4; ++idx ) {
+            assert(details::conv_to(hexs[idx], std::strlen(hexs[idx]), double{}) == hexd[idx]);
+            assert(details::conv_to(hexs[idx], std::strlen(hexs[idx]), float{}) == static_cast<float>(hexd[idx]));
+        }
+        fjson hexarr{"[-0x20000000000001, -0xffffffffffffffffffffff]"};
+        assert(hexarr[0].to_double() == -9007199254740992.0);
+        assert(hexarr[1].to_double() == -309485009821345068724781056.0);
+
+        // the decimal point doesn't depend on the locale
+        const std::string prev = std::setlocale(LC_NUMERIC, nullptr);
+        if ( std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8") ) {
+            static const char slow[] = "1.50000000000000000000000000001";
+            assert(details::conv_to(slow, sizeof(slow) - 1, double{}) == 1.5);
+            std::setlocale(LC_NUMERIC, prev.c_str());
+        }
+    };
+
+    test += FJ_TEST(test for the checked conversions) {
+        using namespace flatjson;
+
+        static const char str[] = R"([255, 256, -128, -129, 18446744073709551615, 18446744073709551616
+            ,123456789012345678901234, 1.5, 1e3, -0, 9223372036854775807, -9223372036854775808
+            ,"12", true, null, 12345678901234567])";
+        fjson json{str};
+        assert(json.is_valid());
+
+        std::uint8_t u8 = 0;
+        assert(json[0].try_to(u8) == FJ_EC_OK && u8 == 255);
+        assert(json[1].try_to(u8) == FJ_EC_VALUE_OVERFLOW && u8 == 255);
+        assert(json[2].try_to(u8) == FJ_EC_NOT_CONVERTIBLE);
+
+        std::int8_t i8 = 0;
+        assert(json[2].try_to(i8) == FJ_EC_OK && i8 == -128);
+        assert(json[3].try_to(i8) == FJ_EC_VALUE_OVERFLOW);
+
+        std::uint64_t u64 = 0;
+        assert(json[4].try_to(u64) == FJ_EC_OK && u64 == UINT64_MAX);
+        assert(json[5].try_to(u64) == FJ_EC_VALUE_OVERFLOW);
+        assert(json[6].try_to(u64) == FJ_EC_VALUE_OVERFLOW);
+        assert(json[15].try_to(u64) == FJ_EC_OK && u64 == 12345678901234567ull);
+
+        // the fraction and the exponent are not integers
+        std::int32_t i32 = 0;
+        assert(json[7].try_to(i32) == FJ_EC_NOT_CONVERTIBLE);
+        assert(json[8].try_to(i32) == FJ_EC_NOT_CONVERTIBLE);
+        assert(json[9].try_to(i32) == FJ_EC_OK && i32 == 0);
+        assert(json[12].try_to(i32) == FJ_EC_NOT_CONVERTIBLE);
+
+        std::int64_t i64 = 0;
+        assert(json[10].try_to(i64) == FJ_EC_OK && i64 == INT64_MAX);
+        assert(json[11].try_to(i64) == FJ_EC_OK && i64 == INT64_MIN);
+        assert(json[4].try_to(i64) == FJ_EC_VALUE_OVERFLOW);
+
+        double d = 0;
+        assert(json[7].try_to(d) == FJ_EC_OK && d == 1.5);
+        assert(json[8].try_to(d) == FJ_EC_OK && d == 1e3);
+        assert(json[13].try_to(d) == FJ_EC_NOT_CONVERTIBLE);
+
+        bool b = false;
+        assert(json[13].try_to(b) == FJ_EC_OK && b);
+        assert(json[0].try_to(b) == FJ_EC_NOT_CONVERTIBLE);
+
+        std::string s;
+        assert(json[12].try_to(s) == FJ_EC_OK && s == "12");
+
+        assert(std::strcmp(error_string(FJ_EC_VALUE_OVERFLOW), "VALUE_OVERFLOW") == 0);
+
+        // the SWAR path for all the lengths
+        std::uint64_t expected = 0;
+        std::string digits;
+        for ( auto idx = 1u; idx <= 19; ++idx ) {
+            digits += static_cast<char>('0' + idx % 10);
+            expected = expected * 10 + idx % 10;
+            assert(details::try_conv(digits.data(), digits.size(), &u64) == FJ_EC_OK);
+            assert(u64 == expected);
+        }
+    };
+
+    test += FJ_TEST(test for the bulk extraction of ARRAYs) {
+        using namespace flatjson;
+
+        std::string str = "[";
+        for ( auto idx = 0u; idx < 1000; ++idx ) {
+            str += idx ? "," : "";
+            str += std::to_string(idx);
+            str += ".5";
+        }
+        str += "]";
+
+        fjson json{str.c_str(), str.c_str() + str.size()};
+        assert(json.is_valid());
+
+        std::vector<double> vals;
+        assert(json.extract_array(vals) == 1000);
+        for ( auto idx = 0u; idx < vals.size(); ++idx ) {
+            assert(vals[idx] == idx + 0.5);
+        }
+
+        float buf[10];
+        assert(json.extract_array(buf, 10) == 10);
+        assert(buf[9] == 9.5f);
+
+        // the integers are not converted from the fractional numbers
+        std::vector<int> ints;
+        assert(json.extract_array(ints) == 0);
+
+        static const char mixed[] = R"([1, -2, 3, "4", 5, [6]])";
+        fjson json2{mixed};
+        assert(json2.extract_array(ints) == 3);
+        assert(ints[0] == 1 && ints[1] == -2 && ints[2] == 3);
+
+        static const char bools[] = R"([true, false, true])";
+        bool barr[3] = {};
+        assert(fjson{bools}.extract_array(barr, 3) == 3);
+        assert(barr[0] && !barr[1] && barr[2]);
+
+        assert(fjson{"{\"a\":1}"}.extract_array(ints) == 0);
+        assert(ints.empty());
+
+        // the short numbers are parsed by the eight digits at once, the others by try_to()
+        static const char edges[] = R"([0, -0, 127, -128, 128, 1234567890123456, -9007199254740993, 12345678901234567890,
+            0.5, -0.25, 1.0, 123456789.123456, 9007199254740993, 1e2, 0.1234567890123456789, -0x10])";
+        fjson nums{edges};
+        assert(nums.is_valid());
+        std::vector<double> dbls;
+        assert(nums.extract_array(dbls) == 16);
+        std::vector<std::int64_t> i64s;
+        assert(nums.extract_array(i64s) == 7);
+        std::vector<std::int8_t> i8s;
+        assert(nums.extract_array(i8s) == 4 && i8s[3] == -128);
+        std::vector<unsigned> uints;
+        assert(nums.extract_array(uints) == 1);
+        for ( auto idx = 0u; idx < 16; ++idx ) {
+            double d{};
+            assert(nums[idx].try_to(d) == FJ_EC_OK && std::memcmp(&d, &dbls[idx], sizeof(d)) == 0);
+            std::int64_t i{};
+            if ( idx < i64s.size() ) {
+                assert(nums[idx].try_to(i) == FJ_EC_OK && i == i64s[idx]);
+            }
+        }
+        std::vector<float> flts;
+        assert(nums.extract_array(flts) == 16);
+        assert(flts[10] == 1.0f && flts[11] == 123456789.123456f);
+
+#ifdef __FJ__EXTRACT_ARRAY_THREADS
+        // the chunks converted by the threads, the first error is reported
+        std::string large = "[";
+        for ( auto idx = 0u; idx < 10000; ++idx ) {
+            large += idx ? "," : "";
+            large += std::to_string(idx);
+        }
+        large += "]";
+        auto *parser = alloc_parser(large.data(), large.data() + large.size());
+        parse(parser);
+        assert(is_valid(parser));
+        const token *toks = iter_begin(parser).cur + 1;
+        const char *limit = large.data() + large.size();
+        std::vector<std::int64_t> res(10000);
+        assert(details::extract_range_mt(toks, res.size(), limit, res.data(), 4) == 10000);
+        for ( auto idx = 0u; idx < res.size(); ++idx ) {
+            assert(res[idx] == idx);
+        }
+        std::vector<std::uint8_t> small(10000);
+        assert(details::extract_range_mt(toks, small.size(), limit, small.data(), 4) == 256);
+        free_parser(parser);
+#endif // __FJ__EXTRACT_ARRAY_THREADS
+    };
+
+    test += FJ_TEST(test for the unescaping of strings) {
+        using namespace flatjson;
+
+        static const char str[] = R"(["plain", "a\nb\t\"q\"\\\/", "A\u00e9\u20AC", "\ud83d\ude00!", "\ud800x", 1])";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        arena a{16};
+        // zero-copy without escapes
+        auto s0 = unescape(iter_at(0, parser), a);
+        assert(s0 == "plain");
+        assert(s0.data() == iter_at(0, parser).value().data());
+
+        assert(unescape(iter_at(1, parser), a) == "a\nb\t\"q\"\\/");
+        assert(unescape(iter_at(2, parser), a) == "A\xc3\xa9\xe2\x82\xac");
+        assert(unescape(iter_at(3, parser), a) == "\xf0\x9f\x98\x80!");
+        assert(unescape(iter_at(4, parser), a) == "\xef\xbf\xbdx");
+        assert(unescape(iter_at(5, parser), a) == "1");
+
+        char buf[32];
+        auto s1 = unescape_to(iter_at(1, parser), buf, sizeof(buf));
+        assert(s1.data() == buf);
+        assert(s1 == "a\nb\t\"q\"\\/");
+        assert(unescape_to(iter_at(1, parser), buf, 4).data() == nullptr);
+
+        std::string out;
+        assert(unescape_to(iter_at(3, parser), out) == "\xf0\x9f\x98\x80!");
+        assert(out == "\xf0\x9f\x98\x80!");
+        assert(unescape_to(iter_at(0, parser), out).data() == iter_at(0, parser).value().data());
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for the escape flags) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a":"x", "b\n":"y\"", "c":{"d\u0041":1}, "e":["\t", "f"]})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        auto a = iter_at("a", parser);
+        assert(!a.is_key_escaped() && !a.is_value_escaped());
+        auto b = iter_at("b\\n", parser);
+        assert(b.is_valid() && b.is_key_escaped() && b.is_value_escaped());
+        // the escaped keys are found by the decoded form too
+        assert(iter_equal(iter_at("b\n", parser), b));
+        auto c = iter_at("c", parser);
+        assert(!c.is_key_escaped());
+        assert(c.cur->flags == FJ_FLAG_SIMPLE_CHILDS);
+        auto da = iter_at("dA", c);
+        assert(da.is_key_escaped() && da.to_uint() == 1);
+        auto e = iter_at("e", parser);
+        assert(iter_at(0, e).is_value_escaped());
+        assert(!iter_at(1, e).is_value_escaped());
+        assert(parser->toks_beg->flags == 0);
+
+        // the flags should survive the pack/unpack
+        auto size = packed_state_size(parser);
+        std::vector<char> packed(size);
+        assert(pack_state(packed.data(), size, parser) == size);
+        auto parser2 = init_parser();
+        assert(unpack_state(&parser2, packed.data(), size));
+        for ( auto idx = 0u; idx < static_cast<std::size_t>(parser->toks_end - parser->toks_beg); ++idx ) {
+            assert(parser->toks_beg[idx].flags == parser2.toks_beg[idx].flags);
+        }
+        free_parser(&parser2);
+        free_parser(parser);
+
+        // the lookup index by the decoded keys
+        std::string wide = "{";
+        for ( auto idx = 0u; idx < 50; ++idx ) {
+            wide += idx ? ",\"k\\u0030" : "\"k\\u0030";
+            wide += std::to_string(idx);
+            wide += "\":";
+            wide += std::to_string(idx);
+        }
+        wide += "}";
+        fjson json{wide.c_str(), wide.c_str() + wide.size()};
+        assert(json.is_valid());
+        assert(json["k042"].to_uint() == 42);
+        assert(json["k\\u003049"].to_uint() == 49);
+    };
+
+    test += FJ_TEST(test for the number kind flags) {
+        using namespace flatjson;
+
+        static const char str[] = R"([0, -12, 1.5, -2e3, 18446744073709551615, 18446744073709551616,)"
+            R"( -9223372036854775808, -9223372036854775809, "1", 1E2])";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        auto kind = [parser](std::size_t idx) { return iter_at(idx, parser).number_kind(); };
+        assert(kind(0) == (FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_FITS_64));
+        assert(kind(1) == (FJ_FLAG_NUM_NEGATIVE | FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_FITS_64));
+        assert(kind(2) == 0);
+        assert(kind(3) == FJ_FLAG_NUM_NEGATIVE);
+        assert(kind(4) == (FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_FITS_64));
+        assert(kind(5) == FJ_FLAG_NUM_INTEGER);
+        assert(kind(6) == (FJ_FLAG_NUM_NEGATIVE | FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_FITS_64));
+        assert(kind(7) == (FJ_FLAG_NUM_NEGATIVE | FJ_FLAG_NUM_INTEGER));
+        assert(kind(8) == 0 && !iter_at(8, parser).is_integer());
+        assert(kind(9) == 0);
+        assert(iter_at(1, parser).is_integer() && iter_at(1, parser).is_negative());
+
+        // the integer conversions are rejected by the flags
+        std::uint64_t u = 7;
+        std::int64_t i = 7;
+        assert(iter_at(1, parser).try_to(u) == FJ_EC_NOT_CONVERTIBLE && u == 7);
+        assert(iter_at(2, parser).try_to(i) == FJ_EC_NOT_CONVERTIBLE && i == 7);
+        assert(iter_at(4, parser).try_to(u) == FJ_EC_OK && u == UINT64_MAX);
+        assert(iter_at(5, parser).try_to(u) == FJ_EC_VALUE_OVERFLOW);
+        assert(iter_at(6, parser).try_to(i) == FJ_EC_OK && i == INT64_MIN);
+        assert(iter_at(7, parser).try_to(i) == FJ_EC_VALUE_OVERFLOW);
+
+        // the hex limits
+        const auto hex = FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_HEX;
+        const auto neg_hex = FJ_FLAG_NUM_NEGATIVE | hex;
+        assert(details::number_flags("0xffffffffffffffff", 18) == (hex | FJ_FLAG_NUM_FITS_64));
+        assert(details::number_flags("0x10000000000000000", 19) == hex);
+        assert(details::number_flags("-0x7fffffffffffffff", 19) == (neg_hex | FJ_FLAG_NUM_FITS_64));
+        assert(details::number_flags("-0x8000000000000000", 19) == (neg_hex | FJ_FLAG_NUM_FITS_64));
+        assert(details::number_flags("-0x8000000000000001", 19) == neg_hex);
+        assert(details::number_flags("-0xA000000000000000", 19) == neg_hex);
+
+        // the flags should survive the pack/unpack
+        auto size = packed_state_size(parser);
+        std::vector<char> packed(size);
+        assert(pack_state(packed.data(), size, parser) == size);
+        auto parser2 = init_parser();
+        assert(unpack_state(&parser2, packed.data(), size));
+        for ( auto idx = 0u; idx < static_cast<std::size_t>(parser->toks_end - parser->toks_beg); ++idx ) {
+            assert(parser->toks_beg[idx].flags == parser2.toks_beg[idx].flags);
+        }
+        free_parser(&parser2);
+        free_parser(parser);
+
+        // the root NUMBER
+        fjson json{"-0"};
+        assert(json.is_valid());
+        assert(json.number_kind() == (FJ_FLAG_NUM_NEGATIVE | FJ_FLAG_NUM_INTEGER | FJ_FLAG_NUM_FITS_64));
+    };
+
+    test += FJ_TEST(test for the struct binding) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"name":"tri\nangle", "unknown":{"a":[1,2]}, "fill":"green", "lvl":2,)"
+            R"( "points":[{"x":1,"y":2},{"y":4,"x":3,"z":0},{"x":5}], "weights":[0.5, 1, -2e1],)"
+            R"( "grid":[[1,2],[],[3]], "closed":true})";
+        fjson json{str};
+        assert(json.is_valid());
+
+        bound::shape sh{};
+        assert(json.bind_to(sh) == FJ_EC_OK);
+        assert(sh.name == "tri\nangle");
+        assert(sh.fill == bound::color::green);
+        assert(sh.lvl == bound::high);
+        assert(sh.points.size() == 3);
+        assert(sh.points[0].x == 1 && sh.points[0].y == 2);
+        assert(sh.points[1].x == 3 && sh.points[1].y == 4);
+        // the missing members are left unchanged
+        assert(sh.points[2].x == 5 && sh.points[2].y == 0);
+        assert(sh.weights.size() == 3 && sh.weights[0] == 0.5 && sh.weights[2] == -20.0);
+        assert(sh.grid.size() == 3 && sh.grid[0].size() == 2 && sh.grid[1].empty() && sh.grid[2][0] == 3);
+        assert(sh.closed);
+
+        // the errors are propagated
+        bound::point pt{};
+        fjson bad_type{R"({"x":1, "y":"2"})"};
+        assert(bad_type.bind_to(pt) == FJ_EC_NOT_CONVERTIBLE && pt.x == 1);
+        fjson bad_enum{R"({"fill":"black"})"};
+        assert(bad_enum.bind_to(sh) == FJ_EC_NOT_CONVERTIBLE);
+        fjson not_object{R"([1,2])"};
+        assert(not_object.bind_to(pt) == FJ_EC_NOT_CONVERTIBLE);
+        fjson overflow{R"({"x":1e3, "y":3000000000})"};
+        assert(overflow.bind_to(pt) == FJ_EC_NOT_CONVERTIBLE);
+        // the escaped keys are decoded
+        fjson escaped{R"({"\u0078":7, "y\u0000":8})"};
+        pt = bound::point{};
+        assert(escaped.bind_to(pt) == FJ_EC_OK && pt.x == 7 && pt.y == 0);
+
+        // the single value
+        std::vector<std::string> strs;
+        fjson arr{R"(["a", "b\u0041"])"};
+        assert(arr.bind_to(strs) == FJ_EC_OK && strs.size() == 2 && strs[1] == "bA");
+    };
+
+#ifndef _MSC_VER
+    test += FJ_TEST(test for the batched serialization to file descriptor) {
+        using namespace flatjson;
+
+        std::string str = "{\"arr\":[";
+        for ( auto idx = 0u; idx < 5000; ++idx ) {
+            str += idx ? ",{\"k\":" : "{\"k\":";
+            str += std::to_string(idx);
+            str += ",\"s\":\"v\"}";
+        }
+        str += "]}";
+        fjson json{str.c_str(), str.c_str() + str.size()};
+        assert(json.is_valid());
+
+        static const char *fname = "unit_batched.json";
+        for ( auto indent: {0u, 2u} ) {
+            auto fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+            assert(fd != -1);
+            int ec{};
+            auto beg = json.begin();
+            auto wr = serialize(fd, *beg, *json.end(), indent, &ec);
+            ::close(fd);
+            assert(ec == 0);
+
+            auto from_file = read_file(fname);
+            auto string = to_string(*beg, *json.end(), indent);
+            assert(wr == string.size());
+            assert(from_file == string);
+            if ( !indent ) {
+                assert(from_file == str);
+            }
+        }
+
+        // more vectors than IOV_MAX, including the empty ones
+        std::vector<std::string> parts;
+        std::vector<io_vector> vecs;
+        std::string expected;
+        for ( auto idx = 0u; idx < 3000; ++idx ) {
+            parts.push_back(idx % 3 ? std::to_string(idx) : std::string{});
+        }
+        for ( auto &it: parts ) {
+            expected += it;
+            io_vector v;
+            v.iov_base = &it[0];
+            v.iov_len = it.size();
+            vecs.push_back(v);
+        }
+        auto fd = ::open(fname, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+        assert(fd != -1);
+        int ec{};
+        assert(file_write_all(fd, vecs.data(), vecs.size(), &ec) && ec == 0);
+        ::close(fd);
+        assert(read_file(fname) == expected);
+        std::remove(fname);
+    };
+#endif // _MSC_VER
+
+    test += FJ_TEST(test for the serialization sinks) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a":[1,"x",{"b":null}],"c":{"d":true,"e":[]},"f":"g"})";
+        fjson json{str};
+        assert(json.is_valid());
+        auto beg = *json.begin();
+        auto end = *json.end();
+        const auto expected = to_string(beg, end);
+        assert(expected == str);
+        const auto expected4 = to_string(beg, end, 4);
+
+        // the user-defined sink
+        struct counting_sink {
+            std::string out;
+            std::size_t writes = 0;
+            bool flushed = false;
+            void write(const char *ptr, std::size_t len) { out.append(ptr, len); ++writes; }
+            void flush() { flushed = true; }
+            int error() const { return 0; }
+        };
+        counting_sink cs;
+        assert(serialize_to(cs, beg, end) == expected.size());
+        assert(cs.out == expected && cs.flushed);
+
+        std::string s;
+        string_sink ss{s};
+        assert(serialize_to(ss, beg, end, 4) == expected4.size() && s == expected4);
+
+        length_sink ls;
+        assert(serialize_to(ls, beg, end, 4) == expected4.size());
+
+        char buf[sizeof(str)];
+        buffer_sink bs{buf, sizeof(buf)};
+        assert(serialize_to(bs, beg, end) == expected.size() && bs.error() == 0);
+        assert(std::string(bs.data(), bs.size()) == expected);
+        buffer_sink small{buf, 10};
+        serialize_to(small, beg, end);
+        assert(small.error() == ENOBUFS && small.size() <= 10);
+        int ec{};
+        assert(serialize(beg, end, buf, 10, 0, &ec) == 0 && ec == ENOBUFS);
+
+        std::ostringstream os;
+        ostream_sink oss{os};
+        serialize_to(oss, beg, end, 4);
+        assert(oss.error() == 0 && os.str() == expected4);
+
+        // the deep nesting, more than the indentation string
+        std::string deep;
+        for ( auto idx = 0; idx < 30; ++idx ) { deep += "["; }
+        deep += "1";
+        for ( auto idx = 0; idx < 30; ++idx ) { deep += "]"; }
+        fjson djson{deep.c_str(), deep.c_str() + deep.size()};
+        assert(djson.is_valid());
+        std::string dout;
+        string_sink dss{dout};
+        serialize_to(dss, *djson.begin(), *djson.end(), 4);
+        assert(dout.find(std::string(30 * 4, ' ') + "1") != std::string::npos);
+    };
+
+    test += FJ_TEST(test for the serialization by the source spans) {
+        using namespace flatjson;
+
+        struct counting_sink {
+            std::string out;
+            std::size_t writes = 0;
+            void write(const char *ptr, std::size_t len) { out.append(ptr, len); ++writes; }
+            void flush() {}
+            int error() const { return 0; }
+        };
+
+        // the minified source is written by a single write()
+        static const char minified[] = R"([[1,"a"],{"b":[{"c":null}],"d\"e":-1.5},[],{},"x"])";
+        fjson json{minified};
+        assert(json.is_valid());
+        counting_sink cs;
+        assert(serialize_to(cs, *json.begin(), *json.end()) == sizeof(minified) - 1);
+        assert(cs.out == minified && cs.writes == 1);
+
+        // the subtree too
+        auto b = iter_at(pointer{"/1/b"}, *json.begin());
+        assert(b.is_valid());
+        counting_sink sub;
+        serialize_to(sub, b, b);
+        assert(sub.out == R"("b":[{"c":null}])" && sub.writes == 1);
+
+        // with the whitespaces the output is the same as before, by the runs between them
+        static const char spaced[] = R"({ "a": [ 1 , 2 ] , "b":{"c":"d","e":[true,false]} , "f": {} })";
+        fjson json2{spaced};
+        assert(json2.is_valid());
+        counting_sink cs2;
+        serialize_to(cs2, *json2.begin(), *json2.end());
+        assert(cs2.out == R"({"a":[1,2],"b":{"c":"d","e":[true,false]},"f":{}})");
+        assert(cs2.writes < 20);
+        assert(to_string(*json2.begin(), *json2.end()) == cs2.out);
+    };
+
+    test += FJ_TEST(test for the single-pass to_string()) {
+        using namespace flatjson;
+
+        std::string str = "{\"arr\":[";
+        for ( auto idx = 0u; idx < 2000; ++idx ) {
+            str += idx ? ", {\"k\": " : "{\"k\": ";
+            str += std::to_string(idx);
+            str += ", \"s\": [\"v\", null, {}]}";
+        }
+        str += "]}";
+        fjson json{str.c_str(), str.c_str() + str.size()};
+        assert(json.is_valid());
+
+        auto beg = *json.begin();
+        auto end = *json.end();
+        for ( auto indent: {0u, 1u, 4u} ) {
+            int ec{};
+            auto res = to_string(beg, end, indent, &ec);
+            assert(ec == 0);
+            assert(res.size() == length_for_string(beg, end, indent));
+            std::ostringstream os;
+            serialize(os, beg, end, indent);
+            assert(res == os.str());
+        }
+
+        // the string_sink appends to the existing content
+        std::string out = "prefix:";
+        string_sink sink{out};
+        serialize_to(sink, iter_at("arr", beg), iter_at("arr", beg));
+        assert(out.compare(0, 14, "prefix:\"arr\":[") == 0);
+        assert(out.size() == 7 + length_for_string(iter_at("arr", beg), iter_at("arr", beg)));
+
+        // the string is valid after each write(), without flush()
+        std::string direct;
+        string_sink dsink{direct};
+        dsink.write("ab", 2);
+        assert(direct == "ab");
+        dsink.write(str.data(), str.size());
+        assert(direct.size() == 2 + str.size() && direct.compare(2, str.size(), str) == 0);
+    };
+
+    test += FJ_TEST(test for the raw source spans) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a": [1, "x\ny", {"b": null}],"c":{},  "d":-2.5e3, "e":[ ]})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+
+        auto root = iter_begin(parser);
+        assert(root.raw() == str);
+        auto a = iter_at("a", parser);
+        assert(a.raw() == R"([1, "x\ny", {"b": null}])");
+        assert(iter_at(1, a).raw() == R"("x\ny")");
+        assert(iter_at(1, a).value() == "x\\ny");
+        assert(iter_at(2, a).raw() == R"({"b": null})");
+        assert(iter_at("c", parser).raw() == "{}");
+        assert(iter_at("d", parser).raw() == "-2.5e3");
+        assert(iter_at("e", parser).raw() == "[ ]");
+
+        // the positions should survive the pack/unpack
+        auto size = packed_state_size(parser);
+        std::vector<char> packed(size);
+        assert(pack_state(packed.data(), size, parser) == size);
+        auto parser2 = init_parser();
+        assert(unpack_state(&parser2, packed.data(), size));
+        auto a2 = iter_at("a", &parser2);
+        assert(a2.raw() == R"([1, "x\ny", {"b": null}])");
+        assert(iter_begin(&parser2).raw() == str);
+        free_parser(&parser2);
+        free_parser(parser);
+
+        // the leading whitespaces
+        {
+            static const char str2[] = "  {\"a\":[1,2]}";
+            auto *p = alloc_parser(str2);
+            parse(p);
+            assert(is_valid(p));
+            auto size2 = packed_state_size(p);
+            std::vector<char> packed2(size2);
+            assert(pack_state(packed2.data(), size2, p) == size2);
+            auto p2 = init_parser();
+            assert(unpack_state(&p2, packed2.data(), size2));
+            assert(iter_begin(&p2).raw() == R"({"a":[1,2]})");
+            assert(iter_at("a", &p2).raw() == "[1,2]");
+            assert(to_string(iter_begin(&p2), iter_end(&p2)) == R"({"a":[1,2]})");
+            free_parser(&p2);
+            free_parser(p);
+        }
+
+        fjson json{R"([{"k":[true]}, 2])"};
+        assert(json.raw_json() == R"([{"k":[true]}, 2])");
+        assert(json[0].raw_json() == R"({"k":[true]})");
+        assert(json[0]["k"].raw_json() == "[true]");
+    };
+
+    test += FJ_TEST(test for the JSON writer) {
+        using namespace flatjson;
+
+        static const char src[] = R"({"sub":{"x":[1,2,{"y":"z"}]},"s":"q\"w"})";
+        fjson doc{src};
+        assert(doc.is_valid());
+
+        std::string out;
+        string_sink sink{out};
+        {
+            // the small buffer to check the flushing
+            writer<string_sink> w{sink, 16};
+            w.begin_object()
+                .member("null", nullptr)
+                .member("t", true)
+                .member("f", false)
+                .member("i", -42)
+                .member("min", (std::numeric_limits<std::int64_t>::min)())
+                .member("max", (std::numeric_limits<std::uint64_t>::max)())
+                .member("d", 0.1)
+                .member("fl", 1.5f)
+                .member("nan", std::numeric_limits<double>::quiet_NaN())
+                .member("str", "a\"b\\c\n\x01 long enough for the SWAR path \xd0\xb6")
+                .key("k\"ey").begin_array()
+                    .value(1).value("x").begin_object().end_object().begin_array().end_array()
+                .end_array()
+                .key("sub").raw(iter_at("sub", *doc.begin()))
+                .key("s").raw_json(doc["s"].raw_json())
+                .key("json").raw_json(string_view{"[1, 2]", 6})
+            .end_object();
+            assert(w.depth() == 0);
+            w.flush();
+            assert(w.size() == out.size());
+        }
+
+        fjson json{out.c_str(), out.c_str() + out.size()};
+        assert(json.is_valid());
+        assert(json["null"].is_null());
+        assert(json["t"].to_bool() && !json["f"].to_bool());
+        assert(json["i"].to_int() == -42);
+        std::int64_t min{};
+        assert(json["min"].try_to(min) == FJ_EC_OK && min == (std::numeric_limits<std::int64_t>::min)());
+        assert(json["max"].to_uint64() == (std::numeric_limits<std::uint64_t>::max)());
+        assert(json["d"].to_string() == "0.1");
+        assert(json["fl"].to_string() == "1.5");
+        assert(json["nan"].is_null());
+        std::string decoded;
+        assert(unescape_to(iter_at("str", *json.begin()), decoded) == "a\"b\\c\n\x01 long enough for the SWAR path \xd0\xb6");
+        assert(json["str"].to_string().find("\\u0001") != std::string::npos);
+        assert(json["k\\\"ey"].size() == 4);
+        assert(json["sub"].raw_json() == R"({"x":[1,2,{"y":"z"}]})");
+        assert(json["s"].raw_json() == R"("q\"w")");
+        assert(json["json"].raw_json() == "[1, 2]");
+
+        // the doubles are written by the shortest round-trip precision
+        std::uint64_t seed = 12345;
+        for ( auto idx = 0; idx < 10000; ++idx ) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            double v;
+            std::uint64_t bits = seed;
+            std::memcpy(&v, &bits, sizeof(v));
+            if ( v != v || v == std::numeric_limits<double>::infinity() || v == -std::numeric_limits<double>::infinity() ) {
+                continue;
+            }
+            std::string num;
+            string_sink ns{num};
+            writer<string_sink> nw{ns};
+            nw.value(v);
+            nw.flush();
+            assert(std::strtod(num.c_str(), nullptr) == v);
+        }
+
+        // the shortest digits, the closest ones to the value of them
+        const auto fmt = [](double v) {
+            char buf[32];
+            return std::string(buf, details::format_float(buf, v));
+        };
+        const auto fmtf = [](float v) {
+            char buf[32];
+            return std::string(buf, details::format_float(buf, v));
+        };
+        assert(fmt(5e-324) == "5e-324");
+        assert(fmt(-5e-324) == "-5e-324");
+        assert(fmt(2.225073858507201e-308) == "2.225073858507201e-308");
+        assert(fmt(1.7976931348623157e308) == "1.7976931348623157e+308");
+        assert(fmt(0.30000000000000004) == "0.30000000000000004");
+        assert(fmt(1e23) == "1e+23");
+        assert(fmt(9007199254740993.0) == "9007199254740992");
+        assert(fmt(1e-7) == "1e-7");
+        assert(fmt(0.000001) == "0.000001");
+        assert(fmt(-0.0) == "-0");
+        assert(fmtf(0.1f) == "0.1");
+        assert(fmtf(1e-45f) == "1e-45");
+        assert(fmtf(3.4028235e38f) == "3.4028235e+38");
+        assert(fmtf(16777216.f) == "16777216");
+        for ( auto idx = 0; idx < 10000; ++idx ) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            float v;
+            auto bits = static_cast<std::uint32_t>(seed >> 32);
+            std::memcpy(&v, &bits, sizeof(v));
+            if ( v != v || v == std::numeric_limits<float>::infinity() || v == -std::numeric_limits<float>::infinity() ) {
+                continue;
+            }
+            assert(std::strtof(fmtf(v).c_str(), nullptr) == v);
+        }
+    };
+
+    test += FJ_TEST(test for the mutable overlay) {
+        using namespace flatjson;
+
+        static const char str[] = R"({"a":1, "b":{"c":[1,2,3], "d":"x"}, "e":[{"f":null}], "g":"keep me"})";
+        auto *parser = alloc_parser(str);
+        parse(parser);
+        assert(is_valid(parser));
+        auto root = iter_begin(parser);
+
+        {
+            overlay ov{root};
+            assert(ov.empty());
+            // without the edits the source is copied as is
+            assert(ov.to_string() == str);
+        }
+        {
+            overlay ov{root};
+            assert(ov.set(iter_at("a", parser), string_view{"2"}));
+            assert(ov.set(iter_at("a", parser), string_view{R"("two")"})); // the last one wins
+            assert(ov.erase(pointer{"/b/c/1"}));
+            assert(ov.append(pointer{"/b/c"}, string_view{"4"}));
+            assert(ov.append(pointer{"/b/c"}, string_view{"[5]"}));
+            assert(ov.insert(pointer{"/b"}, string_view{"n\"ew"}, string_view{"true"}));
+            assert(ov.insert(pointer{"/b"}, string_view{"d"}, string_view{R"("y")"})); // the existing key is replaced
+            assert(ov.set(pointer{"/e/0/f"}, string_view{"{}"}));
+            assert(!ov.erase(root));
+            assert(!ov.append(iter_at("a", parser), string_view{"1"}));
+            assert(!ov.set(pointer{"/nope"}, string_view{"1"}));
+
+            const auto res = ov.to_string();
+            assert(res == R"({"a":"two","b":{"c":[1,3,4,[5]],"d":"y","n\"ew":true},"e":[{"f":{}}],"g":"keep me"})");
+
+            // the document is not changed
+            assert(iter_at("a", parser).to_int() == 1);
+            std::string same;
+            string_sink ss{same};
+            serialize_to(ss, root, iter_end(parser));
+            assert(same == R"({"a":1,"b":{"c":[1,2,3],"d":"x"},"e":[{"f":null}],"g":"keep me"})");
+
+            fjson json{res.c_str(), res.c_str() + res.size()};
+            assert(json.is_valid());
+        }
+        {
+            // the empty containers, the erasing of all the members, the erased key added again
+            static const char str2[] = R"({"x":[],"y":{},"z":[1]})";
+            fjson json{str2};
+            overlay ov{*json.begin()};
+            ov.append(pointer{"/x"}, string_view{"1"});
+            ov.insert(pointer{"/y"}, string_view{"k"}, string_view{"[]"});
+            ov.erase(pointer{"/z/0"});
+            assert(ov.to_string() == R"({"x":[1],"y":{"k":[]},"z":[]})");
+            ov.erase(pointer{"/x"});
+            ov.insert(*json.begin(), string_view{"x"}, string_view{"0"});
+            assert(ov.to_string() == R"({"y":{"k":[]},"z":[],"x":0})");
+            // the root is replaced
+            ov.set(*json.begin(), string_view{"null"});
+            assert(ov.to_string() == "null");
+        }
+        {
+            // the members added earlier are replaced, not duplicated
+            fjson json{R"({"a":1})"};
+            overlay ov{*json.begin()};
+            ov.insert(*json.begin(), string_view{"n"}, string_view{"1"});
+            ov.insert(*json.begin(), string_view{"n"}, string_view{"2"});
+            ov.insert(*json.begin(), string_view{"a"}, string_view{"3"});
+            assert(ov.to_string() == R"({"a":3,"n":2})");
+            ov.erase(pointer{"/a"});
+            ov.insert(*json.begin(), string_view{"a"}, string_view{"5"});
+            ov.insert(*json.begin(), string_view{"a"}, string_view{"6"});
+            assert(ov.to_string() == R"({"n":2,"a":6})");
+        }
+
+        free_parser(parser);
+    };
+
+    test += FJ_TEST(test for JSON Patch and JSON Merge Patch) {
+        using namespace flatjson;
+
+        const auto merged = [](const char *target, const char *patch) {
+            fjson tjson{target, target + std::strlen(target)};
+            fjson pjson{patch, patch + std::strlen(patch)};
+            assert(tjson.is_valid() && pjson.is_valid());
+            std::string res;
+            string_sink sink{res};
+            const auto len = merge_patch(*tjson.begin(), *pjson.begin(), sink);
+            assert(len == res.size());
+
+            return res;
+        };
+        // RFC 7386, appendix A
+        assert(merged(R"({"a":"b"})", R"({"a":"c"})") == R"({"a":"c"})");
+        assert(merged(R"({"a":"b"})", R"({"b":"c"})") == R"({"a":"b","b":"c"})");
+        assert(merged(R"({"a":"b"})", R"({"a":null})") == R"({})");
+        assert(merged(R"({"a":"b","b":"c"})", R"({"a":null})") == R"({"b":"c"})");
+        assert(merged(R"({"a":["b"]})", R"({"a":"c"})") == R"({"a":"c"})");
+        assert(merged(R"({"a":"c"})", R"({"a":["b"]})") == R"({"a":["b"]})");
+        assert(merged(R"({"a":{"b":"c"}})", R"({"a":{"b":"d","c":null}})") == R"({"a":{"b":"d"}})");
+        assert(merged(R"({"a":[{"b":"c"}]})", R"({"a":[1]})") == R"({"a":[1]})");
+        assert(merged(R"(["a","b"])", R"(["c","d"])") == R"(["c","d"])");
+        assert(merged(R"({"a":"b"})", R"(["c"])") == R"(["c"])");
+        assert(merged(R"({"a":"foo"})", "null") == "null");
+        assert(merged(R"({"a":"foo"})", R"("bar")") == R"("bar")");
+        assert(merged(R"({"e":null})", R"({"a":1})") == R"({"e":null,"a":1})");
+        assert(merged(R"([1,2])", R"({"a":"b","c":null})") == R"({"a":"b"})");
+        assert(merged(R"({})", R"({"a":{"bb":{"ccc":null}}})") == R"({"a":{"bb":{}}})");
+        // the unchanged members are copied with the whitespaces, the escaped keys are matched
+        assert(merged(R"({"x": 1, "y": [1, 2], "z":3, "k1":0})", R"({"z":4,"k1":5})")
+            == R"({"x": 1, "y": [1, 2],"z":4,"k1":5})");
+
+        const auto patched = [](const char *target, const char *patch, std::string &res) {
+            fjson tjson{target, target + std::strlen(target)};
+            fjson pjson{patch, patch + std::strlen(patch)};
+            assert(tjson.is_valid() && pjson.is_valid());
+            res.clear();
+            string_sink sink{res};
+            const auto ec = apply_patch(*tjson.begin(), *pjson.begin(), sink);
+            sink.flush();
+
+            return ec;
+        };
+        std::string res;
+        // RFC 6902, appendix A
+        assert(!patched(R"({"foo":"bar"})", R"([{"op":"add","path":"/baz","value":"qux"}])", res));
+        assert(res == R"({"foo":"bar","baz":"qux"})");
+        assert(!patched(R"({"foo":["bar","baz"]})", R"([{"op":"add","path":"/foo/1","value":"qux"}])", res));
+        assert(res == R"({"foo":["bar","qux","baz"]})");
+        assert(!patched(R"({"baz":"qux","foo":"bar"})", R"([{"op":"remove","path":"/baz"}])", res));
+        assert(res == R"({"foo":"bar"})");
+        assert(!patched(R"({"foo":["bar","qux","baz"]})", R"([{"op":"remove","path":"/foo/1"}])", res));
+        assert(res == R"({"foo":["bar","baz"]})");
+        assert(!patched(R"({"baz":"qux","foo":"bar"})", R"([{"op":"replace","path":"/baz","value":"boo"}])", res));
+        assert(res == R"({"baz":"boo","foo":"bar"})");
+        assert(!patched(
+             R"({"foo":{"bar":"baz","waldo":"fred"},"qux":{"corge":"grault"}})"
+            ,R"([{"op":"move","from":"/foo/waldo","path":"/qux/thud"}])", res));
+        assert(res == R"({"foo":{"bar":"baz"},"qux":{"corge":"grault","thud":"fred"}})");
+        assert(!patched(R"({"foo":["all","grass","cows","eat"]})", R"([{"op":"move","from":"/foo/1","path":"/foo/3"}])", res));
+        assert(res == R"({"foo":["all","cows","eat","grass"]})");
+        assert(!patched(
+             R"({"baz":"qux","foo":["a",2,"c"]})"
+            ,R"([{"op":"test","path":"/baz","value":"qux"},{"op":"test","path":"/foo/1","value":2.0}])", res));
+        assert(patched(R"({"baz":"qux"})", R"([{"op":"test","path":"/baz","value":"bar"}])", res) == FJ_EC_TEST_FAILED);
+        assert(res.empty());
+        assert(!patched(R"({"foo":"bar"})", R"([{"op":"add","path":"/child","value":{"grandchild":{}}}])", res));
+        assert(res == R"({"foo":"bar","child":{"grandchild":{}}})");
+        assert(patched(R"({"foo":"bar"})", R"([{"op":"add","path":"/baz/bat","value":"qux"}])", res) == FJ_EC_NOT_FOUND);
+        assert(!patched(R"({"/":9,"~1":10})", R"([{"op":"test","path":"/~01","value":10}])", res));
+        assert(!patched(R"({"foo":["bar"]})", R"([{"op":"add","path":"/foo/-","value":["abc","def"]}])", res));
+        assert(res == R"({"foo":["bar",["abc","def"]]})");
+        assert(patched(R"({"foo":1})", R"([{"op":"jump","path":"/foo"}])", res) == FJ_EC_INVALID);
+        assert(patched(R"({"foo":[1]})", R"([{"op":"add","path":"/foo/2","value":0}])", res) == FJ_EC_INVALID);
+        assert(patched(R"({"a":{"b":1}})", R"([{"op":"move","from":"/a","path":"/a/c"}])", res) == FJ_EC_INVALID);
+        assert(patched(R"({"a":1})", R"([{"op":"remove","path":""}])", res) == FJ_EC_INVALID);
+        // the objects are equal in any order
+        assert(!patched(R"({"a":{"x":1,"y":"A"}})", R"([{"op":"test","path":"/a","value":{"y":"A","x":1}}])", res));
+
+        // the operations over the results of the earlier ones
+        assert(!patched(R"({"a":[1,2,3,4]})", R"([
+            {"op":"remove","path":"/a/0"},
+            {"op":"remove","path":"/a/0"},
+            {"op":"add","path":"/a/1","value":5},
+            {"op":"add","path":"/b","value":{}},
+            {"op":"add","path":"/b/c","value":[]},
+            {"op":"copy","from":"/a","path":"/b/c/0"},
+            {"op":"replace","path":"/a/0","value":0},
+            {"op":"replace","path":"/a/0","value":-1},
+            {"op":"test","path":"/b/c/0/1","value":5}
+        ])", res));
+        assert(res == R"({"a":[-1,5,4],"b":{"c":[[3,5,4]]}})");
+        // the root is replaced
+        assert(!patched(R"({"a":1})", R"([{"op":"replace","path":"","value":[1]},{"op":"add","path":"/0","value":0}])", res));
+        assert(res == "[0,1]");
+        // the second add into the same object, the elements inserted before the added ones
+        assert(!patched(R"({"a":{}, "b":[1, 2]})", R"([
+            {"op":"add","path":"/a/x","value":1},
+            {"op":"add","path":"/a/y","value":2},
+            {"op":"add","path":"/a/x","value":3},
+            {"op":"add","path":"/b/0","value":"p"},
+            {"op":"add","path":"/b/0","value":"q"},
+            {"op":"add","path":"/b/1","value":"r"},
+            {"op":"add","path":"/b/-","value":"s"},
+            {"op":"add","path":"/b/5","value":"t"},
+            {"op":"remove","path":"/b/3"},
+            {"op":"test","path":"/b","value":["q","r","p",2,"t","s"]}
+        ])", res));
+        assert(res == R"({"a":{"x":3,"y":2},"b":["q","r","p",2,"t","s"]})");
+        // under the shifted array, the unchanged values are copied with the whitespaces
+        assert(!patched(R"({"a":[{"x":1}, {"x":2, "y": [3, 4], "z": [5, 6]}]})", R"([
+            {"op":"remove","path":"/a/0"},
+            {"op":"replace","path":"/a/0/x","value":5},
+            {"op":"move","from":"/a/0/y/0","path":"/a/0/y/-"}
+        ])", res));
+        assert(res == R"({"a":[{"x":5,"y":[4,3],"z":[5, 6]}]})");
+        // inside the added and the replaced values
+        assert(!patched(R"({"n":0})", R"([
+            {"op":"replace","path":"/n","value":{"a":[1]}},
+            {"op":"add","path":"/n/a/0","value":0},
+            {"op":"add","path":"/n/b","value":{}},
+            {"op":"add","path":"/n/b/c","value":1},
+            {"op":"remove","path":"/n/a/1"},
+            {"op":"test","path":"/n","value":{"b":{"c":1},"a":[0]}},
+            {"op":"copy","from":"/n/b","path":"/m"}
+        ])", res));
+        assert(res == R"({"n":{"a":[0],"b":{"c":1}},"m":{"c":1}})");
+        // the failed lookup after the edits
+        assert(patched(R"({"a":1})", R"([{"op":"add","path":"/b","value":1},{"op":"remove","path":"/c"}])", res) == FJ_EC_NOT_FOUND);
+        assert(patched(R"({"a":[1]})", R"([{"op":"remove","path":"/a/0"},{"op":"replace","path":"/a/0","value":1}])", res) == FJ_EC_NOT_FOUND);
+        assert(res.empty());
+    };
+
+    test += FJ_TEST(test for the structural diff) {
+        using namespace flatjson;
+
+        const auto diffed = [](const char *from, const char *to, std::size_t lcs_limit) {
+            fjson fjs{from, from + std::strlen(from)};
+            fjson tjs{to, to + std::strlen(to)};
+            assert(fjs.is_valid() && tjs.is_valid());
+            std::string res;
+            string_sink sink{res};
+            const auto len = diff(*fjs.begin(), *tjs.begin(), sink, lcs_limit);
+            assert(len == res.size());
+
+            // the patch turns `from` into `to`
+            fjson pjs{res.c_str(), res.c_str() + res.size()};
+            assert(pjs.is_valid());
+            std::string patched;
+            string_sink psink{patched};
+            assert(apply_patch(*fjs.begin(), *pjs.begin(), psink) == FJ_EC_OK);
+            fjson rjs{patched.c_str(), patched.c_str() + patched.size()};
+            assert(rjs.is_valid());
+            assert(details::json_equal(rjs.begin()->cur, tjs.begin()->cur));
+
+            return res;
+        };
+
+        assert(diffed(R"({"a":1})", R"({"a":1})", 16) == "[]");
+        // the equal values written differently
+        assert(diffed(R"({"a":1.0,"b":"A","c":{"x":1,"y":2}})", R"({"c":{"y":2,"x":1},"b":"A","a":1})", 16) == "[]");
+        assert(diffed("1", "2", 16) == R"([{"op":"replace","path":"","value":2}])");
+        assert(diffed(R"({"a":1,"b":[1,2],"c":"x"})", R"({"a":2,"c":"x","d":{"e":null}})", 16)
+            == R"([{"op":"replace","path":"/a","value":2},{"op":"remove","path":"/b"},{"op":"add","path":"/d","value":{"e":null}}])");
+        // the keys are escaped in the paths
+        assert(diffed(R"({"a/b":{"m~n":1}})", R"({"a/b":{"m~n":2}})", 16)
+            == R"([{"op":"replace","path":"/a~1b/m~0n","value":2}])");
+        // LCS: the inserted and removed elements only
+        assert(diffed("[1,2,3,4,5]", "[0,1,2,4,5,6]", 16)
+            == R"([{"op":"add","path":"/0","value":0},{"op":"remove","path":"/3"},{"op":"add","path":"/5","value":6}])");
+        // the changed element is diffed in place
+        assert(diffed(R"([{"id":1,"v":"a"},{"id":2,"v":"b"}])", R"([{"id":1,"v":"a"},{"id":2,"v":"c"}])", 16)
+            == R"([{"op":"replace","path":"/1/v","value":"c"}])");
+        assert(diffed(R"(["a","b","c"])", R"(["c","x","y","z"])", 16)
+            == R"([{"op":"remove","path":"/0"},{"op":"remove","path":"/0"},{"op":"add","path":"/1","value":"x"},)"
+               R"({"op":"add","path":"/2","value":"y"},{"op":"add","path":"/3","value":"z"}])");
+        // positional: the larger arrays
+        assert(diffed("[1,2,3,4,5]", "[0,1,2,4,5,6]", 2)
+            == R"([{"op":"replace","path":"/0","value":0},{"op":"replace","path":"/1","value":1},{"op":"replace","path":"/2","value":2},)"
+               R"({"op":"add","path":"/5","value":6}])");
+        assert(diffed("[1,2,3,4,5]", "[1,2]", 0)
+            == R"([{"op":"remove","path":"/4"},{"op":"remove","path":"/3"},{"op":"remove","path":"/2"}])");
+        // the mixed nesting
+        diffed(
+             R"({"users":[{"id":1,"tags":["a","b"]},{"id":2,"tags":[]},{"id":3}],"meta":{"v":1,"old":true}})"
+            ,R"({"users":[{"id":2,"tags":["x"]},{"id":3,"name":"c"},{"id":4}],"meta":{"v":2},"new":[1,[2]]})"
+            ,16
+        );
+        diffed(
+             R"({"users":[{"id":1,"tags":["a","b"]},{"id":2,"tags":[]},{"id":3}],"meta":{"v":1,"old":true}})"
+            ,R"({"users":[{"id":2,"tags":["x"]},{"id":3,"name":"c"},{"id":4}],"meta":{"v":2},"new":[1,[2]]})"
+            ,0
+        );
+        diffed(R"([[1,2],[3,4],5])", R"([5,[3,4,5],[1,2]])", 16);
+    };
+
+    test += FJ_TEST(test for the canonical output) {
+        using namespace flatjson;
+
+        const auto canon = [](const char *str) {
+            fjson json{str, str + std::strlen(str)};
+            assert(json.is_valid());
+
+            return json.to_canonical();
+        };
+
+        assert(canon(R"({"b":1,"a":2})") == R"({"a":2,"b":1})");
+        // the nested objects are sorted, the arrays are not
+        assert(canon(R"({"z":[3,1,{"y":null,"x":true}], "a":{"d":"", "c":{}}})")
+            == R"({"a":{"c":{},"d":""},"z":[3,1,{"x":true,"y":null}]})");
+        // by the bytes of the decoded keys, the prefix goes first
+        assert(canon(R"({"ab":1,"a":2,"A":3,"b\n":4,"B":5})") == "{\"A\":3,\"B\":5,\"a\":2,\"ab\":1,\"b\\n\":4}");
+        // the duplicated keys are kept in the source order
+        assert(canon(R"({"k":2,"a":0,"k":1})") == R"({"a":0,"k":2,"k":1})");
+        // the minimal escaping
+        assert(canon(R"(["a\/\t\u001f\"\\é"])") == "[\"a/\\t\\u001f\\\"\\\\\xc3\xa9\"]");
+        // the numbers
+        assert(canon("[1.0,-0,-0.0,1e2,100,0.1,1.5e-7,18446744073709551615,-9223372036854775808,12.50]")
+            == "[1,0,0,100,100,0.1,1.5e-7,18446744073709551615,-9223372036854775808,12.5]");
+        // one form per value
+        assert(canon("[1e15,1000000000000000,1E+15,1e15]") == "[1000000000000000,1000000000000000,1000000000000000,1000000000000000]");
+        assert(canon("[1e19,10000000000000000000]") == "[10000000000000000000,10000000000000000000]");
+        assert(canon("[-9.223372036854775808e18,-9223372036854775808]") == "[-9223372036854775808,-9223372036854775808]");
+        assert(canon("[123456789012345678901234567890,1.2345678901234568e29]") == "[1.2345678901234568e+29,1.2345678901234568e+29]");
+        assert(canon("[36893488147419103232,3.6893488147419103232e19]") == "[36893488147419103000,36893488147419103000]");
+        assert(canon("[0.000001,1e-7,-2.5e-8,1e21,1.5e300,0.30000000000000004,5e-324]")
+            == "[0.000001,1e-7,-2.5e-8,1e+21,1.5e+300,0.30000000000000004,5e-324]");
+        // out of the double range, normalized by the text
+        assert(canon("[1e400,1E400,10e399,1.0e+400,0.0100e402,-1e400,-0.00123450E+403]")
+            == "[1e+400,1e+400,1e+400,1e+400,1e+400,-1e+400,-1.2345e+400]");
+        assert(canon("[12.3400e99999999999999999999,1234e99999999999999999997,0.0001e100000000000000000003]")
+            == "[1.234e+100000000000000000000,1.234e+100000000000000000000,1e+99999999999999999999]");
+        assert(canon("[0.0e400,0.000e99999999999999999999,1e-400]") == "[0,0,0]");
+        // the equal documents are written by the same bytes
+        assert(canon(R"({"x": [1, 2.0], "y": {"b": "é", "a": 1e0}})") == canon(R"({"y":{"a":1,"b":"é"},"x":[1.0,2]})"));
+        assert(canon("null") == "null");
+        assert(canon(R"("s")") == R"("s")");
+
+        std::string res;
+        string_sink sink{res};
+        fjson json{R"({"b":[],"a":{}})"};
+        const auto len = canonical_to(sink, *json.begin());
+        assert(len == res.size() && res == R"({"a":{},"b":[]})");
+    };
+
     /*********************************************************************************************/
 
     test.run();